@@ -0,0 +1,251 @@
+#include <applications/ApplicationClient.hpp>
+
+#include <iostream>
+#include <string>
+#include <cerrno>                          // errno
+#include <cstring>                         // std::strerror(), std::memset()
+#include <boost/program_options.hpp>       // variable_map, options_descriptions
+#include <unistd.h>                        // close()
+#include <sys/socket.h>                    // socket(), connect(), shutdown()
+#include <sys/un.h>                        // sockaddr_un
+
+#include <ngsaipp/io/bed_io.hpp>                    // ngsai::BedReader, ngsai::BedRecord
+#include <ngsaipp/genome/constants.hpp>             // ngsai::genome::strand
+#include <applications/SocketBuffer.hpp>            // ngsai::app::SocketBuffer
+
+
+namespace po = boost::program_options ;
+
+
+ngsai::app::ApplicationClient::ApplicationClient(
+                        int argc,
+                        char** argv)
+    : ApplicationInterface(argc, argv),
+      m_path_socket(""),
+      m_path_bed("")
+{   int parsing = this->parseOptions() ;
+    if(parsing == this->getExitCodeSuccess())
+    {   m_is_runnable = true ; }
+    else
+    {   m_is_runnable = false ; }
+}
+
+
+ngsai::app::ApplicationClient::~ApplicationClient()
+{ ; }
+
+
+int
+ngsai::app::ApplicationClient::run()
+{   
+    if(not this->isRunnable())
+    {   return this->getExitCodeError() ; }
+
+    // connect
+    struct sockaddr_un address ;
+    std::memset(&address, 0, sizeof(address)) ;
+    address.sun_family = AF_UNIX ;
+    m_path_socket.copy(address.sun_path, 
+                       sizeof(address.sun_path) - 1) ;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0) ;
+    if((fd < 0) or
+       (connect(fd, 
+                reinterpret_cast<struct sockaddr*>(&address),
+                sizeof(address)) != 0))
+    {   std::cerr << "Error! could not connect to "
+                  << m_path_socket << " : "
+                  << std::strerror(errno)
+                  << std::endl ;
+        if(fd >= 0)
+        {   close(fd) ; }
+        return this->getExitCodeError() ;
+    }
+
+    int exit_code = this->getExitCodeSuccess() ;
+    {   ngsai::app::SocketBuffer buffer(fd) ;
+        std::iostream stream(&buffer) ;
+
+        // send the request and signal its end
+        if(this->sendBed(stream) != 
+                this->getExitCodeSuccess())
+        {   close(fd) ;
+            return this->getExitCodeError() ;
+        }
+        shutdown(fd, SHUT_WR) ;
+
+        // forward the predictions, the reply must end 
+        // with the number of CpGs predicted, otherwise 
+        // the server stopped before its end
+        std::string line ;
+        size_t n_pred = 0 ;
+        bool   done   = false ;
+        bool   failed = false ;
+        while(std::getline(stream, line))
+        {   if(line.compare(0, 7, "# error") == 0)
+            {   std::cerr << "Error! the server replied : "
+                          << line << std::endl ;
+                failed = true ;
+                continue ;
+            }
+            else if(line.compare(0, 7, "# done ") == 0)
+            {   done = (line.substr(7) == 
+                            std::to_string(n_pred)) ;
+                if(not done)
+                {   std::cerr << "Error! the server announced "
+                              << line.substr(7) 
+                              << " predictions but sent "
+                              << n_pred << std::endl ;
+                    failed = true ;
+                }
+                continue ;
+            }
+            std::cout << line << '\n' ;
+            n_pred++ ;
+        }
+        if(buffer.hasFailed())
+        {   std::cerr << "Error! could not read the reply of "
+                         "the server : "
+                      << std::strerror(buffer.getErrno())
+                      << std::endl ;
+            failed = true ;
+        }
+        else if((not done) and (not failed))
+        {   std::cerr << "Error! the reply of the server is "
+                         "incomplete"
+                      << std::endl ;
+            failed = true ;
+        }
+        if(failed)
+        {   exit_code = this->getExitCodeError() ; }
+        std::cout.flush() ;
+    }
+    close(fd) ;
+
+    return exit_code ;
+}
+
+
+int
+ngsai::app::ApplicationClient::parseOptions()
+{
+    // check arguments were given
+    if(m_argc == 1)
+    {   std::cerr << "Error ! no options given"
+                  << std::endl ; 
+        return this->getExitCodeError() ;
+    }
+
+    // help messages
+    std::string desc_msg =  "\n"
+                            "Usage : client [options] > [FILE]"
+                            "\n"
+                            "\tSends the CpGs of a BED file to a server\n"
+                            "\tstarted with the serve command and returns\n"
+                            "\tthe predictions on stdout in BED 6 format,\n"
+                            "\tlike predict.\n\n" ;
+    std::string opt_help_msg   = "Produces this help message." ;
+    std::string opt_socket_msg = "The path to the UNIX socket the server\n"
+                                 "listens on." ;
+    std::string opt_bed_msg    = "The path to a bed file containing the\n" 
+                                 "coordinates of the CpGs interest.";
+
+    // option parser
+    std::string path_socket("") ;
+    std::string path_bed("") ;
+
+    po::variables_map vm ;
+    po::options_description desc(desc_msg) ;
+    desc.add_options()
+        ("help,h",      opt_help_msg.c_str())
+        ("socket",      po::value<std::string>(&(path_socket)), 
+                        opt_socket_msg.c_str())
+        ("bed",         po::value<std::string>(&(path_bed)), 
+                        opt_bed_msg.c_str()) ;
+    
+    // parse
+    try
+    {   po::store(po::parse_command_line(m_argc, 
+                                         m_argv, 
+                                         desc), vm) ;
+        po::notify(vm) ;
+    }
+    catch(std::invalid_argument& e)
+    {   std::string msg = std::string("Error! Invalid "
+                                      "option given\n") + 
+                          std::string(e.what()) ;
+        return this->getExitCodeError() ;
+    }
+    catch(...)
+    {   std::cerr << "Error! an unknown error occured "
+                     "while parsing the options" 
+                  << std::endl ; 
+        return this->getExitCodeError() ;
+    }
+
+    // display help if needed
+    bool help = vm.count("help") ;
+    if(help)
+    {   std::cout << desc << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    // check options
+    if(path_socket == "")
+    {   std::cerr <<"Error! no socket given (--socket)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(path_socket.size() >= 
+                sizeof(sockaddr_un::sun_path))
+    {   std::cerr <<"Error! socket path is too long "
+                    "(--socket)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(path_bed == "")
+    {   std::cerr <<"Error! no bed file given (--bed)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    m_path_socket = path_socket ;
+    m_path_bed    = path_bed ;
+
+    return this->getExitCodeSuccess() ;
+}
+
+
+int 
+ngsai::app::ApplicationClient::sendBed(
+                            std::ostream& stream) const
+{   
+   try
+    {   ngsai::BedRecord bed_record ;
+        ngsai::BedReader bed_reader(m_path_bed) ;
+        while(bed_reader.getNext(bed_record))
+        {   // only keep fw strand since rv have same coords 
+            if(bed_record.strand != 
+                    ngsai::genome::strand::FORWARD)
+            {   continue ; }
+
+            stream << bed_record.chrom << '\t'
+                   << bed_record.start << '\t'
+                   << bed_record.end   << '\n' ;
+        }
+    }
+    catch(const std::exception& e)
+    {   std::cerr << "Error! could not load BED regions:"
+                  << std::endl 
+                  << e.what() << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    stream.flush() ;
+    if(not stream)
+    {   std::cerr << "Error! could not send the CpGs to "
+                     "the server"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    return this->getExitCodeSuccess() ;
+}
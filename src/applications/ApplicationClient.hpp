@@ -0,0 +1,86 @@
+#ifndef NGSAI_APP_APPLICATIONCLIENT_HPP
+#define NGSAI_APP_APPLICATIONCLIENT_HPP
+
+#include <applications/ApplicationInterface.hpp>
+
+#include <string>
+
+
+namespace ngsai
+{
+    namespace app
+    {   
+        /*!
+        * \brief The ApplicationClient class creates a 
+        * standalone application that sends the CpGs of 
+        * a BED file to a server started with the serve 
+        * command and writes the predictions on stdout, 
+        * like predict does. The run fails if the server 
+        * replies with an error or if its reply does not 
+        * end with the "# done <n>" line.
+        */
+        class ApplicationClient : 
+            public ngsai::app::ApplicationInterface
+        {   
+            public:
+                /*!
+                * \brief Constructor.
+                * Saves the argc and argv values and sets 
+                * the app as not runnable.
+                * \param argc the number of command line 
+                * argument.
+                * \param argv the command line argument 
+                * vector.
+                */
+                ApplicationClient(int argc, char** argv) ;
+
+                /*!
+                * \brief Destructor.
+                */
+                virtual 
+                ~ApplicationClient() override ;
+                
+                /*!
+                * \brief Runs the application, with all its
+                * functionalities.
+                * \return the exit code to return to the OS.
+                */
+                virtual 
+                int
+                run() override ;
+
+            protected:
+                /*!
+                 * \brief Parses the command line options 
+                 * and sets the fields.
+                 * \return an exit code, 
+                 * getExitCodeSuccess() if it went well.
+                 */
+                virtual
+                int
+                parseOptions() override ;
+
+                /*!
+                 * \brief Sends the forward strand CpGs of 
+                 * the BED file on the socket.
+                 * \param stream the stream writing on the 
+                 * socket.
+                 * \return an exit code, 
+                 * getExitCodeSuccess() if it went well.
+                 */
+                int
+                sendBed(std::ostream& stream) const ;
+
+            protected:
+                /*!
+                 * \brief the path to the server socket.
+                 */
+                std::string m_path_socket ;
+                /*!
+                 * \brief the path to the BED file.
+                 */
+                std::string m_path_bed ;
+        } ;
+    }
+}
+#endif // NGSAI_APP_APPLICATIONCLIENT_HPP
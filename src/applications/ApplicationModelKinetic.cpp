@@ -8,7 +8,16 @@
 #include <typeinfo>
 #include <fstream>
 #include <limits>
+#include <cmath>                                // std::isnan(), std::fabs()
 #include <thread>                               // std::thread
+#include <sstream>                              // std::ostringstream, std::istringstream
+#include <cstdio>                               // std::remove()
+#include <algorithm>                            // std::min(), std::max(), std::find(), std::sort(), std::remove_if(), std::max_element(), std::unique()
+#include <memory>                               // std::unique_ptr
+#include <utility>                              // std::pair, std::make_pair()
+#include <set>
+#include <array>
+#include <chrono>                               // std::chrono::steady_clock
 #include <boost/program_options.hpp>            // variable_map, options_descriptions
 #include <boost/archive/text_oarchive.hpp>                   // boost::archive::text_oarchive
 #include <boost/serialization/utility.hpp>                   // std::pair serialization
@@ -22,10 +31,160 @@
 #include <ngsaipp/epigenetics/PairWiseKineticModel.hpp>              // ngsai::PairWiseKineticModel
 #include <ngsaipp/epigenetics/PairWiseNormalizedKineticModel.hpp>    // ngsai::PairWiseNormalizedKineticModel
 #include <ngsaipp/epigenetics/model_utility.hpp>                     // train_KineticModdel()
-#include <ngsaipp/utility/string_utility.hpp>                        // ngsai::split()
-#include <ngsaipp/parallel/ThreadPool.hpp>                           // ngsai::ThreadPool::split_range()
+#include <ngsaipp/utility/string_utility.hpp>                        // ngsai::split(), ngsai::endswith()
+#include <applications/CheckpointLog.hpp>                            // ngsai::app::CheckpointLog
+#include <applications/BedBatchQueue.hpp>                            // ngsai::app::BedBatchQueue, ngsai::app::BedBatch
+#include <applications/Profiler.hpp>                                 // ngsai::app::StageTimer
+#include <applications/KineticTable.hpp>                             // ngsai::app::KineticTable
+#include <applications/KineticTableClassifier.hpp>                   // ngsai::app::KineticTableClassifier
+#include <applications/kinetic_model_utility.hpp>                    // ngsai::app::have_same_parameters()
+#include <applications/utilities.hpp>                                // ngsai::app::sort_by_start(), ngsai::app::sweep_records()
+#include <ngsaipp/epigenetics/CcsKineticExtractor.hpp>               // ngsai::CcsKineticExtractor
+#include <ngsaipp/genome/constants.hpp>                              // ngsai::genome::strand
+#include <pbbam/CompositeBamReader.h>                                // PacBio::BAM::GenomicIntervalCompositeBamReader
+#include <pbbam/GenomicInterval.h>                                   // PacBio::BAM::GenomicInterval
 
 namespace po = boost::program_options ;
+using stages = ngsai::app::Profiler::stages ;
+
+
+const size_t ngsai::app::ApplicationModelKinetic::count_batch_size = 1 << 16 ;
+
+
+const size_t ngsai::app::ApplicationModelKinetic::merge_dist = 1000 ;
+
+
+/*!
+ * \brief Parses a comma separated list of numbers.
+ * \param list the list, it may be empty.
+ * \param values the vector to which the numbers are 
+ * appended.
+ * \return whether all the numbers could be parsed.
+ */
+template<class T>
+static
+bool
+parse_list(const std::string& list,
+           std::vector<T>& values)
+{   if(list == "")
+    {   return true ; }
+    for(const auto& field : ngsai::split(list, ','))
+    {   std::istringstream stream(field) ;
+        T value ;
+        if((not (stream >> value)) or (not stream.eof()))
+        {   return false ; }
+        values.push_back(value) ;
+    }
+    return true ;
+}
+
+
+/*!
+ * \brief Checks whether a list contains a value more 
+ * than once.
+ * \param values the list.
+ * \return whether a value is repeated.
+ */
+template<class T>
+static
+bool
+has_duplicates(const std::vector<T>& values)
+{   return std::set<T>(values.begin(), values.end()).size() < 
+           values.size() ;
+}
+
+
+/*!
+ * \brief Inserts the size and binning of a model in 
+ * a file path, before the extension of the file name 
+ * if any, such that the models of a parameter grid are 
+ * saved in different files.
+ * \param path the path.
+ * \param size the model size.
+ * \param nb_bins the number of bins.
+ * \param xmin the lower limit of the lower bin.
+ * \param xmax the upper limit of the upper bin.
+ * \return the tagged path.
+ */
+static
+std::string
+tag_path(const std::string& path,
+         size_t size,
+         size_t nb_bins,
+         double xmin,
+         double xmax)
+{   std::ostringstream tag ;
+    tag << ".size" << size
+        << ".nbin" << nb_bins
+        << ".xmin" << xmin
+        << ".xmax" << xmax ;
+    // the extension is in the file name only, a leading 
+    // dot is part of the name
+    size_t slash = path.rfind('/') ;
+    size_t name  = (slash == std::string::npos) ? 0 : slash + 1 ;
+    size_t dot   = path.rfind('.') ;
+    if((dot == std::string::npos) or (dot <= name))
+    {   return path + tag.str() ; }
+    return path.substr(0, dot) + tag.str() + path.substr(dot) ;
+}
+
+
+/*!
+ * \brief Computes the windows of a CpG for several 
+ * sizes with KineticTableClassifier::getWindows(), 
+ * only on the CpG strand if it is oriented.
+ * \param cpg the CpG.
+ * \param sizes the window sizes.
+ * \param windows where the windows of each size are 
+ * stored, the forward one first.
+ * \param has_window where is stored whether each 
+ * window exists, a window that would start before the 
+ * chromosome start does not.
+ * \param span where the smallest start and the largest 
+ * end of the windows are stored.
+ * \return whether the CpG has at least one window.
+ */
+static
+bool
+get_strand_windows(const ngsai::BedRecord& cpg,
+                   const std::vector<size_t>& sizes,
+                   std::vector<std::array<ngsai::BedRecord,2>>& windows,
+                   std::vector<std::array<bool,2>>& has_window,
+                   std::pair<size_t,size_t>& span)
+{   windows.resize(sizes.size()) ;
+    has_window.assign(sizes.size(), {false, false}) ;
+    bool found = false ;
+    std::array<ngsai::BedRecord,2> cpg_windows ;
+    for(size_t k=0; k<sizes.size(); k++)
+    {   size_t n_windows = 
+            ngsai::app::KineticTableClassifier::getWindows(
+                                                cpg,
+                                                sizes[k],
+                                                cpg_windows) ;
+        for(size_t w=0; w<n_windows; w++)
+        {   bool forward = (cpg_windows[w].strand == 
+                                ngsai::genome::strand::FORWARD) ;
+            ngsai::genome::strand other = forward ?
+                                ngsai::genome::strand::REVERSE :
+                                ngsai::genome::strand::FORWARD ;
+            if(cpg.strand == other)
+            {   continue ; }
+            size_t s = forward ? 0 : 1 ;
+            windows[k][s]    = cpg_windows[w] ;
+            has_window[k][s] = true ;
+            if(not found)
+            {   span = std::make_pair(cpg_windows[w].start,
+                                      cpg_windows[w].end) ;
+                found = true ;
+            }
+            span.first  = std::min<size_t>(span.first, 
+                                           cpg_windows[w].start) ;
+            span.second = std::max<size_t>(span.second, 
+                                           cpg_windows[w].end) ;
+        }
+    }
+    return found ;
+}
 
 
 ngsai::app::ApplicationModelKinetic::
@@ -34,8 +193,10 @@ ngsai::app::ApplicationModelKinetic::
                                     char** argv)
     : ApplicationInterface(argc, argv),
       m_mode(modes::undefined),
+      m_modes(),
       m_paths_bam(),
       m_path_out(),
+      m_paths_out(),
       m_path_kmermap(),
       m_size(0),
       m_nb_bins(0),
@@ -43,9 +204,20 @@ ngsai::app::ApplicationModelKinetic::
       m_xmax(std::numeric_limits<double>::max()),
       m_pseudo_counts(0.),
       m_nb_threads(1),
-      m_cpgs(),
+      m_paths_bed(),
       m_kmermap(nullptr),
-      m_models()
+      m_models(),
+      m_checkpoint(false),
+      m_resume(false),
+      m_batch_size(0),
+      m_ckpt_time(0),
+      m_shared(false),
+      m_save_counts(false),
+      m_sparse(false),
+      m_check_shared(false),
+      m_counts(),
+      m_path_init(),
+      m_grid()
 {   int parsing = this->parseOptions() ;
     if(parsing == this->getExitCodeSuccess())
     {   m_is_runnable = true ; }
@@ -71,47 +243,122 @@ ngsai::app::ApplicationModelKinetic::run()
     if(not this->isRunnable())
     {   return this->getExitCodeError() ; }
 
+    if(m_shared)
+    {   return this->trainShared() ; }
+
     // threads
     std::vector<std::thread> threads;
 
-    // sub-sets of regions to train models on
-    std::vector<std::pair<size_t,size_t>> slices = 
-                ngsai::ThreadPool::split_range(0, 
-                                            m_cpgs.size(),
-                                            m_nb_threads) ;
-    // start all threads
+    // the number of batches in the partial model of 
+    // each thread and the batches already trained
+    std::vector<size_t> n_batches(m_nb_threads, 0) ;
+    std::set<size_t> done ;
+
+    // the log only applies to the same training
+    std::unique_ptr<ngsai::app::CheckpointLog> checkpoint ;
+    if(m_checkpoint)
+    {   std::ostringstream header ;
+        header << "papet model-kinetic checkpoint"
+               << " type="        << m_argv[1]
+               << " bed="         << m_paths_bed.front()
+               << " threads="     << m_nb_threads
+               << " batch="       << m_batch_size
+               << " size="        << m_size
+               << " nbin="        << m_nb_bins
+               << " xmin="        << m_xmin
+               << " xmax="        << m_xmax
+               << " pseudocount=" << m_pseudo_counts
+               << " init="        << m_path_init ;
+        try
+        {   checkpoint.reset(
+                new ngsai::app::CheckpointLog(
+                                    m_path_out + ".ckpt",
+                                    header.str(),
+                                    m_resume)) ;
+
+            // restart each thread from its last 
+            // saved partial model, which contains all 
+            // the batches it logged. An entry is 
+            // "<thread> <batches in model> <batch>..."
+            for(const auto& entry : checkpoint->getEntries())
+            {   std::istringstream fields(entry) ;
+                size_t i(0), batch(0), n(0) ;
+                if((not (fields >> i >> n)) or
+                   (i >= m_nb_threads))
+                {   std::cerr << "Error! invalid checkpoint "
+                                 "entry : " << entry
+                              << std::endl ;
+                    return this->getExitCodeError() ;
+                }
+                while(fields >> batch)
+                {   done.insert(batch) ; }
+                n_batches[i] = n ;
+            }
+            for(size_t i=0; i<m_nb_threads; i++)
+            {   if(n_batches[i] == 0)
+                {   continue ; }
+                m_models[i]->load(
+                        this->getCheckpointPath(i, n_batches[i])) ;
+                std::cerr << "resuming thread " << i 
+                          << " after " << n_batches[i]
+                          << " batches"
+                          << std::endl ;
+            }
+        }
+        catch(const std::exception& e)
+        {   std::cerr << "Error! could not resume from the "
+                         "checkpoint:"
+                      << std::endl 
+                      << e.what() << std::endl ;
+            return this->getExitCodeError() ;
+        }
+    }
+
+    // start all threads, they pull the batches of CpGs 
+    // as the BED file is read
     // -------------- threads start --------------
+    ngsai::app::BedBatchQueue queue(2 * m_nb_threads) ;
     for(size_t i=0; i<m_nb_threads; i++)
     {   
         // models have been allocated and parameters set
         // already
-        void (*pf)(ngsai::KineticModel*,
-                   const std::vector<ngsai::BedRecord>&,
-                   size_t,
-                   size_t,
-                   const std::vector<std::string>&) = 
-                                ngsai::train_KineticModel ;
         threads.push_back(
-                std::thread(pf,
-                            m_models[i],
-                            std::ref(m_cpgs),
-                            size_t(slices[i].first),
-                            size_t(slices[i].second),
-                            std::ref(m_paths_bam))) ;
+                std::thread(
+                    &ApplicationModelKinetic::trainRoutine,
+                    this,
+                    i,
+                    std::ref(queue),
+                    checkpoint.get(),
+                    std::ref(n_batches[i]))) ;
     }
+    int exit_code = this->readBed(queue, done) ;
     for(auto& thread : threads)
     {   if(thread.joinable())
         {   thread.join() ; }
     }
     // -------------- threads end --------------
+    if(exit_code != this->getExitCodeSuccess())
+    {   return exit_code ; }
 
     // aggregate models
-    for(size_t i=1; i<m_models.size(); i++)
-    {   m_models[0]->add(*(m_models[i])) ; }
+    ngsai::app::StageTimer timer(stages::classification) ;
+    this->reduceKineticModels() ;
 
     // serialize model
+    timer.switchTo(stages::output) ;
     m_models[0]->save(m_path_out) ;
 
+    // the checkpoints are not needed anymore
+    if(m_checkpoint)
+    {   checkpoint.reset() ;
+        for(size_t i=0; i<m_nb_threads; i++)
+        {   std::remove(this->getCheckpointPath(
+                                i, 
+                                n_batches[i]).c_str()) ;
+        }
+        std::remove((m_path_out + ".ckpt").c_str()) ;
+    }
+
     // free memory
     this->freeKineticModels() ;
     
@@ -152,6 +399,22 @@ ngsai::app::ApplicationModelKinetic::parseOptions()
                             "\t-'pairwise-norm': computes all distributions of\n"
                             "\t normalized IPD and PWD as a function of the\n"
                             "\tsignal at another position in the window.\n"
+                            "\tWith --shared, several types can be given as a\n"
+                            "\tcomma separated list, with one --out path per\n"
+                            "\ttype. The models are then trained in a single\n"
+                            "\tpass, each window being extracted once.\n"
+                            "\tWith --shared, --bedMeth and --bedUnmeth can be\n"
+                            "\tgiven instead of --bed to train the models of\n"
+                            "\tmethylated and unmethylated CpGs in a single\n"
+                            "\tsweep, saved in --outMeth and --outUnmeth.\n"
+                            "\tWith --shared, --size, --nbin, --xmin and --xmax\n"
+                            "\tcan also be comma separated lists. A model is then\n"
+                            "\ttrained for each combination of their values in\n"
+                            "\twhich xmin < xmax, from a single extraction of\n"
+                            "\tthe largest window each CCS covers, and\n"
+                            "\tsaved in a file named after the output file and\n"
+                            "\tits parameters, for instance\n"
+                            "\tout.size10.nbin50.xmin0.xmax10.binkineticmodel.\n"
                             "\tThe trained model is serialized in the given\n"
                             "\tfile.\n"
                             "\tWritten by Romain Groux, November 2022\n\n" ;
@@ -164,30 +427,126 @@ ngsai::app::ApplicationModelKinetic::parseOptions()
                                "It must contain a serialized KmerMap." ;
     std::string opt_bed_msg  = "The path to the bed file containing the " 
                                "genomic coordinates of the CpGs of interest.";
+    std::string opt_bedm_msg = "With --shared, instead of --bed, the path "
+                               "to the bed file containing the coordinates "
+                               "of methylated CpGs, sorted. Requires "
+                               "--bedUnmeth." ;
+    std::string opt_bedu_msg = "With --shared, instead of --bed, the path "
+                               "to the bed file containing the coordinates "
+                               "of unmethylated CpGs, sorted. Requires "
+                               "--bedMeth." ;
+    std::string opt_outm_msg = "With --bedMeth, instead of --out, the "
+                               "path(s) to the files in which the models "
+                               "of methylated CpGs will be saved, one per "
+                               "type." ;
+    std::string opt_outu_msg = "With --bedUnmeth, instead of --out, the "
+                               "path(s) to the files in which the models "
+                               "of unmethylated CpGs will be saved, one per "
+                               "type." ;
     std::string opt_out_msg  = "The path to file in which the kinetic model "
-                               "will be saved." ;
+                               "will be saved. With --shared and several "
+                               "types, a comma separated list of paths, "
+                               "one per type, in the same order." ;
     std::string opt_size_msg = "The size of the model, the length of the "
-                               "signal window to model, in bp." ;
-    std::string opt_nbin_msg = "The number of bins in each histogram." ;
+                               "signal window to model, in bp. With "
+                               "--shared, a comma separated list of "
+                               "sizes to sweep." ;
+    std::string opt_nbin_msg = "The number of bins in each histogram. With "
+                               "--shared, a comma separated list of "
+                               "numbers to sweep." ;
     std::string opt_xmin_msg = "The lower limit of the lower bin in each "
-                               "histogram." ;
+                               "histogram. With --shared, a comma "
+                               "separated list of limits to sweep." ;
     std::string opt_xmax_msg = "The upper limit of the upper bin in each "
-                               "histogram." ;
+                               "histogram. With --shared, a comma "
+                               "separated list of limits to sweep." ;
     std::string opt_pcnt_msg = "A number of counts that will be added to "
                                "each bin in each histogram, by default 0." ;
     std::string opt_thread_msg = "The number of threads, by default 1." ;
+    std::string opt_ckpt_msg = "Saves the partial model of each thread "
+                               "every --ckptTime seconds, next to the "
+                               "output file, and records its batches in "
+                               "the log file <out>.ckpt, such that the "
+                               "training can be resumed. The files are "
+                               "removed once the model is saved. Not "
+                               "compatible with --shared." ;
+    std::string opt_ckpt_time_msg = "The minimum time in seconds between "
+                                    "two checkpoints of a thread, by "
+                                    "default 600. A thread saves its "
+                                    "partial model after the first batch "
+                                    "that ends past this time." ;
+    std::string opt_resume_msg = "Resumes an interrupted training from "
+                                 "the last partial models recorded in "
+                                 "<out>.ckpt. The other options must be "
+                                 "those of the interrupted training. "
+                                 "Implies --checkpoint." ;
+    std::string opt_batch_msg = "The number of CpGs in the batches that "
+                                "the threads pull as the BED file is "
+                                "read, by default 10000 with "
+                                "--checkpoint and 100000 otherwise. "
+                                "The training of each batch opens the "
+                                "BAM files again." ;
+    std::string opt_shared_msg = "All the threads train a single model, "
+                                 "such that the memory does not grow with "
+                                 "the number of threads. The model is "
+                                 "saved as a table of log densities, "
+                                 "in the format of model-kinetic-bin, "
+                                 "and --out must have its extension. "
+                                 "Not compatible with --checkpoint." ;
+    std::string opt_init_msg = "The path to a model previously trained "
+                               "by model-kinetic, of the same type and "
+                               "with the same --size, --nbin, --xmin and "
+                               "--xmax, to which the counts of the new "
+                               "data are added. It already contains its "
+                               "pseudo counts. Not compatible with "
+                               "--shared nor --pseudocount." ;
+    std::string opt_counts_msg = "With --shared, saves the counts instead "
+                                 "of their log densities, such that "
+                                 "models trained on different data can "
+                                 "be summed with model-merge. The pseudo "
+                                 "counts are then added by model-merge." ;
+    std::string opt_sparse_msg = "With --shared, stores only the bins "
+                                 "that have been seen, in hash maps. A "
+                                 "seen bin costs 32 bytes or more, "
+                                 "against at most 8 bytes per bin for "
+                                 "the dense storage, such that it only "
+                                 "saves memory when fewer than about 25% "
+                                 "of the bins are seen, for instance for "
+                                 "pairwise models with large windows or "
+                                 "many bins. The saved tables are the "
+                                 "same." ;
+    std::string opt_checks_msg = "With --shared, also trains each model "
+                                 "with the regular training, on a single "
+                                 "thread, compiles it into a table and "
+                                 "reports the maximum difference with the "
+                                 "saved table on stderr. Fails if they "
+                                 "differ. Meant for small BED files. Not "
+                                 "compatible with --counts." ;
 
     // option parser
     std::string path_bam("") ;
     std::string path_bed("") ;
     std::string path_out("") ;
+    std::string path_bed_meth("") ;
+    std::string path_bed_unmeth("") ;
+    std::string path_out_meth("") ;
+    std::string path_out_unmeth("") ;
     std::string path_kmermap("") ;
-    size_t size(0) ;
-    size_t nb_bins(0) ;
-    double xmin(std::numeric_limits<double>::min()) ;
-    double xmax(std::numeric_limits<double>::max()) ;
+    std::string opt_size("") ;
+    std::string opt_nbin("") ;
+    std::string opt_xmin("") ;
+    std::string opt_xmax("") ;
     double pseudo_counts(0.) ;
     size_t n_threads(1) ;
+    bool checkpoint(false) ;
+    bool resume(false) ;
+    size_t batch_size(10000) ;
+    size_t ckpt_time(600) ;
+    bool shared(false) ;
+    bool counts(false) ;
+    bool sparse(false) ;
+    bool check_shared(false) ;
+    std::string path_init("") ;
 
     po::variables_map vm ;
     po::options_description desc(desc_msg) ;
@@ -199,22 +558,48 @@ ngsai::app::ApplicationModelKinetic::parseOptions()
                        opt_bed_msg.c_str())
         ("out",        po::value<std::string>(&(path_out)), 
                        opt_out_msg.c_str())
+        ("bedMeth",    po::value<std::string>(&(path_bed_meth)), 
+                       opt_bedm_msg.c_str())
+        ("bedUnmeth",  po::value<std::string>(&(path_bed_unmeth)), 
+                       opt_bedu_msg.c_str())
+        ("outMeth",    po::value<std::string>(&(path_out_meth)), 
+                       opt_outm_msg.c_str())
+        ("outUnmeth",  po::value<std::string>(&(path_out_unmeth)), 
+                       opt_outu_msg.c_str())
         ("background", po::value<std::string>(&(path_kmermap)), 
                        opt_bckg_msg.c_str())
-        ("size",       po::value<size_t>(&(size)), 
+        ("size",       po::value<std::string>(&(opt_size)), 
                        opt_size_msg.c_str())
-        ("nbin",       po::value<size_t>(&(nb_bins)), 
-                       opt_size_msg.c_str())
-        ("xmin",       po::value<double>(&(xmin)), 
+        ("nbin",       po::value<std::string>(&(opt_nbin)), 
+                       opt_nbin_msg.c_str())
+        ("xmin",       po::value<std::string>(&(opt_xmin)), 
                        opt_xmin_msg.c_str())
-        ("xmax",       po::value<double>(&(xmax)), 
+        ("xmax",       po::value<std::string>(&(opt_xmax)), 
                        opt_xmax_msg.c_str())
         ("pseudocount",  
                     po::value<double>(&(pseudo_counts)), 
                     opt_pcnt_msg.c_str())
         ("thread",  
                     po::value<size_t>(&(n_threads)), 
-                    opt_thread_msg.c_str());
+                    opt_thread_msg.c_str())
+        ("checkpoint", po::bool_switch(&(checkpoint)), 
+                       opt_ckpt_msg.c_str())
+        ("resume",     po::bool_switch(&(resume)), 
+                       opt_resume_msg.c_str())
+        ("ckptTime",   po::value<size_t>(&(ckpt_time)), 
+                       opt_ckpt_time_msg.c_str())
+        ("batch",      po::value<size_t>(&(batch_size)), 
+                       opt_batch_msg.c_str())
+        ("shared",     po::bool_switch(&(shared)), 
+                       opt_shared_msg.c_str())
+        ("counts",     po::bool_switch(&(counts)), 
+                       opt_counts_msg.c_str())
+        ("sparse",     po::bool_switch(&(sparse)), 
+                       opt_sparse_msg.c_str())
+        ("checkShared", po::bool_switch(&(check_shared)), 
+                       opt_checks_msg.c_str())
+        ("init",       po::value<std::string>(&(path_init)), 
+                       opt_init_msg.c_str()) ;
 
     // parse
     try
@@ -245,45 +630,95 @@ ngsai::app::ApplicationModelKinetic::parseOptions()
         return this->getExitCodeError() ;
     }
 
+    // without checkpoints the batches only balance the 
+    // threads, larger ones open the BAM files less often
+    if((vm.count("batch") == 0) and (not (checkpoint or resume)))
+    {   batch_size = 100000 ; }
+
+    // the values of each parameter of the grid
+    std::vector<size_t> sizes ;
+    std::vector<size_t> nbins ;
+    std::vector<double> xmins ;
+    std::vector<double> xmaxs ;
+    bool parsed = parse_list(opt_size, sizes) and
+                  parse_list(opt_nbin, nbins) and
+                  parse_list(opt_xmin, xmins) and
+                  parse_list(opt_xmax, xmaxs) ;
+
     // check options
+    bool labelled = (path_bed_meth != "") or 
+                    (path_bed_unmeth != "") ;
     if(path_bam == "")
     {   std::cerr <<"no bam file given (--bam)"
                   << std::endl ;
         return this->getExitCodeError() ;
     }
-    else if(path_bed == "")
+    else if(labelled and 
+            ((path_bed_meth == "") or (path_bed_unmeth == "") or
+             (path_out_meth == "") or (path_out_unmeth == "")))
+    {   std::cerr <<"labelled bed files need both classes "
+                    "(--bedMeth --bedUnmeth --outMeth --outUnmeth)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(labelled and ((path_bed != "") or (path_out != "")))
+    {   std::cerr <<"labelled bed files replace --bed and --out "
+                    "(--bedMeth --bedUnmeth --bed --out)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(labelled and (not shared))
+    {   // the KineticModel training extracts the windows
+        // by itself
+        std::cerr <<"labelled bed files can only be trained "
+                    "with --shared (--bedMeth --bedUnmeth)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if((not labelled) and (path_bed == ""))
     {   std::cerr <<"no bed file given (--bed)"
                   << std::endl ;
         return this->getExitCodeError() ;
     }
-    else if(path_out == "")
+    else if((not labelled) and (path_out == ""))
     {   std::cerr <<"no output file given (--out)"
                   << std::endl ;
         return this->getExitCodeError() ;
     }
-    else if(size == 0)
+    else if(not parsed)
+    {   std::cerr <<"invalid number given "
+                    "(--size --nbin --xmin --xmax)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(sizes.empty() or 
+            (std::find(sizes.begin(), sizes.end(), 0) != 
+                sizes.end()))
     {   std::cerr <<"invalid model size given (--size)"
                   << std::endl ;
         return this->getExitCodeError() ;
     }
-    else if(nb_bins == 0)
+    else if(nbins.empty() or 
+            (std::find(nbins.begin(), nbins.end(), 0) != 
+                nbins.end()))
     {   std::cerr <<"invalid number of bins given (--nbin)"
                   << std::endl ;
         return this->getExitCodeError() ;
     }
-    else if(xmin == std::numeric_limits<double>::min())
+    else if(xmins.empty())
     {   std::cerr <<"invalid x-axis minimum given (--xmin)"
                   << std::endl ;
         return this->getExitCodeError() ;
     }
-    else if(xmax == std::numeric_limits<double>::max())
+    else if(xmaxs.empty())
     {   std::cerr <<"invalid x-axis maximum given (--xmax)"
                   << std::endl ;
         return this->getExitCodeError() ;
     }
-    else if(xmin >= xmax)
-    {   std::cerr <<"xmin must be smaller than xmax "
-                    "(--xmin --xmax)"
+    else if(has_duplicates(sizes) or has_duplicates(nbins) or
+            has_duplicates(xmins) or has_duplicates(xmaxs))
+    {   std::cerr <<"a value is given twice "
+                    "(--size --nbin --xmin --xmax)"
                   << std::endl ;
         return this->getExitCodeError() ;
     }
@@ -299,35 +734,208 @@ ngsai::app::ApplicationModelKinetic::parseOptions()
                   << std::endl ;
         return this->getExitCodeError() ;
     }
+    else if(batch_size == 0)
+    {   std::cerr <<"batch size must by > 0 "
+                    "(--batch)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(shared and (checkpoint or resume))
+    {   std::cerr <<"shared training cannot be checkpointed "
+                    "(--shared --checkpoint --resume)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(counts and (not shared))
+    {   std::cerr <<"only a shared training can save counts "
+                    "(--counts --shared)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(sparse and (not shared))
+    {   std::cerr <<"only a shared training can store sparse "
+                    "counts (--sparse --shared)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(check_shared and ((not shared) or counts))
+    {   std::cerr <<"only the log densities of a shared training "
+                    "can be checked (--checkShared --shared --counts)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(counts and (pseudo_counts != 0.))
+    {   std::cerr <<"the pseudo counts are added when the "
+                    "counts are merged (--counts --pseudocount)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if((path_init != "") and shared)
+    {   std::cerr <<"a shared training cannot start from "
+                    "an initial model (--init --shared)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if((path_init != "") and (pseudo_counts != 0.))
+    {   std::cerr <<"the pseudo counts are those of the "
+                    "initial model (--init --pseudocount)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
 
-    // type of model to train
-    std::string opt_mode(m_argv[1]) ;
-    if(opt_mode == "raw")
-    {   m_mode = modes::raw ; }
-    else if(opt_mode == "raw-norm")
-    {   m_mode = modes::raw_norm ; }
-    else if(opt_mode == "diposition")
-    {   m_mode = modes::diposition ; }
-     else if(opt_mode == "diposition-norm")
-    {   m_mode = modes::diposition_norm ; }
-    else if(opt_mode == "pairwise")
-    {   m_mode = modes::pairwise ; }
-    else if(opt_mode == "pairwise-norm")
-    {   m_mode = modes::pairwise_norm ; }
+    // type(s) of model to train
+    std::vector<std::string> opt_modes = 
+                            ngsai::split(m_argv[1], ',') ;
+    std::vector<modes> modes_train ;
+    bool normalized = false ;
+    for(const auto& opt_mode : opt_modes)
+    {   modes mode = modes::undefined ;
+        if(opt_mode == "raw")
+        {   mode = modes::raw ; }
+        else if(opt_mode == "raw-norm")
+        {   mode = modes::raw_norm ; }
+        else if(opt_mode == "diposition")
+        {   mode = modes::diposition ; }
+        else if(opt_mode == "diposition-norm")
+        {   mode = modes::diposition_norm ; }
+        else if(opt_mode == "pairwise")
+        {   mode = modes::pairwise ; }
+        else if(opt_mode == "pairwise-norm")
+        {   mode = modes::pairwise_norm ; }
+        else
+        {   std::cerr << "Error! " << opt_mode << " "
+                      << "does not indicate a model type. The "
+                      << "accepted values are: raw, raw-norm "
+                      << "diposition, diposition-norma, "
+                      << "pairwise, pairwise-norm"
+                      << std::endl ;
+            return this->getExitCodeError() ;
+        }
+        if(std::find(modes_train.begin(), 
+                     modes_train.end(), 
+                     mode) != modes_train.end())
+        {   std::cerr << "Error! model type " << opt_mode 
+                      << " is given twice"
+                      << std::endl ;
+            return this->getExitCodeError() ;
+        }
+        modes_train.push_back(mode) ;
+        normalized = normalized or 
+                     (mode == modes::raw_norm) or
+                     (mode == modes::diposition_norm) or
+                     (mode == modes::pairwise_norm) ;
+    }
+
+    // all the valid combinations of the parameter values
+    std::vector<parameters> grid ;
+    for(size_t size : sizes)
+    {   for(size_t nb_bins : nbins)
+        {   for(double xmin : xmins)
+            {   for(double xmax : xmaxs)
+                {   if(xmin < xmax)
+                    {   grid.push_back({size, nb_bins, xmin, xmax}) ; }
+                }
+            }
+        }
+    }
+    if(grid.empty())
+    {   std::cerr <<"xmin must be smaller than xmax "
+                    "(--xmin --xmax)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(grid.size() < 
+                sizes.size() * nbins.size() * 
+                xmins.size() * xmaxs.size())
+    {   std::cerr << "skipping the combinations in which xmin "
+                     "is not smaller than xmax (--xmin --xmax)"
+                  << std::endl ;
+    }
+
+    // one output per type, for each point of the grid 
+    // and each label
+    std::vector<std::string> paths_bed ;
+    std::vector<std::string> paths_out ;
+    std::vector<std::string> opt_paths_out ;
+    if(labelled)
+    {   paths_bed     = {path_bed_meth, path_bed_unmeth} ;
+        opt_paths_out = {path_out_meth, path_out_unmeth} ;
+    }
     else
-    {   std::cerr << "Error! " << m_argv[1] << " "
-                  << "does not indicate a model type. The "
-                  << "accepted values are: raw, raw-norm "
-                  << "diposition, diposition-norma, "
-                  << "pairwise, pairwise-norm"
+    {   paths_bed     = {path_bed} ;
+        opt_paths_out = {path_out} ;
+    }
+    if(modes_train.empty())
+    {   std::cerr << "Error! no model type given"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    for(const auto& opt_path_out : opt_paths_out)
+    {   std::vector<std::string> paths = 
+                            ngsai::split(opt_path_out, ',') ;
+        if(paths.size() != modes_train.size())
+        {   std::cerr << "Error! one output file must be given "
+                         "per model type (--out --outMeth "
+                         "--outUnmeth)"
+                      << std::endl ;
+            return this->getExitCodeError() ;
+        }
+        for(const auto& point : grid)
+        {   for(const auto& path : paths)
+            {   if(grid.size() == 1)
+                {   paths_out.push_back(path) ; }
+                else
+                {   paths_out.push_back(tag_path(path,
+                                                 point.size,
+                                                 point.nb_bins,
+                                                 point.xmin,
+                                                 point.xmax)) ;
+                }
+            }
+        }
+    }
+    // the values are formatted in the paths with 6 
+    // significant digits, close values give the same file
+    if(std::set<std::string>(paths_out.begin(), 
+                             paths_out.end()).size() < 
+            paths_out.size())
+    {   std::cerr << "Error! several models would be saved "
+                     "in the same file, the output paths or "
+                     "the --xmin and --xmax values written in "
+                     "their names are not all different "
+                     "(--out --outMeth --outUnmeth --xmin --xmax)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    if((modes_train.size() > 1) and (not shared))
+    {   // the KineticModel training extracts the windows
+        // by itself
+        std::cerr << "Error! several model types can only be "
+                     "trained at once with --shared"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if((grid.size() > 1) and (not shared))
+    {   std::cerr << "Error! several sizes or binnings can only "
+                     "be trained at once with --shared"
                   << std::endl ;
         return this->getExitCodeError() ;
     }
+    for(const auto& path : paths_out)
+    {   if(shared and 
+           (not ngsai::endswith(
+                    path,
+                    ngsai::app::KineticTable::extension)))
+        {   std::cerr << "Error! the output file extension "
+                         "must be "
+                      << ngsai::app::KineticTable::extension
+                      << " (--shared --out)"
+                      << std::endl ;
+            return this->getExitCodeError() ;
+        }
+    }
 
-    if(((m_mode == modes::raw_norm) or
-             (m_mode == modes::diposition_norm) or
-             (m_mode == modes::pairwise_norm)) and 
-            (path_kmermap == ""))
+    if(normalized and (path_kmermap == ""))
     {   std::cerr <<"no background model file given "
                     "(--background)"
                   << std::endl ;
@@ -345,21 +953,46 @@ ngsai::app::ApplicationModelKinetic::parseOptions()
 
     // set fields
     m_paths_bam = paths_bam ;
-    m_path_out = path_out ; 
+    m_mode = modes_train.front() ;
+    m_modes = modes_train ;
+    m_path_out = paths_out.front() ; 
+    m_paths_out = paths_out ;
     m_path_kmermap = path_kmermap ;
-    m_size = size ; 
-    m_nb_bins = nb_bins ; 
-    m_xmin = xmin ;
-    m_xmax = xmax ;
+    m_size = *std::max_element(sizes.begin(), sizes.end()) ; 
+    m_nb_bins = nbins.front() ; 
+    m_xmin = xmins.front() ;
+    m_xmax = xmaxs.front() ;
+    m_grid = grid ;
     m_pseudo_counts = pseudo_counts ;
     m_nb_threads = n_threads ;
+    m_checkpoint = checkpoint or resume ;
+    m_resume = resume ;
+    m_batch_size = batch_size ;
+    m_ckpt_time = ckpt_time ;
+    m_shared = shared ;
+    m_save_counts = counts ;
+    m_sparse = sparse ;
+    m_check_shared = check_shared ;
+    m_path_init = path_init ;
 
-    // load BED file
-    if(this->loadBed(path_bed))
-    {   return this->getExitCodeError() ; }
+    // the BED files are streamed during the training, only 
+    // check that they can be read
+    for(const auto& path : paths_bed)
+    {   if(not std::ifstream(path).is_open())
+        {   std::cerr << "Error! cannot open BED file "
+                      << path
+                      << std::endl ;
+            return this->getExitCodeError() ;
+        }
+    }
+    m_paths_bed = paths_bed ;
 
     // allocate model memory
-    if(this->allocateKineticModels())
+    if(m_shared)
+    {   if(this->allocateCountTable())
+        {   return this->getExitCodeError() ; }
+    }
+    else if(this->allocateKineticModels())
     {   return this->getExitCodeError() ; }
 
     return this->getExitCodeSuccess() ;
@@ -409,60 +1042,22 @@ ngsai::app::ApplicationModelKinetic::allocateKineticModels()
         m_models = std::vector<ngsai::KineticModel*>
                     (m_nb_threads, nullptr) ;
 
-        if(m_mode == modes::raw)
-        {   
-            for(auto& ptr : m_models)
-            {   ptr = new ngsai::RawKineticModel() ; }
-        }
-        else if(m_mode == modes::raw_norm)
-        {   if(this->loadKmerMap(m_path_kmermap) != 
-               this->getExitCodeSuccess())
-            {   return this->getExitCodeError() ; }
-            
-            for(auto& ptr : m_models)
-            {   ptr = new ngsai::NormalizedKineticModel(
-                                            *m_kmermap) ;
-            }
-            delete m_kmermap ;
-            m_kmermap = nullptr ;
-        }
-        else if(m_mode == modes::diposition)
-        {   for(auto& ptr: m_models)
-            {   ptr = 
-                    new ngsai::DiPositionKineticModel() ;
-            }
-        }
-        else if(m_mode == modes::diposition_norm)
-        {   if(this->loadKmerMap(m_path_kmermap) != 
-               this->getExitCodeSuccess())
-            {   return this->getExitCodeError() ; }
-            
-            for(auto& ptr: m_models)
-            {   ptr = new 
-                    ngsai::DiPositionNormalizedKineticModel(
-                                            *m_kmermap) ;
-            }
-            delete m_kmermap ;
-            m_kmermap = nullptr ;
-        }
-        else if(m_mode == modes::pairwise)
-        {   for(auto& ptr: m_models)
-            {   ptr = new ngsai::PairWiseKineticModel() ; }
-        }
-        else if(m_mode == modes::pairwise_norm)
-        {   if(this->loadKmerMap(m_path_kmermap) != 
-               this->getExitCodeSuccess())
-            {   return this->getExitCodeError() ; }
-            
-            for(auto& ptr : m_models)
-            {   ptr = new 
-                    ngsai::PairWiseNormalizedKineticModel(
-                                            *m_kmermap) ;
-            }
-            delete m_kmermap ;
+        // the normalized models copy the KmerMap
+        bool normalized = (m_mode == modes::raw_norm) or
+                          (m_mode == modes::diposition_norm) or
+                          (m_mode == modes::pairwise_norm) ;
+        if(normalized and 
+           (this->loadKmerMap(m_path_kmermap) != 
+                this->getExitCodeSuccess()))
+        {   return this->getExitCodeError() ; }
+
+        for(auto& ptr : m_models)
+        {   ptr = this->newKineticModel(m_mode, m_kmermap) ; }
+        if(m_kmermap != nullptr)
+        {   delete m_kmermap ;
             m_kmermap = nullptr ;
         }
-        else
+        if(m_models.front() == nullptr)
         {   std::cerr << "Error! could not determine the "
                          "type of kinetic signal model "
                          "to train"
@@ -495,6 +1090,112 @@ ngsai::app::ApplicationModelKinetic::allocateKineticModels()
                   << std::endl ;
         return this->getExitCodeError() ;
     }
+
+    // the 1st partial model starts from the initial 
+    // model, which already contains its pseudo counts
+    if(m_path_init != "")
+    {   return this->loadInitModel(m_path_init) ; }
+
+    return this->getExitCodeSuccess() ;
+}
+
+
+ngsai::KineticModel*
+ngsai::app::ApplicationModelKinetic::newKineticModel(
+                            modes mode,
+                            const ngsai::KmerMap* kmermap) const
+{   if(mode == modes::raw)
+    {   return new ngsai::RawKineticModel() ; }
+    else if(mode == modes::raw_norm)
+    {   return new ngsai::NormalizedKineticModel(*kmermap) ; }
+    else if(mode == modes::diposition)
+    {   return new ngsai::DiPositionKineticModel() ; }
+    else if(mode == modes::diposition_norm)
+    {   return new ngsai::DiPositionNormalizedKineticModel(
+                                                *kmermap) ;
+    }
+    else if(mode == modes::pairwise)
+    {   return new ngsai::PairWiseKineticModel() ; }
+    else if(mode == modes::pairwise_norm)
+    {   return new ngsai::PairWiseNormalizedKineticModel(
+                                                *kmermap) ;
+    }
+    return nullptr ;
+}
+
+
+int
+ngsai::app::ApplicationModelKinetic::loadInitModel(
+                                    const std::string& path)
+{   
+    ngsai::app::StageTimer timer(stages::model_load) ;
+
+    std::unique_ptr<ngsai::KineticModel> model ;
+    try
+    {   // the KmerMap of normalized models is loaded 
+        // from the file
+        if(m_mode == modes::raw)
+        {   model.reset(new ngsai::RawKineticModel()) ; }
+        else if(m_mode == modes::raw_norm)
+        {   model.reset(new ngsai::NormalizedKineticModel()) ; }
+        else if(m_mode == modes::diposition)
+        {   model.reset(new ngsai::DiPositionKineticModel()) ; }
+        else if(m_mode == modes::diposition_norm)
+        {   model.reset(
+                new ngsai::DiPositionNormalizedKineticModel()) ;
+        }
+        else if(m_mode == modes::pairwise)
+        {   model.reset(new ngsai::PairWiseKineticModel()) ; }
+        else if(m_mode == modes::pairwise_norm)
+        {   model.reset(
+                new ngsai::PairWiseNormalizedKineticModel()) ;
+        }
+        model->load(path) ;
+    }
+    catch(const std::exception& e)
+    {   std::cerr << "Error! could not load the initial "
+                     "model:"
+                  << std::endl
+                  << e.what()
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    // only counts can be added to
+    if(not model->isInit())
+    {   std::cerr << "Error! the initial model is not "
+                     "initialised (--init)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(model->isDensity())
+    {   std::cerr << "Error! the initial model contains "
+                     "densities instead of counts (--init)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    try
+    {   if(not ngsai::app::have_same_parameters(*model, 
+                                                *m_models[0]))
+        {   std::cerr << "Error! the initial model type, size "
+                         "or binning differ from the model to "
+                         "train (--init --size --nbin --xmin "
+                         "--xmax)"
+                      << std::endl ;
+            return this->getExitCodeError() ;
+        }
+    }
+    catch(const std::exception& e)
+    {   std::cerr << "Error! could not check the initial "
+                     "model:"
+                  << std::endl
+                  << e.what()
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    delete m_models[0] ;
+    m_models[0] = model.release() ;
     return this->getExitCodeSuccess() ;
 }
 
@@ -523,29 +1224,611 @@ ngsai::app::ApplicationModelKinetic::freeKineticModels()
 }
 
 
+void
+ngsai::app::ApplicationModelKinetic::trainRoutine(
+                    size_t thread_index,
+                    ngsai::app::BedBatchQueue& queue,
+                    ngsai::app::CheckpointLog* checkpoint,
+                    size_t& n_batches)
+{   
+    // the CCSs are fetched and their kinetics extracted 
+    // within the training, which is timed as a whole
+    ngsai::app::StageTimer timer(stages::classification) ;
+    ngsai::app::BedBatch batch ;
+
+    // the batches trained since the last save and the 
+    // number of batches in the model
+    std::vector<size_t> unsaved ;
+    size_t n_trained = n_batches ;
+    auto last_save = std::chrono::steady_clock::now() ;
+    while(queue.pop(batch))
+    {   timer.switchTo(stages::classification) ;
+        ngsai::train_KineticModel(m_models[thread_index],
+                                  batch.records,
+                                  0,
+                                  batch.records.size(),
+                                  m_paths_bam) ;
+        n_trained++ ;
+        if(checkpoint == nullptr)
+        {   continue ; }
+        unsaved.push_back(batch.index) ;
+        auto now = std::chrono::steady_clock::now() ;
+        if(std::chrono::duration_cast<std::chrono::seconds>(
+                            now - last_save).count() < 
+                    static_cast<long long>(m_ckpt_time))
+        {   continue ; }
+        timer.switchTo(stages::output) ;
+
+        // the model is saved in a new file before it is 
+        // logged, an interruption in between leaves the 
+        // previous checkpoint valid. Its batches are 
+        // logged at once, such that an interruption 
+        // cannot log only some of them
+        try
+        {   m_models[thread_index]->save(
+                    this->getCheckpointPath(thread_index, 
+                                            n_trained)) ;
+            std::string entry = std::to_string(thread_index) + 
+                                " " + 
+                                std::to_string(n_trained) ;
+            for(size_t index : unsaved)
+            {   entry += " " + std::to_string(index) ; }
+            checkpoint->append(entry) ;
+            std::remove(this->getCheckpointPath(
+                                    thread_index,
+                                    n_batches).c_str()) ;
+            unsaved.clear() ;
+            n_batches = n_trained ;
+            last_save = std::chrono::steady_clock::now() ;
+        }
+        catch(const std::exception& e)
+        {   std::cerr << "Error! could not save a checkpoint, "
+                         "thread " << thread_index 
+                      << " continues without:"
+                      << std::endl 
+                      << e.what() << std::endl ;
+            checkpoint = nullptr ;
+        }
+    }
+}
+
+
+void
+ngsai::app::ApplicationModelKinetic::reduceKineticModels()
+{   
+    // at each level, model i receives model i+step, the 
+    // sum ends in model 0 after log2(n) levels
+    size_t n = m_models.size() ;
+    for(size_t step=1; step<n; step*=2)
+    {   std::vector<std::thread> threads ;
+        for(size_t i=0; i+step<n; i+=2*step)
+        {   threads.push_back(
+                std::thread(
+                    [this, i, step]() -> void
+                    {   m_models[i]->add(*(m_models[i+step])) ;
+                        delete m_models[i+step] ;
+                        m_models[i+step] = nullptr ;
+                    })) ;
+        }
+        for(auto& thread : threads)
+        {   if(thread.joinable())
+            {   thread.join() ; }
+        }
+    }
+}
+
+
+int
+ngsai::app::ApplicationModelKinetic::allocateCountTable()
+{   
+    // the tables share the KmerMap
+    std::shared_ptr<const ngsai::KmerMap> kmermap ;
+
+    // one table per type, for each point of the grid and 
+    // each label
+    size_t n_modes  = m_modes.size() ;
+    size_t n_tables = m_paths_bed.size() * m_grid.size() * n_modes ;
+    m_counts.clear() ;
+    for(size_t i=0; i<n_tables; i++)
+    {   modes mode = m_modes[i % n_modes] ;
+        const parameters& point = m_grid[(i / n_modes) % m_grid.size()] ;
+        ngsai::app::KineticTable::layouts layout ;
+        bool normalized = false ;
+        if(mode == modes::raw)
+        {   layout = ngsai::app::KineticTable::layouts::raw ; }
+        else if(mode == modes::raw_norm)
+        {   layout = ngsai::app::KineticTable::layouts::raw ;
+            normalized = true ;
+        }
+        else if(mode == modes::diposition)
+        {   layout = ngsai::app::KineticTable::layouts::diposition ; }
+        else if(mode == modes::diposition_norm)
+        {   layout = ngsai::app::KineticTable::layouts::diposition ;
+            normalized = true ;
+        }
+        else if(mode == modes::pairwise)
+        {   layout = ngsai::app::KineticTable::layouts::pairwise ; }
+        else if(mode == modes::pairwise_norm)
+        {   layout = ngsai::app::KineticTable::layouts::pairwise ;
+            normalized = true ;
+        }
+        else
+        {   std::cerr << "Error! could not determine the "
+                         "type of kinetic signal model "
+                         "to train"
+                      << std::endl ;
+            return this->getExitCodeError() ;
+        }
+
+        if(normalized and (kmermap == nullptr))
+        {   if(this->loadKmerMap(m_path_kmermap) != 
+               this->getExitCodeSuccess())
+            {   return this->getExitCodeError() ; }
+            kmermap.reset(m_kmermap) ;
+            m_kmermap = nullptr ;
+        }
+
+        try
+        {   m_counts.emplace_back(
+                new ngsai::app::CountTable(
+                            layout,
+                            point.size,
+                            point.nb_bins,
+                            point.xmin,
+                            point.xmax,
+                            normalized ? kmermap : nullptr,
+                            m_sparse ? 
+                            ngsai::app::CountTable::storages::sparse :
+                            ngsai::app::CountTable::storages::dense)) ;
+        }
+        catch(const std::exception& e)
+        {   std::cerr << "Error! Something occured while "
+                         "allocating the counts: "
+                      << std::endl
+                      << e.what()
+                      << std::endl ;
+            return this->getExitCodeError() ;
+        }
+    }
+    return this->getExitCodeSuccess() ;
+}
+
+
+int
+ngsai::app::ApplicationModelKinetic::trainShared()
+{
+    ngsai::app::BedBatchQueue queue(2 * m_nb_threads) ;
+    std::vector<std::thread> threads ;
+    for(size_t i=0; i<m_nb_threads; i++)
+    {   threads.push_back(
+                std::thread(
+                    &ApplicationModelKinetic::trainSharedRoutine,
+                    this,
+                    std::ref(queue))) ;
+    }
+    int exit_code = this->readBed(queue, std::set<size_t>()) ;
+    for(auto& thread : threads)
+    {   if(thread.joinable())
+        {   thread.join() ; }
+    }
+    if(exit_code != this->getExitCodeSuccess())
+    {   return exit_code ; }
+
+    ngsai::app::StageTimer timer(stages::output) ;
+    for(size_t i=0; i<m_counts.size(); i++)
+    {   try
+        {   // written by chunks, the dense table is never 
+            // held in memory
+            if(m_save_counts)
+            {   m_counts[i]->save(
+                        m_paths_out[i],
+                        ngsai::app::KineticTable::contents::counts,
+                        0.) ;
+            }
+            else
+            {   m_counts[i]->save(
+                    m_paths_out[i],
+                    ngsai::app::KineticTable::contents::log_densities,
+                    m_pseudo_counts) ;
+            }
+        }
+        catch(const std::exception& e)
+        {   std::cerr << "Error! could not save the model "
+                      << m_paths_out[i] << ":"
+                      << std::endl
+                      << e.what() << std::endl ;
+            return this->getExitCodeError() ;
+        }
+        // the memory is released as soon as possible
+        m_counts[i].reset() ;
+    }
+    m_counts.clear() ;
+
+    if(m_check_shared)
+    {   timer.switchTo(stages::extraction) ;
+        return this->checkShared() ;
+    }
+
+    return this->getExitCodeSuccess() ;
+}
+
+
+int
+ngsai::app::ApplicationModelKinetic::checkShared()
+{   
+    // the log densities computed by the two trainings 
+    // only differ by rounding
+    const double tolerance = 1e-6 ;
+
+    size_t n_modes     = m_modes.size() ;
+    size_t n_per_label = m_grid.size() * n_modes ;
+    bool equal = true ;
+    for(size_t label=0; label<m_paths_bed.size(); label++)
+    {   try
+        {   std::vector<ngsai::BedRecord> cpgs ;
+            ngsai::BedReader reader(m_paths_bed[label]) ;
+            ngsai::BedRecord cpg ;
+            while(reader.getNext(cpg))
+            {   cpgs.push_back(cpg) ; }
+            reader.close() ;
+
+            for(size_t t=label*n_per_label; 
+                t<(label+1)*n_per_label; 
+                t++)
+            {   modes mode = m_modes[t % n_modes] ;
+                const parameters& point = 
+                            m_grid[(t / n_modes) % m_grid.size()] ;
+                ngsai::app::KineticTable table = 
+                    ngsai::app::KineticTable::load(m_paths_out[t]) ;
+
+                // the reference model
+                std::unique_ptr<ngsai::KineticModel> model(
+                    this->newKineticModel(
+                                mode, 
+                                table.getKmerMap().get())) ;
+                model->setParameters(point.size,
+                                     point.xmin,
+                                     point.xmax,
+                                     point.nb_bins,
+                                     m_pseudo_counts) ;
+                ngsai::train_KineticModel(model.get(),
+                                          cpgs,
+                                          0,
+                                          cpgs.size(),
+                                          m_paths_bam) ;
+                model->density() ;
+                model->log() ;
+                ngsai::app::KineticTable reference = 
+                    ngsai::app::KineticTable::fromModel(*model) ;
+                model.reset() ;
+                if(not reference.isCompatible(table))
+                {   std::cerr << "shared check : " 
+                              << m_paths_out[t]
+                              << " does not have the layout of "
+                                 "the reference model"
+                              << std::endl ;
+                    equal = false ;
+                    continue ;
+                }
+
+                // the empty bins are equal if both are 
+                // infinite or undefined
+                double max_diff = 0. ;
+                const double* values = table.data() ;
+                const double* values_ref = reference.data() ;
+                for(size_t i=0; i<table.getValueNumber(); i++)
+                {   double a = values[i] ;
+                    double b = values_ref[i] ;
+                    double diff = 0. ;
+                    if(std::isnan(a) or std::isnan(b))
+                    {   diff = (std::isnan(a) and std::isnan(b)) ? 
+                               0. : 
+                               std::numeric_limits<double>::infinity() ;
+                    }
+                    else if(a != b)
+                    {   diff = std::fabs(a - b) ; }
+                    max_diff = std::max(max_diff, diff) ;
+                }
+                std::cerr << "shared check : "
+                          << m_paths_out[t]
+                          << " max absolute log density "
+                             "difference "
+                          << max_diff
+                          << std::endl ;
+                equal = equal and (max_diff <= tolerance) ;
+            }
+        }
+        catch(const std::exception& e)
+        {   std::cerr << "Error! could not check the models "
+                         "of "
+                      << m_paths_bed[label] << ":"
+                      << std::endl
+                      << e.what() << std::endl ;
+            return this->getExitCodeError() ;
+        }
+    }
+    if(not equal)
+    {   std::cerr << "Error! the shared training differs from "
+                     "the regular training (--checkShared)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    return this->getExitCodeSuccess() ;
+}
+
+
+void
+ngsai::app::ApplicationModelKinetic::trainSharedRoutine(
+                            ngsai::app::BedBatchQueue& queue)
+{   
+    ngsai::app::Profiler& profiler = 
+                        ngsai::app::Profiler::getInstance() ;
+    ngsai::app::StageTimer timer(stages::bam_fetch) ;
+
+    // the model sizes, the largest first
+    std::vector<size_t> sizes ;
+    for(const auto& point : m_grid)
+    {   sizes.push_back(point.size) ; }
+    std::sort(sizes.begin(), sizes.end(), std::greater<size_t>()) ;
+    sizes.erase(std::unique(sizes.begin(), sizes.end()), 
+                sizes.end()) ;
+
+    // each window is extracted, and normalized if needed, 
+    // once for all the tables, with the largest size that 
+    // the CCS covers. The tables of this size and of 
+    // smaller ones bin its central part
+    const ngsai::KmerMap* kmermap = nullptr ;
+    std::vector<std::vector<size_t>> indices(m_counts.size()) ;
+    for(size_t t=0; t<m_counts.size(); t++)
+    {   const ngsai::app::KineticTable& layout = 
+                                    m_counts[t]->getLayout() ;
+        if(layout.isNormalized())
+        {   kmermap = layout.getKmerMap().get() ; }
+        indices[t].reserve(count_batch_size + 
+                           2 * layout.getFactorNumber()) ;
+    }
+    PacBio::BAM::GenomicIntervalCompositeBamReader reader_bam(
+                                                m_paths_bam) ;
+    PacBio::BAM::BamRecord record_bam ;
+    ngsai::CcsKineticExtractor extractor ;
+    std::vector<std::array<ngsai::BedRecord,2>> windows ;
+    std::vector<std::array<bool,2>> has_window ;
+
+    size_t n_per_label = m_grid.size() * m_modes.size() ;
+    ngsai::app::BedBatch batch ;
+    while(queue.pop(batch))
+    {   // the span of the windows of each CpG, of any 
+        // size, the CpGs being swept by span start. The 
+        // CpGs without any window are skipped
+        size_t n = batch.records.size() ;
+        std::vector<std::pair<size_t,size_t>> spans(n) ;
+        std::vector<size_t> order ;
+        order.reserve(n) ;
+        for(size_t i=0; i<n; i++)
+        {   if(get_strand_windows(batch.records[i],
+                                  sizes,
+                                  windows,
+                                  has_window,
+                                  spans[i]))
+            {   order.push_back(i) ; }
+        }
+        std::sort(order.begin(),
+                  order.end(),
+                  [&batch, &spans](size_t i, size_t j)
+                  {   const std::string& chrom_i = 
+                                        batch.records[i].chrom ;
+                      const std::string& chrom_j = 
+                                        batch.records[j].chrom ;
+                      return (chrom_i < chrom_j) or
+                             ((chrom_i == chrom_j) and
+                              (spans[i].first < spans[j].first)) ;
+                  }) ;
+
+        n = order.size() ;
+        size_t first = 0 ;
+        while(first < n)
+        {   // CpGs [first,last) are fetched at once, whatever 
+            // their label
+            const std::string& chrom = 
+                                batch.records[order[first]].chrom ;
+            size_t start = spans[order[first]].first ;
+            size_t end   = spans[order[first]].second ;
+            size_t last  = first + 1 ;
+            while((last < n) and
+                  (batch.records[order[last]].chrom == chrom) and
+                  (spans[order[last]].first <= end + merge_dist))
+            {   end = std::max(end, spans[order[last]].second) ;
+                last++ ;
+            }
+
+            timer.switchTo(stages::bam_fetch) ;
+            std::vector<PacBio::BAM::BamRecord> records ;
+            PacBio::BAM::GenomicInterval interval(chrom,
+                                                  start,
+                                                  end) ;
+            reader_bam.Interval(interval) ;
+            while(reader_bam.GetNext(record_bam))
+            {   records.push_back(record_bam) ; }
+            profiler.count(
+                ngsai::app::Profiler::counters::records_read,
+                records.size()) ;
+            ngsai::app::sort_by_start(records) ;
+
+            // sweep the CpGs, active contains the records 
+            // starting before the current CpG windows end 
+            // that may still overlap them
+            timer.switchTo(stages::extraction) ;
+            std::vector<size_t> active ;
+            size_t next = 0 ;
+            for( ; first<last; first++)
+            {   size_t i = order[first] ;
+                int32_t span_start = spans[i].first ;
+                int32_t span_stop  = spans[i].second ;
+                ngsai::app::sweep_records(records,
+                                          span_start,
+                                          span_stop,
+                                          next,
+                                          active) ;
+
+                // the tables of the CpG label
+                size_t from = batch.labels[i] * n_per_label ;
+                size_t to   = from + n_per_label ;
+                std::pair<size_t,size_t> span ;
+                get_strand_windows(batch.records[i],
+                                   sizes,
+                                   windows,
+                                   has_window,
+                                   span) ;
+                for(size_t j : active)
+                {   for(size_t w=0; w<2; w++)
+                    {   // the largest window the CCS covers
+                        size_t k = 0 ;
+                        while((k < sizes.size()) and
+                              ((not has_window[k][w]) or
+                               (not extractor.extract(
+                                            records[j], 
+                                            windows[k][w]))))
+                        {   k++ ; }
+                        if(k == sizes.size())
+                        {   continue ; }
+                        profiler.count(
+                            ngsai::app::Profiler::counters::windows_extracted,
+                            1) ;
+                        size_t size = sizes[k] ;
+                        const std::vector<uint16_t>& ipd = 
+                                                extractor.getIPD() ;
+                        const std::vector<uint16_t>& pwd = 
+                                                extractor.getPWD() ;
+                        std::pair<std::vector<double>,
+                                  std::vector<double>> ratios ;
+                        if(kmermap != nullptr)
+                        {   ratios = ngsai::normalize_kinetics(
+                                            extractor.getSequence(),
+                                            ipd,
+                                            pwd,
+                                            *kmermap) ;
+                        }
+                        for(size_t t=from; t<to; t++)
+                        {   const ngsai::app::KineticTable& layout = 
+                                            m_counts[t]->getLayout() ;
+                            if(layout.size() > size)
+                            {   continue ; }
+                            size_t offset = size / 2 - layout.size() / 2 ;
+                            if(layout.isNormalized())
+                            {   m_counts[t]->getIndices(
+                                        ratios.first.data() + offset,
+                                        ratios.second.data() + offset,
+                                        indices[t]) ;
+                            }
+                            else
+                            {   m_counts[t]->getIndices(
+                                                ipd.data() + offset,
+                                                pwd.data() + offset,
+                                                indices[t]) ;
+                            }
+                        }
+                    }
+                }
+
+                // the full batches are added once per CpG
+                bool full = false ;
+                for(size_t t=from; t<to; t++)
+                {   full = full or 
+                           (indices[t].size() >= count_batch_size) ; }
+                if(full)
+                {   timer.switchTo(stages::classification) ;
+                    for(size_t t=from; t<to; t++)
+                    {   if(indices[t].size() >= count_batch_size)
+                        {   m_counts[t]->add(indices[t]) ; }
+                    }
+                    timer.switchTo(stages::extraction) ;
+                }
+            }
+        }
+    }
+    timer.switchTo(stages::classification) ;
+    for(size_t t=0; t<m_counts.size(); t++)
+    {   m_counts[t]->add(indices[t]) ; }
+}
+
+
+std::string
+ngsai::app::ApplicationModelKinetic::getCheckpointPath(
+                                        size_t thread_index,
+                                        size_t n) const
+{   return m_path_out + ".ckpt." + 
+           std::to_string(thread_index) + "." + 
+           std::to_string(n) ;
+}
+
+
 int 
-ngsai::app::ApplicationModelKinetic::loadBed(
-    const std::string& path_bed)
+ngsai::app::ApplicationModelKinetic::readBed(
+                        ngsai::app::BedBatchQueue& queue,
+                        const std::set<size_t>& skip)
 {   
-   try
-    {   ngsai::BedRecord bed_record ;
-        ngsai::BedReader bed_reader(path_bed) ;
-        while(bed_reader.getNext(bed_record))
-        {   // only keep fw strand since rv have same coords 
-            // if(bed_record.strand != 
-            //         ngsai::genome::strand::FORWARD)
-            // {   continue ; }
+    int exit_code = this->getExitCodeSuccess() ;
+    try
+    {   ngsai::app::StageTimer timer(stages::bed_load) ;
 
-            // bed_record.strand = 
-            //     ngsai::genome::strand::UNORIENTED ;
-            m_cpgs.push_back(bed_record) ;
+        // the next record of each file
+        size_t n_files = m_paths_bed.size() ;
+        std::vector<std::unique_ptr<ngsai::BedReader>> readers ;
+        std::vector<ngsai::BedRecord> records(n_files) ;
+        std::vector<bool> has_record(n_files) ;
+        for(size_t i=0; i<n_files; i++)
+        {   readers.emplace_back(
+                        new ngsai::BedReader(m_paths_bed[i])) ;
+            has_record[i] = readers[i]->getNext(records[i]) ;
         }
+
+        ngsai::app::BedBatch batch ;
+        batch.index = 0 ;
+        batch.records.reserve(m_batch_size) ;
+        batch.labels.reserve(m_batch_size) ;
+        while(true)
+        {   // if the files are sorted, so are the merged 
+            // records
+            size_t next = n_files ;
+            for(size_t i=0; i<n_files; i++)
+            {   if(not has_record[i])
+                {   continue ; }
+                else if((next == n_files) or
+                        (records[i].chrom < records[next].chrom) or
+                        ((records[i].chrom == records[next].chrom) and
+                         (records[i].start < records[next].start)))
+                {   next = i ; }
+            }
+            if(next == n_files)
+            {   break ; }
+            batch.records.push_back(records[next]) ;
+            batch.labels.push_back(next) ;
+            has_record[next] = readers[next]->getNext(
+                                                records[next]) ;
+
+            if(batch.records.size() < m_batch_size)
+            {   continue ; }
+            // batches already trained before a resume
+            // are read but not trained again
+            size_t index = batch.index ;
+            if(skip.find(index) == skip.end())
+            {   queue.push(std::move(batch)) ; }
+            batch = ngsai::app::BedBatch() ;
+            batch.index = index + 1 ;
+            batch.records.reserve(m_batch_size) ;
+            batch.labels.reserve(m_batch_size) ;
+        }
+        if((not batch.records.empty()) and 
+           (skip.find(batch.index) == skip.end()))
+        {   queue.push(std::move(batch)) ; }
     }
     catch(const std::exception& e)
     {   std::cerr << "Error! could not load BED regions:"
                   << std::endl 
                   << e.what() << std::endl ;
-        return this->getExitCodeError() ;
+        exit_code = this->getExitCodeError() ;
     }
-    return this->getExitCodeSuccess() ;
+    // the threads stop once the queue is empty
+    queue.close() ;
+    return exit_code ;
 }
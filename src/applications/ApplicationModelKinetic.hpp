@@ -5,10 +5,15 @@
 
 #include <iostream>
 #include <vector>
+#include <memory>                                // std::unique_ptr
+#include <set>
 
 #include <ngsaipp/io/BedRecord.hpp>              // ngsai::BedRecord
 #include <ngsaipp/epigenetics/KmerMap.hpp>       // ngsai::KmerMap
 #include <ngsaipp/epigenetics/KineticModel.hpp>  // ngsai::KineticModel
+#include <applications/CheckpointLog.hpp>        // ngsai::app::CheckpointLog
+#include <applications/CountTable.hpp>           // ngsai::app::CountTable
+#include <applications/BedBatchQueue.hpp>        // ngsai::app::BedBatchQueue
 
 
 namespace ngsai
@@ -23,6 +28,21 @@ namespace ngsai
         class ApplicationModelKinetic : 
             public ngsai::app::ApplicationInterface
         {   
+            public:
+                /*!
+                 * \brief the number of bin increments a 
+                 * thread collects before adding them to 
+                 * the shared counts.
+                 */
+                static const size_t count_batch_size ;
+                /*!
+                 * \brief the largest distance, in bp, 
+                 * between the windows of two consecutive 
+                 * CpGs for which the CCSs are fetched at 
+                 * once with --shared.
+                 */
+                static const size_t merge_dist ;
+
             public:
                 /*!
                 * \brief Constructor.
@@ -73,13 +93,41 @@ namespace ngsai
                 loadKmerMap(const std::string& path) ;
 
                 /*!
-                 * \brief Loads the content of the BED 
-                 * file.
+                 * \brief Loads the model the training 
+                 * starts from, checks that it contains 
+                 * counts with the parameters of the models 
+                 * allocated, and uses it as the 1st 
+                 * partial model.
+                 * \param path the path to the file 
+                 * containing the model.
+                 * \return an exit code, 
+                 * getExitCodeSuccess() if it went well.
+                 */
+                int
+                loadInitModel(const std::string& path) ;
+
+                /*!
+                 * \brief Reads the BED files and pushes 
+                 * their CpGs to the worker threads by 
+                 * batches of m_batch_size, such that only 
+                 * the batches in the queue are held in 
+                 * memory. The records of several files are 
+                 * merged in coordinate order and labelled 
+                 * with the index of their file. The batches 
+                 * are indexed in file order. The queue is 
+                 * closed once the files have been read, 
+                 * even if an error occured.
+                 * \param queue the queue to push the 
+                 * batches to.
+                 * \param skip the indices of the batches 
+                 * to skip, which have already been 
+                 * trained.
                  * \return an exit code, 
                  * getExitCodeSuccess() if it went well.
                  */ 
                 int
-                loadBed(const std::string& path_bed) ;
+                readBed(ngsai::app::BedBatchQueue& queue,
+                        const std::set<size_t>& skip) ;
 
                 /*!
                  * \brief Allocates the KineticModel memory 
@@ -98,6 +146,118 @@ namespace ngsai
                 int
                 freeKineticModels() ;
 
+                /*!
+                 * \brief Sums the partial models into the 
+                 * first one with a pairwise tree 
+                 * reduction. The pairs of each level of 
+                 * the tree are summed in parallel and each 
+                 * model is freed as soon as it has been 
+                 * added.
+                 */
+                void
+                reduceKineticModels() ;
+
+                /*!
+                 * \brief Allocates the count tables shared 
+                 * by the threads, one per type of model, 
+                 * point of the parameter grid and BED 
+                 * label, for --shared.
+                 * \return an exit code, 
+                 * getExitCodeSuccess() if it went well.
+                 */
+                int
+                allocateCountTable() ;
+
+                /*!
+                 * \brief Trains a single model of each type 
+                 * shared by all the threads and saves them 
+                 * as KineticTables.
+                 * \return an exit code, 
+                 * getExitCodeSuccess() if it went well.
+                 */
+                int
+                trainShared() ;
+
+                /*!
+                 * \brief The training routine ran by each 
+                 * worker thread with --shared. The CpGs of 
+                 * the batches popped from the queue are 
+                 * swept in coordinate order and the CCSs 
+                 * overlapping groups of nearby CpGs, of 
+                 * any label, are fetched once. The 
+                 * kinetics of each CCS are extracted once 
+                 * per strand, with the largest size whose 
+                 * window the CCS covers, binned for each 
+                 * type of model and point of the parameter 
+                 * grid of the CpG label with this size or 
+                 * a smaller one, on the central part of 
+                 * the window of the model size, and added 
+                 * to the shared counts by 
+                 * batches of at least count_batch_size, 
+                 * checked after each CpG.
+                 * \param queue the queue of CpG batches.
+                 */
+                void
+                trainSharedRoutine(
+                        ngsai::app::BedBatchQueue& queue) ;
+
+                /*!
+                 * \brief Trains, for each table saved by 
+                 * trainShared(), a KineticModel of the 
+                 * same type and parameters on the same 
+                 * BED file with train_KineticModel(), 
+                 * compiles it into a KineticTable and 
+                 * reports the maximum absolute difference 
+                 * with the saved table on stderr.
+                 * \return an exit code, 
+                 * getExitCodeSuccess() if all the tables 
+                 * are equal to the reference ones.
+                 */
+                int
+                checkShared() ;
+
+                /*!
+                 * \brief The training routine ran by each 
+                 * worker thread. The thread model is 
+                 * trained on the batches of CpGs popped 
+                 * from the queue until it is closed and 
+                 * empty. If a checkpoint log is given, 
+                 * the partial model is saved after a batch
+                 * once m_ckpt_time seconds have passed 
+                 * since the previous save, and then the 
+                 * batches it contains since the previous 
+                 * save are recorded in the log, in a 
+                 * single entry.
+                 * \param thread_index the index of the 
+                 * thread and of its model.
+                 * \param queue the queue of CpG batches.
+                 * \param checkpoint the checkpoint log, 
+                 * nullptr for none.
+                 * \param n_batches the number of batches 
+                 * in the last saved partial model, it is 
+                 * updated at each save.
+                 */
+                void
+                trainRoutine(
+                    size_t thread_index,
+                    ngsai::app::BedBatchQueue& queue,
+                    ngsai::app::CheckpointLog* checkpoint,
+                    size_t& n_batches) ;
+
+                /*!
+                 * \brief Returns the path to the file 
+                 * containing the partial model of a 
+                 * thread saved at a checkpoint.
+                 * \param thread_index the index of the 
+                 * thread.
+                 * \param n the number of batches the 
+                 * partial model was trained on.
+                 * \return the path.
+                 */
+                std::string
+                getCheckpointPath(size_t thread_index,
+                                  size_t n) const ;
+
             protected:
                 /*!
                  * \brief An enumeration indicating the 
@@ -110,12 +270,44 @@ namespace ngsai
                                   diposition_norm,
                                   pairwise,
                                   pairwise_norm} ;
+
+                /*!
+                 * \brief The size and binning of a model, 
+                 * a point of the parameter grid.
+                 */
+                struct parameters
+                {   size_t size ;
+                    size_t nb_bins ;
+                    double xmin ;
+                    double xmax ;
+                } ;
+
+                /*!
+                 * \brief Creates an empty KineticModel of 
+                 * a given type.
+                 * \param mode the type of model.
+                 * \param kmermap the background model of 
+                 * the normalized types, it is copied. It 
+                 * is not used for the other types and may 
+                 * be nullptr.
+                 * \return the model, owned by the caller, 
+                 * or nullptr if the type is undefined.
+                 */
+                ngsai::KineticModel*
+                newKineticModel(modes mode,
+                                const ngsai::KmerMap* kmermap) const ;
             protected:
                 /*!
                  * \brief The type of model that needs to 
                  * be trained.
                  */
                 modes m_mode ;
+                /*!
+                 * \brief The types of models trained at 
+                 * once with --shared, the first one being 
+                 * m_mode.
+                 */
+                std::vector<modes> m_modes ;
                 /*!
                  * \brief the paths to the training data.
                  */
@@ -125,6 +317,13 @@ namespace ngsai
                  * KineticModel will be serialized.
                  */
                 std::string m_path_out ;
+                /*!
+                 * \brief the path to the output file of 
+                 * each type of m_modes and BED label, in 
+                 * the order of m_counts, the first one 
+                 * being m_path_out.
+                 */
+                std::vector<std::string> m_paths_out ;
                 /*!
                  * \brief the path to the file containing 
                  * the background model to use for 
@@ -132,7 +331,8 @@ namespace ngsai
                  */
                 std::string m_path_kmermap ;
                 /*!
-                 * \brief the size of the model in bp.
+                 * \brief the size of the model in bp, the 
+                 * largest one of m_grid.
                  */
                 size_t m_size ;
                 /*!
@@ -160,10 +360,12 @@ namespace ngsai
                  */
                 size_t m_nb_threads ;
                 /*!
-                 * \brief the CpGs from which the training 
-                 * should be performed. 
+                 * \brief the paths to the BED files of the 
+                 * CpGs from which the training should be 
+                 * performed, the methylated then the 
+                 * unmethylated ones with labelled BEDs. 
                  */
-                std::vector<ngsai::BedRecord> m_cpgs ;
+                std::vector<std::string> m_paths_bed ;
                 /*!
                  * \brief the background model to use 
                  * for normalization.
@@ -174,6 +376,70 @@ namespace ngsai
                  * trained by each thread.
                  */
                 std::vector<ngsai::KineticModel*> m_models ;
+                /*!
+                 * \brief whether to save the partial 
+                 * models at checkpoints.
+                 */
+                bool m_checkpoint ;
+                /*!
+                 * \brief whether to resume from the 
+                 * last checkpoints.
+                 */
+                bool m_resume ;
+                /*!
+                 * \brief the number of CpGs in the 
+                 * batches pulled by the threads, which 
+                 * are also the checkpoint units.
+                 */
+                size_t m_batch_size ;
+                /*!
+                 * \brief the minimum time in seconds 
+                 * between two checkpoints of a thread.
+                 */
+                size_t m_ckpt_time ;
+                /*!
+                 * \brief whether all the threads train a 
+                 * single shared model.
+                 */
+                bool m_shared ;
+                /*!
+                 * \brief whether to save the counts 
+                 * trained with --shared instead of their 
+                 * log densities.
+                 */
+                bool m_save_counts ;
+                /*!
+                 * \brief whether the counts trained with 
+                 * --shared are stored sparsely.
+                 */
+                bool m_sparse ;
+                /*!
+                 * \brief whether to check the tables 
+                 * trained with --shared against models 
+                 * trained by train_KineticModel().
+                 */
+                bool m_check_shared ;
+                /*!
+                 * \brief the counts trained with --shared, 
+                 * one table per type of m_modes, point of 
+                 * m_grid and BED label, label-major then 
+                 * grid-major.
+                 */
+                std::vector<std::unique_ptr<ngsai::app::CountTable>> 
+                                                        m_counts ;
+                /*!
+                 * \brief the path to the model the 
+                 * training starts from, empty for none.
+                 */
+                std::string m_path_init ;
+                /*!
+                 * \brief the size and binning of each 
+                 * model trained with --shared, all the 
+                 * combinations of the values given to 
+                 * --size, --nbin, --xmin and --xmax in 
+                 * which xmin is smaller than xmax.
+                 */
+                std::vector<parameters> m_grid ;
         } ;
     
     }  // namespace app
@@ -0,0 +1,200 @@
+#include <applications/ApplicationModelKineticBin.hpp>
+
+#include <iostream>
+#include <string>
+#include <boost/program_options.hpp>        // variable_map, options_descriptions
+
+#include <ngsaipp/utility/string_utility.hpp>                       // ngsai::endswith()
+#include <applications/kinetic_model_utility.hpp>                   // ngsai::app::load_kinetic_model()
+#include <applications/KineticTable.hpp>                            // ngsai::app::KineticTable
+
+
+namespace po = boost::program_options ; 
+
+
+ngsai::app::ApplicationModelKineticBin::
+                ApplicationModelKineticBin(
+                                    int argc,
+                                    char** argv)
+    : ApplicationInterface(argc, argv),
+      m_model(nullptr),
+      m_path_out("")
+{   int parsing = this->parseOptions() ;
+    if(parsing == this->getExitCodeSuccess())
+    {   m_is_runnable = true ; }
+    else
+    {   m_is_runnable = false ; }
+}
+
+
+ngsai::app::ApplicationModelKineticBin::
+                ~ApplicationModelKineticBin()
+{
+    if(m_model != nullptr)
+    {   delete m_model ;
+        m_model = nullptr ;
+    }
+}
+
+
+int
+ngsai::app::ApplicationModelKineticBin::run()
+{   
+    if(not this->isRunnable())
+    {   return this->getExitCodeError() ; }
+
+    // the binary format stores log densities
+    if(not m_model->isDensity())
+    {   m_model->density() ; }
+    if(not m_model->isLog())
+    {   m_model->log() ; }
+
+    // compile and write
+    try
+    {   ngsai::app::KineticTable table = 
+                ngsai::app::KineticTable::fromModel(*m_model) ;
+        table.save(m_path_out) ;
+    }
+    catch(const std::exception& e)
+    {   std::cerr << "Error! could not convert the "
+                     "kinetic model:"
+                  << std::endl 
+                  << e.what() << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    
+    // free memory
+    if(m_model != nullptr)
+    {   delete m_model ; 
+        m_model = nullptr ;
+    }
+
+    return this->getExitCodeSuccess() ;
+}
+
+
+int 
+ngsai::app::ApplicationModelKineticBin::parseOptions()
+{   
+    // check arguments were given
+    if(m_argc == 1)
+    {   std::cerr << "Error! no options given"
+                  << std::endl ; 
+        return this->getExitCodeError() ;
+    }
+    
+    // help messages
+    std::string desc_msg =  "\n"
+                            "Usage : model-kinetic-bin [options]"
+                            "\n"
+                            "\tConverts a kinetic signal model file into a\n"
+                            "\tbinary file containing its log densities. This\n"
+                            "\tfile can be given to predict instead of the\n"
+                            "\tmodel file and is mapped in memory without any\n"
+                            "\tparsing.\n\n" ;
+    std::string opt_help_msg   = "Produces this help message." ;
+    std::string opt_model_msg  = "The path to the file containing the kinetic\n"
+                                 "model to convert." ;
+    std::string opt_out_msg    = "The path to the file to write. Its extension\n"
+                                 "must be .binkineticmodel." ;
+
+
+    // option parser
+    std::string path_model("") ;
+    std::string path_out("") ;
+
+    po::variables_map vm ;
+    po::options_description desc(desc_msg) ;
+    desc.add_options()
+        ("help,h",  opt_help_msg.c_str())
+        ("model",   po::value<std::string>(&(path_model)), 
+                    opt_model_msg.c_str())
+        ("out",     po::value<std::string>(&(path_out)), 
+                    opt_out_msg.c_str()) ;
+    
+     // parse
+    try
+    {   po::store(po::parse_command_line(m_argc,
+                                         m_argv,
+                                         desc), vm) ;
+        po::notify(vm) ;
+    }
+    catch(std::invalid_argument& e)
+    {   std::string msg = std::string("Error! Invalid "
+                                      "option given\n") + 
+                          std::string(e.what()) ;
+        return this->getExitCodeError() ;
+    }
+    catch(...)
+    {   std::cerr << "Error! an unknown error occured while "
+                      "parsing the options" 
+                  << std::endl ; 
+        return this->getExitCodeError() ;
+    }
+
+    // display help if needed
+    bool help = vm.count("help") ;
+    if(help)
+    {   std::cout << desc << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    // check options
+    if(path_model == "")
+    {   std::cerr <<"Error! no model file given (--model)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(path_out == "")
+    {   std::cerr <<"Error! no output file given (--out)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(not ngsai::endswith(
+                    path_out,
+                    ngsai::app::KineticTable::extension))
+    {   std::cerr << "Error! the output file extension "
+                     "must be "
+                  << ngsai::app::KineticTable::extension
+                  << " (--out)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    // load model
+    if(this->loadKineticModel(path_model) != 
+            this->getExitCodeSuccess())
+    {   return this->getExitCodeError() ; }
+    if(not m_model->isInit())
+    {   std::cerr << "Error! kinetic signal model is not "
+                     "initialised"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    m_path_out = path_out ;
+
+    return this->getExitCodeSuccess() ;
+}
+
+
+int
+ngsai::app::ApplicationModelKineticBin::loadKineticModel(
+                                    const std::string& path)
+{   // ensure no model is loaded
+    if(m_model != nullptr)
+    {   delete m_model ; 
+        m_model = nullptr ;
+    }
+
+    m_model = ngsai::app::load_kinetic_model(path) ;
+    if(m_model == nullptr)
+    {   std::cerr << "Error! Could not load the "
+                  << "KineticModel in "
+                  << path
+                  << " because could not assert its type"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    return this->getExitCodeSuccess() ;
+}
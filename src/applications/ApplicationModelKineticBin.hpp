@@ -0,0 +1,89 @@
+#ifndef NGSAI_APP_APPLICATIONMODELKINETICBIN_HPP
+#define NGSAI_APP_APPLICATIONMODELKINETICBIN_HPP
+
+#include <applications/ApplicationInterface.hpp>
+
+#include <string>
+#include <ngsaipp/epigenetics/KineticModel.hpp>
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief The ApplicationModelKineticBin class 
+        * creates a standalone application to convert a 
+        * kinetic model file into the binary table format 
+        * that predict can map in memory.
+        */
+        class ApplicationModelKineticBin : 
+                    public ApplicationInterface
+        {
+            public:
+                /*!
+                 * \brief Constructor.
+                 * Saves the argc and argv values and sets 
+                 * the app as not runnable.
+                 * \param argc the number of command line 
+                 * argument.
+                 * \param argv the command line argument 
+                 * vector.
+                 */
+                ApplicationModelKineticBin(int argc, 
+                                           char** argv) ;
+
+                /*!
+                * \brief Destructor.
+                */
+                virtual
+                ~ApplicationModelKineticBin() override ;
+                
+                /*!
+                 * \brief Runs the application, with all its
+                 * functionalities.
+                 * \return the exit code to return to the OS.
+                 */
+                virtual
+                int
+                run() override ;
+            
+            protected:
+                /*!
+                 * \brief Parses the command line options 
+                 * and sets the fields.
+                 * \return an exit code, 
+                 * getExitCodeSuccess() if it went well.
+                 */
+                virtual
+                int
+                parseOptions() override ;
+
+                /*!
+                 * \brief Loads the KineticModel stored in 
+                 * the given file.
+                 * \param path the path to the file to 
+                 * load.
+                 * \return an exit code, 
+                 * getExitCodeSuccess() if it went well.
+                 */
+                int
+                loadKineticModel(const std::string& path) ;
+
+            protected:
+                /*!
+                 * \brief the model to convert.
+                 */
+                KineticModel* m_model ;
+                /*!
+                 * \brief the path to the file to write.
+                 */
+                std::string m_path_out ;
+        } ;
+    }  // namespace app
+
+}  // namespace ngsai
+
+
+
+#endif // NGSAI_APP_APPLICATIONMODELKINETICBIN_HPP
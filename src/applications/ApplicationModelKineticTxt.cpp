@@ -7,13 +7,8 @@
 #include <fstream>
 #include <boost/program_options.hpp>        // variable_map, options_descriptions
 
-#include <ngsaipp/epigenetics/RawKineticModel.hpp>                  // ngsai::RawKineticModel
-#include <ngsaipp/epigenetics/NormalizedKineticModel.hpp>           // ngsai::NormalizedKineticModel
-#include <ngsaipp/epigenetics/PairWiseKineticModel.hpp>             // ngsai::PairWiseKineticModel
-#include <ngsaipp/epigenetics/PairWiseNormalizedKineticModel.hpp>   // ngsai::PairWiseNormalizedKineticModel
-#include <ngsaipp/epigenetics/DiPositionKineticModel.hpp>           // ngsai::DiPositionKineticModel
-#include <ngsaipp/epigenetics/DiPositionNormalizedKineticModel.hpp> // ngsai::DiPositionNormalizedKineticModel
 #include <ngsaipp/utility/string_utility.hpp>                       // ngsai::split(), ngsai::endswith()
+#include <applications/kinetic_model_utility.hpp>                   // ngsai::app::load_kinetic_model()
 
 
 namespace po = boost::program_options ; 
@@ -148,38 +143,8 @@ ngsai::app::ApplicationModelKineticTxt::loadKineticModel(
         m_model = nullptr ;
     }
 
-    if(ngsai::endswith(path, ".rawkineticmodel"))
-    {   m_model = new ngsai::RawKineticModel() ;
-        m_model->load(path) ;
-    }
-    else if(ngsai::endswith(path, 
-                    ".normalizedkineticmodel"))
-    {   m_model = new ngsai::NormalizedKineticModel() ;
-        m_model->load(path) ;
-    }
-    else if(ngsai::endswith(path,
-                    ".pairwisekineticmodel"))
-    {   m_model = new ngsai::PairWiseKineticModel() ;
-        m_model->load(path) ;
-    }
-    else if(ngsai::endswith(path,
-                    ".pairwisenormalizedkineticmodel"))
-    {   m_model = 
-            new ngsai::PairWiseNormalizedKineticModel() ;
-        m_model->load(path) ;
-    }
-    else if(ngsai::endswith(path, 
-                    ".dipositionkineticmodel"))
-    {   m_model = new ngsai::DiPositionKineticModel() ;
-        m_model->load(path) ;
-    }
-    else if(ngsai::endswith(path, 
-                    ".dipositionnormalizedkineticmodel"))
-    {   m_model = 
-            new ngsai::DiPositionNormalizedKineticModel() ;
-        m_model->load(path) ;
-    }
-    else
+    m_model = ngsai::app::load_kinetic_model(path) ;
+    if(m_model == nullptr)
     {   std::cerr << "Error! Could not load the "
                   << "KineticModel in "
                   << path
@@ -0,0 +1,368 @@
+#include <applications/ApplicationModelMerge.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <boost/program_options.hpp>        // variable_map, options_descriptions
+
+#include <ngsaipp/utility/string_utility.hpp>                       // ngsai::split(), ngsai::endswith()
+#include <applications/KineticTable.hpp>                            // ngsai::app::KineticTable
+#include <applications/kinetic_model_utility.hpp>                   // ngsai::app::have_same_parameters(), ngsai::app::new_empty_model(), ngsai::app::has_empty_bin(), ngsai::app::load_kinetic_model()
+#include <applications/Profiler.hpp>                                // ngsai::app::StageTimer
+
+
+namespace po = boost::program_options ;
+
+
+using stages = ngsai::app::Profiler::stages ;
+
+
+const size_t ngsai::app::ApplicationModelMerge::chunk_size = 1 << 22 ;
+
+
+ngsai::app::ApplicationModelMerge::
+                ApplicationModelMerge(
+                                    int argc,
+                                    char** argv)
+    : ApplicationInterface(argc, argv),
+      m_paths_model(),
+      m_path_out(""),
+      m_pseudo_counts(0.),
+      m_binary(false),
+      m_density(false),
+      m_force(false),
+      m_model(nullptr),
+      m_sum(nullptr)
+{   int parsing = this->parseOptions() ;
+    if(parsing == this->getExitCodeSuccess())
+    {   m_is_runnable = true ; }
+    else
+    {   m_is_runnable = false ; }
+}
+
+
+ngsai::app::ApplicationModelMerge::
+                ~ApplicationModelMerge()
+{   this->freeKineticModels() ; }
+
+
+int
+ngsai::app::ApplicationModelMerge::run()
+{
+    if(not this->isRunnable())
+    {   return this->getExitCodeError() ; }
+
+    if(m_binary)
+    {   return this->mergeTables() ; }
+    return this->mergeModels() ;
+}
+
+
+int
+ngsai::app::ApplicationModelMerge::parseOptions()
+{
+    // check arguments were given
+    if(m_argc == 1)
+    {   std::cerr << "Error! no options given"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    // help messages
+    std::string desc_msg =  "\n"
+                            "Usage : model-merge [options]"
+                            "\n"
+                            "\tSums partial kinetic signal models of the same\n"
+                            "\ttype, size and binning, for instance trained by\n"
+                            "\tmodel-kinetic on different nodes, into a single\n"
+                            "\tmodel. The models are either serialized models\n"
+                            "\tor tables of counts in binary format, written by\n"
+                            "\tmodel-kinetic --shared --counts. The partial\n"
+                            "\tmodels should not contain pseudo counts, they\n"
+                            "\tare added once to the sum.\n\n" ;
+    std::string opt_help_msg   = "Produces this help message." ;
+    std::string opt_model_msg  = "A coma separated list of paths to the\n"
+                                 "files containing the models to sum." ;
+    std::string opt_out_msg    = "The path to the file to write. Its extension\n"
+                                 "must be the one of the models." ;
+    std::string opt_pcnt_msg   = "A number of counts that will be added to\n"
+                                 "each bin in each histogram of the sum, by\n"
+                                 "default 0." ;
+    std::string opt_dens_msg   = "Only for tables in binary format: writes the\n"
+                                 "log densities of the sum, which predict can\n"
+                                 "load, instead of its counts." ;
+    std::string opt_force_msg  = "Only for serialized models: sums the\n"
+                                 "models even if one has no empty bin. A\n"
+                                 "model trained with pseudo counts has no\n"
+                                 "empty bin, such models are refused\n"
+                                 "otherwise." ;
+
+
+    // option parser
+    std::string path_model("") ;
+    std::string path_out("") ;
+    double pseudo_counts(0.) ;
+    bool density(false) ;
+    bool force(false) ;
+
+    po::variables_map vm ;
+    po::options_description desc(desc_msg) ;
+    desc.add_options()
+        ("help,h",      opt_help_msg.c_str())
+        ("model",       po::value<std::string>(&(path_model)),
+                        opt_model_msg.c_str())
+        ("out",         po::value<std::string>(&(path_out)),
+                        opt_out_msg.c_str())
+        ("pseudocount", po::value<double>(&(pseudo_counts)),
+                        opt_pcnt_msg.c_str())
+        ("density",     po::bool_switch(&(density)),
+                        opt_dens_msg.c_str())
+        ("force",       po::bool_switch(&(force)),
+                        opt_force_msg.c_str()) ;
+
+     // parse
+    try
+    {   po::store(po::parse_command_line(m_argc,
+                                         m_argv,
+                                         desc), vm) ;
+        po::notify(vm) ;
+    }
+    catch(std::invalid_argument& e)
+    {   std::string msg = std::string("Error! Invalid "
+                                      "option given\n") +
+                          std::string(e.what()) ;
+        return this->getExitCodeError() ;
+    }
+    catch(...)
+    {   std::cerr << "Error! an unknown error occured while "
+                      "parsing the options"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    // display help if needed
+    bool help = vm.count("help") ;
+    if(help)
+    {   std::cout << desc << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    // check options
+    std::vector<std::string> paths_model =
+                            ngsai::split(path_model, ',') ;
+    if(path_model == "")
+    {   std::cerr <<"Error! no model file given (--model)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(path_out == "")
+    {   std::cerr <<"Error! no output file given (--out)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(pseudo_counts < 0.)
+    {   std::cerr <<"Error! pseudo counts must be >= 0 "
+                    "(--pseudocount)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    // all the models and the output have the same type
+    std::string extension ;
+    size_t dot = paths_model.front().rfind('.') ;
+    if(dot != std::string::npos)
+    {   extension = paths_model.front().substr(dot) ; }
+    for(const auto& path : paths_model)
+    {   if((extension == "") or
+           (not ngsai::endswith(path, extension)))
+        {   std::cerr << "Error! the models must all have "
+                         "the same extension (--model)"
+                      << std::endl ;
+            return this->getExitCodeError() ;
+        }
+    }
+    if(not ngsai::endswith(path_out, extension))
+    {   std::cerr << "Error! the output file extension "
+                     "must be "
+                  << extension
+                  << " (--out)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    bool binary = (extension ==
+                        ngsai::app::KineticTable::extension) ;
+    if(density and (not binary))
+    {   std::cerr << "Error! only tables in binary format "
+                     "can be saved as densities (--density)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    m_paths_model = paths_model ;
+    m_path_out = path_out ;
+    m_pseudo_counts = pseudo_counts ;
+    m_binary = binary ;
+    m_density = density ;
+    m_force = force ;
+
+    return this->getExitCodeSuccess() ;
+}
+
+
+int
+ngsai::app::ApplicationModelMerge::mergeModels()
+{
+    ngsai::app::StageTimer timer(stages::model_load) ;
+    for(const auto& path : m_paths_model)
+    {   timer.switchTo(stages::model_load) ;
+        if(this->loadKineticModel(path) !=
+                this->getExitCodeSuccess())
+        {   return this->getExitCodeError() ; }
+        if(not m_model->isInit())
+        {   std::cerr << "Error! kinetic signal model in "
+                      << path
+                      << " is not initialised"
+                      << std::endl ;
+            return this->getExitCodeError() ;
+        }
+        else if(m_model->isDensity())
+        {   std::cerr << "Error! kinetic signal model in "
+                      << path
+                      << " contains densities instead of "
+                         "counts"
+                      << std::endl ;
+            return this->getExitCodeError() ;
+        }
+
+        // the sum starts from the pseudo counts
+        timer.switchTo(stages::classification) ;
+        try
+        {   // the pseudo counts would be added once per 
+            // model
+            if((not m_force) and 
+               (not ngsai::app::has_empty_bin(*m_model)))
+            {   std::cerr << "Error! kinetic signal model in "
+                          << path
+                          << " has no empty bin, it was "
+                             "probably trained with pseudo "
+                             "counts. Use --force to sum it "
+                             "anyway"
+                          << std::endl ;
+                return this->getExitCodeError() ;
+            }
+            if(m_sum == nullptr)
+            {   m_sum = ngsai::app::new_empty_model(
+                                            *m_model,
+                                            m_pseudo_counts) ;
+            }
+            if(not ngsai::app::have_same_parameters(*m_sum,
+                                                    *m_model))
+            {   std::cerr << "Error! kinetic signal model in "
+                          << path
+                          << " has a different type, size or "
+                             "binning than "
+                          << m_paths_model.front()
+                          << std::endl ;
+                return this->getExitCodeError() ;
+            }
+            m_sum->add(*m_model) ;
+        }
+        catch(const std::exception& e)
+        {   std::cerr << "Error! could not add the kinetic "
+                         "signal model in "
+                      << path << ":"
+                      << std::endl
+                      << e.what() << std::endl ;
+            return this->getExitCodeError() ;
+        }
+        delete m_model ;
+        m_model = nullptr ;
+    }
+
+    timer.switchTo(stages::output) ;
+    try
+    {   m_sum->save(m_path_out) ; }
+    catch(const std::exception& e)
+    {   std::cerr << "Error! could not save the model:"
+                  << std::endl
+                  << e.what() << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    this->freeKineticModels() ;
+
+    return this->getExitCodeSuccess() ;
+}
+
+
+int
+ngsai::app::ApplicationModelMerge::mergeTables()
+{
+    // the tables are read as they are summed
+    ngsai::app::StageTimer timer(stages::classification) ;
+    ngsai::app::KineticTable::contents contents =
+                ngsai::app::KineticTable::contents::counts ;
+    if(m_density)
+    {   contents =
+            ngsai::app::KineticTable::contents::log_densities ;
+    }
+    try
+    {   ngsai::app::KineticTable::sum(m_paths_model,
+                                      m_path_out,
+                                      contents,
+                                      m_pseudo_counts,
+                                      chunk_size) ;
+    }
+    catch(const std::exception& e)
+    {   std::cerr << "Error! could not merge the tables:"
+                  << std::endl
+                  << e.what() << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    return this->getExitCodeSuccess() ;
+}
+
+
+int
+ngsai::app::ApplicationModelMerge::loadKineticModel(
+                                    const std::string& path)
+{   // ensure no model is loaded
+    if(m_model != nullptr)
+    {   delete m_model ;
+        m_model = nullptr ;
+    }
+
+    try
+    {   m_model = ngsai::app::load_kinetic_model(path) ;
+        if(m_model == nullptr)
+        {   std::cerr << "Error! Could not load the "
+                      << "KineticModel in "
+                      << path
+                      << " because could not assert its type"
+                      << std::endl ;
+            return this->getExitCodeError() ;
+        }
+    }
+    catch(const std::exception& e)
+    {   std::cerr << "Error! Could not load the "
+                  << "KineticModel in "
+                  << path << ":"
+                  << std::endl
+                  << e.what() << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    return this->getExitCodeSuccess() ;
+}
+
+
+void
+ngsai::app::ApplicationModelMerge::freeKineticModels()
+{   if(m_model != nullptr)
+    {   delete m_model ;
+        m_model = nullptr ;
+    }
+    if(m_sum != nullptr)
+    {   delete m_sum ;
+        m_sum = nullptr ;
+    }
+}
@@ -0,0 +1,162 @@
+#ifndef NGSAI_APP_APPLICATIONMODELMERGE_HPP
+#define NGSAI_APP_APPLICATIONMODELMERGE_HPP
+
+#include <applications/ApplicationInterface.hpp>
+
+#include <string>
+#include <vector>
+#include <ngsaipp/epigenetics/KineticModel.hpp>
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief The ApplicationModelMerge class creates
+        * a standalone application that sums partial
+        * kinetic models, for instance trained by
+        * model-kinetic on different nodes, into a single
+        * model.
+        * Serialized models are loaded one after the
+        * other and added to the sum, such that at most
+        * two models are held in memory. Tables of counts
+        * in binary format are mapped in memory and
+        * summed by chunks, such that they can be larger
+        * than the memory.
+        * The pseudo counts are added once, to the sum.
+        */
+        class ApplicationModelMerge :
+                    public ApplicationInterface
+        {
+            public:
+                /*!
+                 * \brief the number of values of the
+                 * binary tables summed at once.
+                 */
+                static const size_t chunk_size ;
+
+            public:
+                /*!
+                 * \brief Constructor.
+                 * Saves the argc and argv values and sets
+                 * the app as not runnable.
+                 * \param argc the number of command line
+                 * argument.
+                 * \param argv the command line argument
+                 * vector.
+                 */
+                ApplicationModelMerge(int argc,
+                                      char** argv) ;
+
+                /*!
+                * \brief Destructor.
+                */
+                virtual
+                ~ApplicationModelMerge() override ;
+
+                /*!
+                 * \brief Runs the application, with all its
+                 * functionalities.
+                 * \return the exit code to return to the OS.
+                 */
+                virtual
+                int
+                run() override ;
+
+            protected:
+                /*!
+                 * \brief Parses the command line options
+                 * and sets the fields.
+                 * \return an exit code,
+                 * getExitCodeSuccess() if it went well.
+                 */
+                virtual
+                int
+                parseOptions() override ;
+
+                /*!
+                 * \brief Sums the serialized models one
+                 * after the other and saves the sum.
+                 * \return an exit code,
+                 * getExitCodeSuccess() if it went well.
+                 */
+                int
+                mergeModels() ;
+
+                /*!
+                 * \brief Sums the tables of counts in
+                 * binary format by chunks and saves the
+                 * sum.
+                 * \return an exit code,
+                 * getExitCodeSuccess() if it went well.
+                 */
+                int
+                mergeTables() ;
+
+                /*!
+                 * \brief Loads the KineticModel stored in
+                 * the given file in m_model.
+                 * \param path the path to the file to
+                 * load.
+                 * \return an exit code,
+                 * getExitCodeSuccess() if it went well.
+                 */
+                int
+                loadKineticModel(const std::string& path) ;
+
+                /*!
+                 * \brief Frees the models memory.
+                 */
+                void
+                freeKineticModels() ;
+
+            protected:
+                /*!
+                 * \brief the paths to the files of the
+                 * models to sum.
+                 */
+                std::vector<std::string> m_paths_model ;
+                /*!
+                 * \brief the path to the file to write.
+                 */
+                std::string m_path_out ;
+                /*!
+                 * \brief a number of counts added to each
+                 * bin of the sum.
+                 */
+                double m_pseudo_counts ;
+                /*!
+                 * \brief whether the models are tables of
+                 * counts in binary format.
+                 */
+                bool m_binary ;
+                /*!
+                 * \brief whether to save the log
+                 * densities of the summed tables instead
+                 * of their counts.
+                 */
+                bool m_density ;
+                /*!
+                 * \brief whether to sum serialized models 
+                 * without any empty bin, which otherwise 
+                 * indicate pseudo counts.
+                 */
+                bool m_force ;
+                /*!
+                 * \brief the model being added.
+                 */
+                KineticModel* m_model ;
+                /*!
+                 * \brief the sum of the models added so
+                 * far.
+                 */
+                KineticModel* m_sum ;
+        } ;
+    }  // namespace app
+
+}  // namespace ngsai
+
+
+
+#endif // NGSAI_APP_APPLICATIONMODELMERGE_HPP
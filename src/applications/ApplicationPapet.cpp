@@ -3,15 +3,22 @@
 #include <iostream>
 #include <boost/program_options.hpp>    // PacBio::BAM::variable_map, options_descriptions
 #include <unordered_map>                // std::unordered_map
+#include <cstring>                      // std::strncmp()
 
 #include <applications/ApplicationModelKinetic.hpp>
 #include <applications/ApplicationModelKineticTxt.hpp>
+#include <applications/ApplicationModelKineticBin.hpp>
+#include <applications/ApplicationModelMerge.hpp>
 #include <applications/ApplicationKinetics.hpp>
 #include <applications/ApplicationKineticsWig.hpp>
 #include <applications/ApplicationKineticsKmer.hpp>
 #include <applications/ApplicationModelSequence.hpp>
 #include <applications/ApplicationModelSequenceTxt.hpp>
 #include <applications/ApplicationPredict.hpp>
+#include <applications/ApplicationPredictMerge.hpp>
+#include <applications/ApplicationServe.hpp>
+#include <applications/ApplicationClient.hpp>
+#include <applications/Profiler.hpp>
 
 
 std::string recepe = "\n"
@@ -68,14 +75,20 @@ ngsai::app::ApplicationPapet::
       m_app_map{{app_types::undefined, "undefined"},
                 {app_types::model_kinetic,"model-kinetic"},
                 {app_types::model_kinetic_txt, "model-kinetic-txt"},
+                {app_types::model_kinetic_bin, "model-kinetic-bin"},
+                {app_types::model_merge, "model-merge"},
                 {app_types::kinetics, "kinetics"},
                 {app_types::kinetics_wig, "kinetics-wig"},
                 {app_types::kinetics_kmer, "kinetics-kmer"},
                 {app_types::model_sequence, "model-sequence"},
                 {app_types::model_sequence_txt, "model-sequence-txt"},
-                {app_types::predict, "predict"}},
+                {app_types::predict, "predict"},
+                {app_types::predict_merge, "predict-merge"},
+                {app_types::serve, "serve"},
+                {app_types::client, "client"}},
       m_app_cmd(),
-      m_app(nullptr)
+      m_app(nullptr),
+      m_path_profile()
 {   int parsing = this->parseOptions() ;
     if(parsing == this->getExitCodeSuccess())
     {   m_is_runnable = true ; }
@@ -95,7 +108,24 @@ ngsai::app::ApplicationPapet::run()
     if(not this->isRunnable())
     {   return this->getExitCodeError() ; }
 
-    return m_app->run() ;
+    int exit_code = m_app->run() ;
+
+    if(m_path_profile != "")
+    {   try
+        {   ngsai::app::Profiler::getInstance().writeReport(
+                                                m_path_profile,
+                                                m_app_cmd) ;
+        }
+        catch(const std::exception& e)
+        {   std::cerr << "Error! could not write the profiling "
+                         "report:"
+                      << std::endl
+                      << e.what() << std::endl ;
+            return this->getExitCodeError() ;
+        }
+    }
+
+    return exit_code ;
 }
 
 
@@ -123,23 +153,35 @@ ngsai::app::ApplicationPapet::parseOptions()
             "\tpapet contains the commands:\n\n"
             "\t-h --help            Displays this help message\n"
             "\t   --vaudois         Surprise\n\n"
+            "\tAny command accepts --profile <file> to write the wall and\n"
+            "\tCPU times of its stages, per thread, in a JSON report.\n\n"
             "\t%s        Creates kinetic signal models from CCSs\n\n"
             "\t%s    Dumps a kinetic signal model in txt format\n\n"
+            "\t%s    Converts a kinetic signal model in binary format\n\n"
+            "\t%s          Sums partial kinetic signal models\n\n"
             "\t%s             Extracts CCS kinetic information in txt format.\n\n"
             "\t%s         Creates WIG tracks from CCSs\n\n"
             "\t%s        Computes the per-kmer distribution of kinetic signal from CCSs\n\n"
             "\t%s       Creates DNA sequence kinetic signal models from CCSs\n\n"
             "\t%s   Dumps a DNA sequence kinetic signal model in txt format\n\n"
             "\t%s              Predicts the presence of epignetic modifications from CCSs\n\n"
+            "\t%s        Merges the outputs of predict shards\n\n"
+            "\t%s                Serves predictions over a UNIX socket with models loaded once\n\n"
+            "\t%s               Sends CpGs to a server and returns its predictions\n\n"
             "\tWritten by Romain Groux, November 2022\n\n",
             m_app_map.at(app_types::model_kinetic).c_str(),
             m_app_map.at(app_types::model_kinetic_txt).c_str(),
+            m_app_map.at(app_types::model_kinetic_bin).c_str(),
+            m_app_map.at(app_types::model_merge).c_str(),
             m_app_map.at(app_types::kinetics).c_str(),
             m_app_map.at(app_types::kinetics_wig).c_str(),
             m_app_map.at(app_types::kinetics_kmer).c_str(),
             m_app_map.at(app_types::model_sequence).c_str(),
             m_app_map.at(app_types::model_sequence_txt).c_str(),
-            m_app_map.at(app_types::predict).c_str()) ;
+            m_app_map.at(app_types::predict).c_str(),
+            m_app_map.at(app_types::predict_merge).c_str(),
+            m_app_map.at(app_types::serve).c_str(),
+            m_app_map.at(app_types::client).c_str()) ;
 
     // check if help invoked
     if((std::string(m_argv[1]) == "-h") or 
@@ -159,6 +201,11 @@ ngsai::app::ApplicationPapet::parseOptions()
     {   m_argv[i] = m_argv[i+1] ; }
     m_argc-- ;
 
+    // before the command parses its options, the 
+    // models and the CpGs are loaded there
+    if(this->parseProfile() != this->getExitCodeSuccess())
+    {   return this->getExitCodeError() ; }
+
     if(cmd == m_app_map.at(app_types::model_kinetic))
     {   m_app_cmd  = cmd ; 
         m_app = 
@@ -170,6 +217,19 @@ ngsai::app::ApplicationPapet::parseOptions()
     {   m_app_cmd  = cmd ;
         m_app = new ngsai::app::ApplicationModelKineticTxt(m_argc, m_argv) ;
     }
+    else if(cmd == m_app_map.at(
+                app_types::model_kinetic_bin))
+    {   m_app_cmd  = cmd ;
+        m_app = 
+            new ngsai::app::ApplicationModelKineticBin(
+                                        m_argc, m_argv) ;
+    }
+    else if(cmd == m_app_map.at(app_types::model_merge))
+    {   m_app_cmd  = cmd ;
+        m_app = 
+            new ngsai::app::ApplicationModelMerge(
+                                        m_argc, m_argv) ;
+    }
     else if(cmd == m_app_map.at(app_types::kinetics))
     {   m_app_cmd  = cmd ; 
         m_app = 
@@ -207,6 +267,24 @@ ngsai::app::ApplicationPapet::parseOptions()
             new ngsai::app::ApplicationPredict(
                                         m_argc, m_argv) ;
     }
+    else if(cmd == m_app_map.at(app_types::predict_merge))
+    {   m_app_cmd  = cmd ; 
+        m_app = 
+            new ngsai::app::ApplicationPredictMerge(
+                                        m_argc, m_argv) ;
+    }
+    else if(cmd == m_app_map.at(app_types::serve))
+    {   m_app_cmd  = cmd ; 
+        m_app = 
+            new ngsai::app::ApplicationServe(
+                                        m_argc, m_argv) ;
+    }
+    else if(cmd == m_app_map.at(app_types::client))
+    {   m_app_cmd  = cmd ; 
+        m_app = 
+            new ngsai::app::ApplicationClient(
+                                        m_argc, m_argv) ;
+    }
     else
     {
         std::cerr << "Error! invalid command : " 
@@ -231,6 +309,42 @@ ngsai::app::ApplicationPapet::freeApp()
 }
 
 
+int
+ngsai::app::ApplicationPapet::parseProfile()
+{
+    for(int i=1; i<m_argc; i++)
+    {   std::string arg(m_argv[i]) ;
+        int n_args = 0 ;
+        if(arg == "--profile")
+        {   if(i + 1 == m_argc)
+            {   std::cerr << "Error! no file given (--profile)"
+                          << std::endl ;
+                return this->getExitCodeError() ;
+            }
+            m_path_profile = m_argv[i+1] ;
+            n_args = 2 ;
+        }
+        else if(std::strncmp(m_argv[i], "--profile=", 10) == 0)
+        {   m_path_profile = arg.substr(10) ;
+            n_args = 1 ;
+        }
+        else
+        {   continue ; }
+
+        // the command does not know the option
+        for(int j=i; j+n_args<m_argc; j++)
+        {   m_argv[j] = m_argv[j+n_args] ; }
+        m_argc -= n_args ;
+        break ;
+    }
+
+    if(m_path_profile != "")
+    {   ngsai::app::Profiler::getInstance().enable() ; }
+
+    return this->getExitCodeSuccess() ;
+}
+
+
 int main(int argc, char** argv)
 {
     ngsai::app::ApplicationPapet app(argc, argv) ;
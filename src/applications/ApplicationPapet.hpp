@@ -75,6 +75,17 @@ namespace ngsai
                  */
                 int
                 freeApp() ;
+
+                /*!
+                 * \brief Removes the --profile option, 
+                 * common to all the commands, from the 
+                 * command line and enables the Profiler 
+                 * if it is given.
+                 * \return an exit code, 
+                 * getExitCodeSuccess() if it went well.
+                 */
+                int
+                parseProfile() ;
             
             protected:
                 /*!
@@ -84,12 +95,17 @@ namespace ngsai
                 enum class app_types {undefined,
                                       model_kinetic,
                                       model_kinetic_txt,
+                                      model_kinetic_bin,
+                                      model_merge,
                                       kinetics,
                                       kinetics_wig,
                                       kinetics_kmer,
                                       model_sequence,
                                       model_sequence_txt,
-                                      predict} ;
+                                      predict,
+                                      predict_merge,
+                                      serve,
+                                      client} ;
 
             protected:
                 /*!
@@ -110,6 +126,12 @@ namespace ngsai
                  * \brief A pointer to the app to run.
                  */
                 ngsai::app::ApplicationInterface* m_app ;
+                /*!
+                 * \brief The path to the profiling 
+                 * report, empty if the command is not 
+                 * profiled.
+                 */
+                std::string m_path_profile ;
         } ;
     
     }  // namespace app
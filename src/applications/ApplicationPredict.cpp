@@ -4,13 +4,23 @@
 #include <string>
 #include <vector>
 #include <list>
+#include <set>
+#include <unordered_map>
 #include <iomanip>
-#include <future>                          // std::promise, std::future
+#include <fstream>                         // std::ofstream
+#include <filesystem>                      // std::filesystem::exists(), std::filesystem::resize_file()
+#include <iterator>                        // std::next()
+#include <sstream>                         // std::ostringstream
+#include <algorithm>                       // std::min(), std::max(), std::sort(), std::remove_if()
+#include <cmath>                           // std::abs()
+#include <mutex>                           // std::mutex, std::lock_guard
+#include <utility>                         // std::swap()
 #include <boost/program_options.hpp>       // variable_map, options_descriptions
 #include <boost/archive/text_iarchive.hpp> // boost::archive::text_iarchive
 #include <boost/serialization/utility.hpp> // std::pair serialization
 #include <pbbam/BamFile.h>                  // PacBio::BAM::BamFile
 #include <pbbam/CompositeBamReader.h>       // PacBio::BAM::GenomicIntervalCompositeBamReader
+#include <pbbam/PbiRawData.h>               // PacBio::BAM::PbiRawData
 
 #include <ngsaipp/utility/string_utility.hpp>       // ngsai::split()
 #include <ngsaipp/epigenetics/KineticModel.hpp>
@@ -25,22 +35,66 @@
 #include <ngsaipp/genome/CpGRegion.hpp>
 #include <ngsaipp/genome/constants.hpp>
 #include <ngsaipp/parallel/ThreadPool.hpp>          // ngsai::ThreadPool
+#include <applications/ReorderBuffer.hpp>           // ngsai::app::ReorderBuffer
+#include <applications/ChunkScheduler.hpp>          // ngsai::app::ChunkScheduler
+#include <applications/CpGTable.hpp>                // ngsai::app::CpGTable
+#include <applications/utilities.hpp>               // ngsai::app::sort_by_start(), ngsai::app::sweep_records()
+#include <applications/KineticTable.hpp>            // ngsai::app::KineticTable
+#include <applications/KineticTableClassifier.hpp>  // ngsai::app::KineticTableClassifier
+#include <applications/CheckpointLog.hpp>           // ngsai::app::CheckpointLog
+#include <applications/EarlyStop.hpp>               // ngsai::app::EarlyStop
+#include <applications/WindowArena.hpp>             // ngsai::app::WindowArena
+#include <applications/Profiler.hpp>                // ngsai::app::Profiler, ngsai::app::StageTimer
 
 
 namespace po = boost::program_options ;
+using stages   = ngsai::app::Profiler::stages ;
+using counters = ngsai::app::Profiler::counters ;
+
+
+const size_t ngsai::app::ApplicationPredict::depth_bin_size = 10000 ;
 
 
 ngsai::app::ApplicationPredict::ApplicationPredict(
                         int argc,
                         char** argv)
+    : ApplicationPredict(argc, argv, true)
+{ ; }
+
+
+ngsai::app::ApplicationPredict::ApplicationPredict(
+                        int argc,
+                        char** argv,
+                        bool parse_options)
     : ApplicationInterface(argc, argv),
       m_paths_bam(),
+      m_readers_bam(),
       m_classifier(),
+      m_table_classifier(),
+      m_use_table(false),
+      m_check_table(false),
+      m_check_n(0),
+      m_check_max_diff(0.),
+      m_check_mutex(),
       m_cpgs(),
+      m_sweep(false),
+      m_tiles(),
+      m_path_out(""),
+      m_checkpoint(false),
+      m_resume(false),
+      m_shard(0),
+      m_n_shards(0),
       m_prob_meth(0.),
-      m_threads_n(0)
-{   int parsing = this->parseOptions() ;
-    if(parsing == this->getExitCodeSuccess())
+      m_threads_n(0),
+      m_chunk_size(0),
+      m_merge_dist(-1),
+      m_max_depth(0),
+      m_stop_reads(0),
+      m_stop_prob(1.)
+{   if(not parse_options)
+    {   m_is_runnable = false ; }
+    else if(this->parseOptions() == 
+                this->getExitCodeSuccess())
     {   m_is_runnable = true ; }
     else
     {   m_is_runnable = false ; }
@@ -57,73 +111,185 @@ ngsai::app::ApplicationPredict::run()
     if(not this->isRunnable())
     {   return this->getExitCodeError() ; }
 
-    // sub-sets of CpGs to treat by each thread
-    std::vector<std::pair<size_t,size_t>> slices = 
-                    ngsai::ThreadPool::split_range(0,
-                                            m_cpgs.size(),
-                                            m_threads_n) ;
-
-    // get promises and futures
-    std::vector<std::promise<std::list<double>>> 
-                                    promises(m_threads_n) ;
-    std::vector<std::future<std::list<double>>> 
-                                    futures(m_threads_n) ;
-    for(size_t i=0; i<m_threads_n; i++)
-    {   futures[i] = promises[i].get_future() ; }
+    int exit_code = this->getExitCodeSuccess() ;
+    if(m_path_out == "")
+    {   std::cout << this->getShardHeader() ;
+        exit_code = this->predict(std::cout) ;
+    }
+    else
+    {   exit_code = this->predictFile() ; }
+
+    this->reportCheck() ;
+
+    return exit_code ;
+}
+
+
+int
+ngsai::app::ApplicationPredict::predict(std::ostream& stream)
+{   return this->predict(stream, 0, 0, nullptr) ; }
+
+
+int
+ngsai::app::ApplicationPredict::predict(
+                    std::ostream& stream,
+                    size_t first,
+                    size_t n_bytes,
+                    ngsai::app::CheckpointLog* checkpoint)
+{   
+    // the BAM files are opened once per thread and 
+    // kept open
+    while(m_readers_bam.size() < m_threads_n)
+    {   m_readers_bam.emplace_back(
+            new PacBio::BAM::GenomicIntervalCompositeBamReader(
+                                                m_paths_bam)) ;
+    }
+
+    // number of chunks of CpGs
+    size_t n_chunks = this->getChunkNumber() ;
+
+    // writes the chunks on the stream, in order, as 
+    // soon as they are ready. At most 2 chunks per 
+    // thread are kept in memory
+    ngsai::app::ReorderBuffer buffer(stream,
+                                     2*m_threads_n,
+                                     first,
+                                     n_bytes,
+                                     checkpoint) ;
+
+    // distributes the chunks to the threads, idle 
+    // threads steal chunks from the busy ones
+    ngsai::app::ChunkScheduler scheduler(first,
+                                         n_chunks,
+                                         m_threads_n) ;
 
     // thread pool
     ngsai::ThreadPool threads(m_threads_n) ;
 
     // distribute to threads
+    auto routine = m_sweep ? 
+                   &ApplicationPredict::sweepRoutine :
+                   &ApplicationPredict::predictRoutine ;
+    // an exception, for instance from the BAM reading, 
+    // must not escape a worker thread. It aborts the 
+    // writing, which also releases the other threads
     for(size_t i=0; i<m_threads_n; i++)
-    {   auto slice = slices[i] ;
-        threads.addJob(
-            std::move(
-                std::bind(
-                    &ApplicationPredict::predictRoutine,
-                    this,
-                    slice.first,
-                    slice.second,
-                    std::ref(promises[i])))) ;
+    {   threads.addJob(
+            [this, routine, i, &scheduler, &buffer]()
+            {   try
+                {   (this->*routine)(i, scheduler, buffer) ; }
+                catch(const std::exception& e)
+                {   buffer.abort(e.what()) ; }
+            }) ;
     }
 
     // wait until all thread is done
     threads.join() ;
-    
-    // print results
-    for(size_t n=0; n<m_threads_n; n++)
-    {   
-        // CpG indices treated by the thread
-        const auto& slice = slices[n] ;
-        size_t from = slice.first ;
-        size_t to   = slice.second ;
-        
-        // prob of meth. computed by the thread
-        auto& future = futures[n] ;
-        std::list<double> probs = future.get() ;
-        
-        // point to 1st CpG treated by thread and 
-        // corresponding prob
-        std::list<double>::iterator prob = probs.begin() ;
-        std::list<ngsai::genome::CpGRegion>::iterator 
-            cpg = m_cpgs.begin() ;
-        std::advance(cpg, from) ;
-        
-        for(size_t i=from; i<to; i++)
-        {   std::cout 
-                << cpg->chrom << '\t'
-                << cpg->start << '\t'
-                << cpg->end   << '\t'
-                << ""         << '\t'
-                << std::setprecision(4) << *prob  << '\t'
-                << ngsai::genome::strand_to_char(cpg->strand)
-                << std::endl ;
-            cpg++ ;
-            prob++ ;
+
+    if(buffer.hasFailed())
+    {   std::cerr << "Error! could not compute or write "
+                     "the predictions:"
+                  << std::endl
+                  << buffer.getError() << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    return this->getExitCodeSuccess() ;
+}
+
+
+int
+ngsai::app::ApplicationPredict::predictFile()
+{   
+    std::unique_ptr<ngsai::app::CheckpointLog> checkpoint ;
+    size_t first   = 0 ;
+    size_t n_bytes = 0 ;
+    std::ofstream f_out ;
+
+    try
+    {   // the log only applies to the same work
+        if(m_checkpoint)
+        {   std::ostringstream header ;
+            header << "papet predict checkpoint"
+                   << " sweep="  << m_sweep
+                   << " chunks=" << this->getChunkNumber()
+                   << " chunk="  << m_chunk_size
+                   << " cpgs="   << m_cpgs.size() ;
+            checkpoint.reset(
+                new ngsai::app::CheckpointLog(
+                                    m_path_out + ".ckpt",
+                                    header.str(),
+                                    m_resume)) ;
+
+            // the last entry tells how far the output 
+            // is complete
+            const std::vector<std::string>& entries = 
+                                checkpoint->getEntries() ;
+            if(entries.size() > 0)
+            {   std::istringstream entry(entries.back()) ;
+                if(not (entry >> first >> n_bytes))
+                {   std::cerr << "Error! invalid checkpoint "
+                                 "entry : " << entries.back()
+                              << std::endl ;
+                    return this->getExitCodeError() ;
+                }
+            }
+        }
+
+        // drop the output of the chunks that were not 
+        // logged
+        if(n_bytes > 0)
+        {   if((not std::filesystem::exists(m_path_out)) or
+               (std::filesystem::file_size(m_path_out) < 
+                                                n_bytes))
+            {   std::cerr << "Error! " << m_path_out 
+                          << " is shorter than recorded in "
+                             "the checkpoint, cannot resume"
+                          << std::endl ;
+                return this->getExitCodeError() ;
+            }
+            std::filesystem::resize_file(m_path_out, n_bytes) ;
+            f_out.open(m_path_out, std::ios::app) ;
+        }
+        else
+        {   // the shard line is part of the bytes logged
+            f_out.open(m_path_out, std::ios::trunc) ;
+            std::string header = this->getShardHeader() ;
+            f_out << header ;
+            n_bytes = header.size() ;
         }
     }
+    catch(const std::exception& e)
+    {   std::cerr << "Error! could not set up the "
+                     "checkpoint:"
+                  << std::endl 
+                  << e.what() << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    if(not f_out.is_open())
+    {   std::cerr << "Error! could not open "
+                  << m_path_out << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    if(first > 0)
+    {   std::cerr << "resuming after " << first 
+                  << " chunks" << std::endl ;
+    }
 
-    return this->getExitCodeSuccess() ;
+    int exit_code = this->predict(f_out,
+                                  first,
+                                  n_bytes,
+                                  checkpoint.get()) ;
+    f_out.close() ;
+    return exit_code ;
+}
+
+
+size_t
+ngsai::app::ApplicationPredict::getChunkNumber() const
+{   if(m_sweep)
+    {   return m_tiles.size() ; }
+    return (m_cpgs.size() + m_chunk_size - 1) / 
+           m_chunk_size ;
 }
 
 
@@ -147,45 +313,68 @@ ngsai::app::ApplicationPredict::parseOptions()
                             "\tprobability.\n"
                             "\tWritten by Romain Groux, October 2022\n\n" ;
     std::string opt_help_msg  = "Produces this help message." ;
-    std::string opt_bam_msg = "A coma separated list of paths to the bam\n"
-                              "files containing the mapped PacBio CCS of\n"
-                              "interest." ;
     std::string opt_bed_msg = "The path to a bed file containing the\n" 
                               "coordinates of the CpGs interest.";
-    std::string opt_model_meth_msg     = "The path to the file containing the\n"
-                                        "methylated kinetic model to use." ;
-    std::string opt_model_unmeth_msg  = "The path to the file containing the\n"
-                                        "unmethylated kinetic model to use." ;
-    std::string opt_prob_msg  = "The prior probability of methylation\n"
-                                 "for any CpG. It must belong to [0,1].\n" 
-                                 "0.5 by default.";
-    std::string opt_thread_msg = "The number of threads, by default 1." ;
+    std::string opt_sweep_msg  = "Predicts all the CpGs found in the CCSs\n"
+                                 "instead of those of a BED file, in a\n"
+                                 "single sweep of the coordinate sorted\n"
+                                 "bam files. The genome is processed by\n"
+                                 "tiles, over the sequences of all the bam\n"
+                                 "headers in the order they are first\n"
+                                 "listed. --chunk and --merge do not apply." ;
+    std::string opt_tile_msg   = "The size in bp of the tiles processed as\n"
+                                 "one unit of work by --sweep. By default\n"
+                                 "1000000." ;
+    std::string opt_out_msg    = "The path to the file in which the\n"
+                                 "predictions are written. By default, they\n"
+                                 "are written on stdout." ;
+    std::string opt_ckpt_msg   = "Records the chunks written in the log\n"
+                                 "file <out>.ckpt, such that the run can be\n"
+                                 "resumed. Requires --out." ;
+    std::string opt_resume_msg = "Resumes an interrupted run after the last\n"
+                                 "chunk recorded in <out>.ckpt, the output\n"
+                                 "written after it is discarded. The other\n"
+                                 "options must be those of the interrupted\n"
+                                 "run. Implies --checkpoint." ;
+    std::string opt_shard_msg  = "Processes only the shard i out of N, in\n"
+                                 "the format i/N with i in [1,N]. The\n"
+                                 "chunks, or the tiles, are cut into N\n"
+                                 "shards of similar read counts estimated\n"
+                                 "from the PacBio bam indices. The output\n"
+                                 "starts with a \"# shard i/N\" line, the\n"
+                                 "shard outputs can be merged with\n"
+                                 "predict-merge." ;
 
 
     // option parser
-    std::string path_bam("") ;
+    PredictOptions options ;
     std::string path_bed("") ;
-    std::string path_mod_m("") ;
-    std::string path_mod_u("") ;
-    double prob_meth = 0.5 ;
-    size_t n_threads(1) ;
+    bool sweep(false) ;
+    size_t tile_size(1000000) ;
+    std::string shard_str("") ;
+    std::string path_out("") ;
+    bool checkpoint(false) ;
+    bool resume(false) ;
 
     po::variables_map vm ;
     po::options_description desc(desc_msg) ;
     desc.add_options()
         ("help,h",      opt_help_msg.c_str())
-        ("bam",         po::value<std::string>(&(path_bam)), 
-                        opt_bam_msg.c_str())
         ("bed",         po::value<std::string>(&(path_bed)), 
                         opt_bed_msg.c_str())
-        ("modelMeth",   po::value<std::string>(&(path_mod_m)), 
-                        opt_model_meth_msg.c_str())
-        ("modelUnmeth", po::value<std::string>(&(path_mod_u)), 
-                        opt_model_unmeth_msg.c_str())
-        ("prob",        po::value<double>(&(prob_meth)), 
-                        opt_prob_msg.c_str())
-        ("thread",      po::value<size_t>(&(n_threads)), 
-                        opt_thread_msg.c_str()) ;
+        ("sweep",       po::bool_switch(&(sweep)), 
+                        opt_sweep_msg.c_str())
+        ("tile",        po::value<size_t>(&(tile_size)), 
+                        opt_tile_msg.c_str())
+        ("shard",       po::value<std::string>(&(shard_str)), 
+                        opt_shard_msg.c_str())
+        ("out",         po::value<std::string>(&(path_out)), 
+                        opt_out_msg.c_str())
+        ("checkpoint",  po::bool_switch(&(checkpoint)), 
+                        opt_ckpt_msg.c_str())
+        ("resume",      po::bool_switch(&(resume)), 
+                        opt_resume_msg.c_str()) ;
+    desc.add(getPredictOptions(options)) ;
     
     // parse
     try
@@ -214,56 +403,293 @@ ngsai::app::ApplicationPredict::parseOptions()
         return this->getExitCodeError() ;
     }
 
+    // shard i/N, the whole work by default
+    size_t shard(1) ;
+    size_t n_shards(1) ;
+    if(shard_str != "")
+    {   std::vector<std::string> fields = 
+                            ngsai::split(shard_str, '/') ;
+        try
+        {   if(fields.size() != 2)
+            {   throw std::invalid_argument(shard_str) ; }
+            shard    = std::stoul(fields[0]) ;
+            n_shards = std::stoul(fields[1]) ;
+        }
+        catch(const std::exception& e)
+        {   shard    = 0 ;
+            n_shards = 0 ;
+        }
+    }
+
     // check options
-    if(path_bam == "")
-    {   std::cerr <<"Error! no bam file given (--bam)"
+    if(path_bed == "" and (not sweep))
+    {   std::cerr <<"Error! no bed file given (--bed or "
+                    "--sweep)"
                   << std::endl ;
         return this->getExitCodeError() ;
     }
-    else if(path_bed == "")
-    {   std::cerr <<"Error! no bed file given (--bed)"
+    else if(path_bed != "" and sweep)
+    {   std::cerr <<"Error! --bed and --sweep are "
+                    "mutually exclusive"
                   << std::endl ;
         return this->getExitCodeError() ;
     }
-    else if(path_mod_m == "")
+    else if(sweep and
+            (vm.count("chunk") or vm.count("merge")))
+    {   std::cerr << "Error! --chunk and --merge do not "
+                     "apply to --sweep, use --tile"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(tile_size == 0)
+    {   std::cerr << "Error! tile size must by > 0 "
+                     "(--tile)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if((n_shards == 0) or
+            (shard == 0) or
+            (shard > n_shards))
+    {   std::cerr << "Error! shard must be given as i/N with "
+                     "i in [1,N] (--shard)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if((checkpoint or resume) and
+            (path_out == ""))
+    {   std::cerr << "Error! checkpoints require an output "
+                     "file (--checkpoint --resume --out)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    // models, bam files and classification
+    if(this->setPredictOptions(options) !=
+       this->getExitCodeSuccess())
+    {   return this->getExitCodeError() ; }
+   
+    // load the CpG BED regions
+    if((not sweep) and
+       this->loadBed(path_bed) !=
+       this->getExitCodeSuccess())
+    {   return this->getExitCodeError() ; }
+
+    // tile the genome, all the bam files are 
+    // expected to be mapped on the same reference
+    if(sweep and
+       this->loadTiles(m_paths_bam, tile_size) !=
+       this->getExitCodeSuccess())
+    {   return this->getExitCodeError() ; }
+
+    // set remaining fields
+    m_sweep      = sweep ;
+    m_path_out   = path_out ;
+    m_checkpoint = checkpoint or resume ;
+    m_resume     = resume ;
+    if(shard_str != "")
+    {   m_shard    = shard ;
+        m_n_shards = n_shards ;
+    }
+
+    // only keep the shard of interest
+    if((n_shards > 1) and
+       this->selectShard(shard, n_shards) != 
+       this->getExitCodeSuccess())
+    {   return this->getExitCodeError() ; }
+
+    return this->getExitCodeSuccess() ;
+}
+
+
+po::options_description
+ngsai::app::ApplicationPredict::getPredictOptions(
+                                    PredictOptions& options)
+{
+    // help messages
+    std::string opt_bam_msg = "A coma separated list of paths to the bam\n"
+                              "files containing the mapped PacBio CCS of\n"
+                              "interest." ;
+    std::string opt_model_meth_msg     = "The path to the file containing the\n"
+                                        "methylated kinetic model to use. It can\n"
+                                        "be a model converted with\n"
+                                        "model-kinetic-bin, in which case --table\n"
+                                        "is implied." ;
+    std::string opt_model_unmeth_msg  = "The path to the file containing the\n"
+                                        "unmethylated kinetic model to use. It\n"
+                                        "must have the same format as the\n"
+                                        "methylated model." ;
+    std::string opt_prob_msg  = "The prior probability of methylation\n"
+                                 "for any CpG. It must belong to [0,1].\n" 
+                                 "0.5 by default.";
+    std::string opt_thread_msg = "The number of threads, by default 1." ;
+    std::string opt_chunk_msg  = "The number of consecutive CpGs processed\n"
+                                 "as one unit of work. The results are\n"
+                                 "written as soon as the chunks are done,\n"
+                                 "in the BED order. By default 1000." ;
+    std::string opt_merge_msg  = "The maximum distance in bp between two\n"
+                                 "consecutive CpGs for their CCSs to be\n"
+                                 "fetched with a single BAM query. By\n"
+                                 "default -1, the CCSs are fetched for\n"
+                                 "each CpG individually." ;
+    std::string opt_table_msg  = "Compiles the models into flat log density\n"
+                                 "tables and scores the CCSs from them.\n"
+                                 "Signal values outside of the models range\n"
+                                 "are assigned to the edge bins." ;
+    std::string opt_llr_msg    = "Fuses the compiled models into a single\n"
+                                 "log likelihood ratio table, halving the\n"
+                                 "table lookups. Implies --table. The models\n"
+                                 "must have the same layout, binning and\n"
+                                 "KmerMap." ;
+    std::string opt_check_msg  = "Also computes each prediction with the\n"
+                                 "model classifier and reports the maximum\n"
+                                 "difference with the fused predictions on\n"
+                                 "stderr. Implies --llr." ;
+    std::string opt_checkt_msg = "Also computes each prediction with the\n"
+                                 "model classifier and reports the maximum\n"
+                                 "difference with the table predictions on\n"
+                                 "stderr. Implies --table." ;
+    std::string opt_depth_msg  = "The maximum number of CCSs used per CpG.\n"
+                                 "CpGs covered by more CCSs are predicted\n"
+                                 "from a random subsample of them, which\n"
+                                 "is the same at each run. By default 0,\n"
+                                 "all the CCSs are used." ;
+    std::string opt_sreads_msg = "Classifies the CCSs of a CpG by blocks\n"
+                                 "of this size and stops once two\n"
+                                 "consecutive blocks end with the same\n"
+                                 "state past --stopProb. By default 0,\n"
+                                 "all the CCSs are classified." ;
+    std::string opt_sprob_msg  = "The posterior probability of the most\n"
+                                 "likely state past which the\n"
+                                 "classification can stop early. It must\n"
+                                 "belong to (0.5,1]. By default 0.99." ;
+
+    po::options_description desc("Prediction options") ;
+    desc.add_options()
+        ("bam",         po::value<std::string>(&(options.path_bam)), 
+                        opt_bam_msg.c_str())
+        ("modelMeth",   po::value<std::string>(&(options.path_mod_m)), 
+                        opt_model_meth_msg.c_str())
+        ("modelUnmeth", po::value<std::string>(&(options.path_mod_u)), 
+                        opt_model_unmeth_msg.c_str())
+        ("prob",        po::value<double>(&(options.prob_meth)), 
+                        opt_prob_msg.c_str())
+        ("thread",      po::value<size_t>(&(options.n_threads)), 
+                        opt_thread_msg.c_str())
+        ("chunk",       po::value<size_t>(&(options.chunk_size)), 
+                        opt_chunk_msg.c_str())
+        ("merge",       po::value<int>(&(options.merge_dist)), 
+                        opt_merge_msg.c_str())
+        ("table",       po::bool_switch(&(options.use_table)), 
+                        opt_table_msg.c_str())
+        ("llr",         po::bool_switch(&(options.use_llr)), 
+                        opt_llr_msg.c_str())
+        ("checkLlr",    po::bool_switch(&(options.check_llr)), 
+                        opt_check_msg.c_str())
+        ("checkTable",  po::bool_switch(&(options.check_table)), 
+                        opt_checkt_msg.c_str())
+        ("maxDepth",    po::value<size_t>(&(options.max_depth)), 
+                        opt_depth_msg.c_str())
+        ("stopReads",   po::value<size_t>(&(options.stop_reads)), 
+                        opt_sreads_msg.c_str())
+        ("stopProb",    po::value<double>(&(options.stop_prob)), 
+                        opt_sprob_msg.c_str()) ;
+    return desc ;
+}
+
+
+int
+ngsai::app::ApplicationPredict::setPredictOptions(
+                                const PredictOptions& options)
+{
+    // check options
+    if(options.path_bam == "")
+    {   std::cerr <<"Error! no bam file given (--bam)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(options.path_mod_m == "")
     {   std::cerr <<"Error! no methylated kinetic model "
                     "file given (--modelMeth)"
                   << std::endl ;
         return this->getExitCodeError() ;
     }
-    else if(path_mod_u == "")
+    else if(options.path_mod_u == "")
     {   std::cerr <<"Error! no unmethylated kinetic model "
                     "file given (--modelUnmeth)"
                   << std::endl ;
         return getExitCodeError() ;
     }
-    else if(prob_meth < 0. or 
-            prob_meth > 1.)
+    else if(options.prob_meth < 0. or 
+            options.prob_meth > 1.)
     {   std::cerr << "Error! prior methylation probability "
                      "must belong to [0,1] (--prob)"
                   << std::endl ;
         return this->getExitCodeError() ;
     }
-    else if(n_threads == 0)
+    else if(options.n_threads == 0)
     {   std::cerr << "Error! number of threads must by > 0 "
                      "(--thread)"
                   << std::endl ;
         return this->getExitCodeError() ;
     }
+    else if(options.chunk_size == 0)
+    {   std::cerr << "Error! chunk size must by > 0 "
+                     "(--chunk)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if((options.stop_prob <= 0.5) or
+            (options.stop_prob > 1.))
+    {   std::cerr << "Error! early stop probability must "
+                     "belong to (0.5,1] (--stopProb)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(options.merge_dist < -1)
+    {   std::cerr << "Error! merge distance must be >= -1 "
+                     "(--merge)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if((options.check_llr or options.check_table) and
+            (ngsai::endswith(
+                options.path_mod_m,
+                ngsai::app::KineticTable::extension) or
+             ngsai::endswith(
+                options.path_mod_u,
+                ngsai::app::KineticTable::extension)))
+    {   std::cerr << "Error! checking the table predictions "
+                     "requires the models in their original "
+                     "format (--checkLlr --checkTable)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
 
     // load models and transform them into log densities
-    if(this->loadModels(path_mod_m, path_mod_u) !=
-       this->getExitCodeSuccess())
-    {   return this->getExitCodeError() ; }
-   
-    // load the CpG BED regions
-    if(this->loadBed(path_bed) !=
+    // and possibly in a fused table
+    bool use_llr  = options.use_llr or options.check_llr ;
+    m_use_table   = options.use_table or use_llr or 
+                    options.check_table ;
+    m_check_table = options.check_llr or options.check_table ;
+    if(this->loadModels(options.path_mod_m,
+                        options.path_mod_u) !=
        this->getExitCodeSuccess())
     {   return this->getExitCodeError() ; }
+    if(use_llr)
+    {   try
+        {   m_table_classifier.fuse() ; }
+        catch(const std::exception& e)
+        {   std::cerr << "Error! could not fuse the "
+                         "kinetic signal models:"
+                      << std::endl 
+                      << e.what() << std::endl ;
+            return this->getExitCodeError() ;
+        }
+    }
 
     // check bam files
     std::vector<std::string> paths_bam = 
-                            ngsai::split(path_bam, ',') ;
+                        ngsai::split(options.path_bam, ',') ;
     for(const auto& path_bam : paths_bam)
     {   if(this->checkBamFile(path_bam) !=
             this->getExitCodeSuccess()) 
@@ -271,19 +697,50 @@ ngsai::app::ApplicationPredict::parseOptions()
     }
 
     // set remaining fields
-    m_paths_bam = paths_bam ;
-    m_prob_meth = prob_meth ;
-    m_threads_n = n_threads ;
+    m_paths_bam  = paths_bam ;
+    m_prob_meth  = options.prob_meth ;
+    m_threads_n  = options.n_threads ;
+    m_chunk_size = options.chunk_size ;
+    m_merge_dist = options.merge_dist ;
+    m_max_depth  = options.max_depth ;
+    m_stop_reads = options.stop_reads ;
+    m_stop_prob  = options.stop_prob ;
 
     return this->getExitCodeSuccess() ;
 }
 
 
+void
+ngsai::app::ApplicationPredict::reportCheck() const
+{   if(not m_check_table)
+    {   return ; }
+    std::lock_guard<std::mutex> lock(m_check_mutex) ;
+    std::cerr << (m_table_classifier.isFused() ?
+                    "fused LLR check : " :
+                    "table check : ")
+              << m_check_n << " CpGs, max absolute "
+              "methylation probability difference "
+              << m_check_max_diff
+              << std::endl ;
+}
+
+
 int
 ngsai::app::ApplicationPredict::loadModels(
                 const std::string& path_model_meth,
                 const std::string& path_model_unmeth)
 {  
+    ngsai::app::StageTimer timer(stages::model_load) ;
+
+    // binary models are mapped as they are
+    if(ngsai::endswith(path_model_meth,
+                       ngsai::app::KineticTable::extension) or
+       ngsai::endswith(path_model_unmeth,
+                       ngsai::app::KineticTable::extension))
+    {   return this->loadTables(path_model_meth,
+                                path_model_unmeth) ;
+    }
+
     ngsai::KineticModel* model_meth(nullptr) ;
     ngsai::KineticModel* model_unmeth(nullptr) ; 
 
@@ -408,6 +865,65 @@ ngsai::app::ApplicationPredict::loadModels(
         return this->getExitCodeError() ;
     }
 
+    // compile the models into tables
+    if(m_use_table)
+    {   try
+        {   m_table_classifier.setTables(
+                    ngsai::app::KineticTable::fromModel(
+                                                *model_meth),
+                    ngsai::app::KineticTable::fromModel(
+                                                *model_unmeth)) ;
+        }
+        catch(const std::exception& e)
+        {   std::cerr << "Error! could not compile the "
+                         "kinetic signal models into "
+                         "tables:"
+                      << std::endl 
+                      << e.what() << std::endl ;
+            return this->getExitCodeError() ;
+        }
+    }
+
+    return this->getExitCodeSuccess() ;
+}
+
+
+int
+ngsai::app::ApplicationPredict::loadTables(
+                const std::string& path_model_meth,
+                const std::string& path_model_unmeth)
+{
+    if(not (ngsai::endswith(
+                path_model_meth,
+                ngsai::app::KineticTable::extension) and
+            ngsai::endswith(
+                path_model_unmeth,
+                ngsai::app::KineticTable::extension)))
+    {   std::cerr << "Error! both kinetic models must be "
+                     "in binary format ("
+                  << ngsai::app::KineticTable::extension
+                  << ") or none"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    // the tables can only be used by the table classifier
+    m_use_table = true ;
+    try
+    {   m_table_classifier.setTables(
+                ngsai::app::KineticTable::load(
+                                    path_model_meth),
+                ngsai::app::KineticTable::load(
+                                    path_model_unmeth)) ;
+    }
+    catch(const std::exception& e)
+    {   std::cerr << "Error! could not load the binary "
+                     "kinetic signal models:"
+                  << std::endl 
+                  << e.what() << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
     return this->getExitCodeSuccess() ;
 }
 
@@ -416,6 +932,8 @@ int
 ngsai::app::ApplicationPredict::loadBed(
     const std::string& path_bed)
 {   
+    ngsai::app::StageTimer timer(stages::bed_load) ;
+
    try
     {   ngsai::BedRecord bed_record ;
         ngsai::BedReader bed_reader(path_bed) ;
@@ -425,10 +943,9 @@ ngsai::app::ApplicationPredict::loadBed(
                     ngsai::genome::strand::FORWARD)
             {   continue ; }
 
-            bed_record.strand = 
-                ngsai::genome::strand::UNORIENTED ;
-            m_cpgs.push_back(
-                ngsai::genome::CpGRegion(bed_record)) ;
+            m_cpgs.add(bed_record.chrom,
+                       bed_record.start,
+                       bed_record.end) ;
         }
     }
     catch(const std::exception& e)
@@ -441,39 +958,804 @@ ngsai::app::ApplicationPredict::loadBed(
 }
 
 
+std::string
+ngsai::app::ApplicationPredict::getShardHeader() const
+{   if(m_n_shards == 0)
+    {   return "" ; }
+    return "# shard " + std::to_string(m_shard) + "/" +
+           std::to_string(m_n_shards) + "\n" ;
+}
+
+
+int
+ngsai::app::ApplicationPredict::loadTiles(
+    const std::vector<std::string>& paths_bam,
+    size_t tile_size)
+{   
+    // the union of the reference sequences, in the order 
+    // in which they are first listed
+    std::vector<std::string> names ;
+    std::unordered_map<std::string,size_t> lengths ;
+    for(const auto& path_bam : paths_bam)
+    {   try
+        {   PacBio::BAM::BamFile bam_file(path_bam) ;
+            for(const auto& sequence : 
+                        bam_file.Header().Sequences())
+            {   size_t length = std::stoul(sequence.Length()) ;
+                auto iter = lengths.find(sequence.Name()) ;
+                if(iter == lengths.end())
+                {   names.push_back(sequence.Name()) ;
+                    lengths[sequence.Name()] = length ;
+                }
+                else if(iter->second != length)
+                {   std::cerr << "Error! reference sequence "
+                              << sequence.Name() 
+                              << " has different lengths in the "
+                                 "bam headers (" << iter->second 
+                              << " and " << length << " in "
+                              << path_bam << ")"
+                              << std::endl ;
+                    return this->getExitCodeError() ;
+                }
+            }
+        }
+        catch(const std::exception& e)
+        {   std::cerr << "Error! could not read the reference "
+                         "sequences from the header of "
+                      << path_bam << ":" << std::endl 
+                      << e.what() << std::endl ;
+            return this->getExitCodeError() ;
+        }
+    }
+
+    for(const auto& name : names)
+    {   size_t length = lengths[name] ;
+        for(size_t start=0; start<length; start+=tile_size)
+        {   size_t end = std::min(start + tile_size,
+                                  length) ;
+            m_tiles.emplace_back(name,
+                                 start,
+                                 end) ;
+        }
+    }
+    if(m_tiles.size() == 0)
+    {   std::cerr << "Error! no reference sequence listed in "
+                     "the bam headers"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    return this->getExitCodeSuccess() ;
+}
+
+
+int
+ngsai::app::ApplicationPredict::loadDepth(
+    std::unordered_map<std::string,
+                       std::vector<uint32_t>>& depth) const
+{   
+    try
+    {   for(const auto& path_bam : m_paths_bam)
+        {   PacBio::BAM::BamFile bam_file(path_bam) ;
+            const PacBio::BAM::BamHeader& header = 
+                                        bam_file.Header() ;
+            PacBio::BAM::PbiRawData index(
+                            bam_file.PacBioIndexFilename()) ;
+            if(not index.HasMappedData())
+            {   std::cerr << "Error! the PacBio index of "
+                          << path_bam << " contains no "
+                             "mapping information"
+                          << std::endl ;
+                return this->getExitCodeError() ;
+            }
+
+            // each mapped CCS counts once in each bin 
+            // it overlaps
+            const auto& mapped = index.MappedData() ;
+            for(size_t i=0; i<mapped.tId_.size(); i++)
+            {   if((mapped.tId_[i] < 0) or
+                   (mapped.tEnd_[i] <= mapped.tStart_[i]))
+                {   continue ; }
+                std::vector<uint32_t>& chrom_depth = 
+                    depth[header.SequenceName(mapped.tId_[i])] ;
+                size_t first = mapped.tStart_[i] / depth_bin_size ;
+                size_t last  = (mapped.tEnd_[i] - 1) / 
+                                                depth_bin_size ;
+                if(chrom_depth.size() <= last)
+                {   chrom_depth.resize(last + 1, 0) ; }
+                for(size_t bin=first; bin<=last; bin++)
+                {   chrom_depth[bin]++ ; }
+            }
+        }
+    }
+    catch(const std::exception& e)
+    {   std::cerr << "Error! could not read the PacBio bam "
+                     "indices:"
+                  << std::endl 
+                  << e.what() << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    return this->getExitCodeSuccess() ;
+}
+
+
+int
+ngsai::app::ApplicationPredict::selectShard(size_t shard,
+                                            size_t n_shards)
+{   
+    std::unordered_map<std::string,std::vector<uint32_t>> depth ;
+    if(this->loadDepth(depth) != this->getExitCodeSuccess())
+    {   return this->getExitCodeError() ; }
+
+    // the estimated depth at a position
+    auto getDepth = [&depth](const std::string& chrom,
+                             size_t pos) -> uint64_t
+                    {   auto iter = depth.find(chrom) ;
+                        if(iter == depth.end())
+                        {   return 0 ; }
+                        size_t bin = pos / depth_bin_size ;
+                        if(bin >= iter->second.size())
+                        {   return 0 ; }
+                        return iter->second[bin] ;
+                    } ;
+
+    // the weight of each unit of work, a CpG costs its 
+    // number of CCSs and a tile the number of CCSs in 
+    // each of its bins. Empty units still cost 1 
+    size_t n_units = m_sweep ?
+                        m_tiles.size() :
+                        (m_cpgs.size() + m_chunk_size - 1) / 
+                                                m_chunk_size ;
+    std::vector<uint64_t> weights(n_units, 0) ;
+    for(size_t n=0; n<n_units; n++)
+    {   if(m_sweep)
+        {   const std::string chrom = m_tiles[n].Name() ;
+            for(size_t pos=m_tiles[n].Start(); 
+                pos<static_cast<size_t>(m_tiles[n].Stop()); 
+                pos+=depth_bin_size)
+            {   weights[n] += 1 + getDepth(chrom, pos) ; }
+        }
+        else
+        {   size_t from = n * m_chunk_size ;
+            size_t to   = std::min(from + m_chunk_size,
+                                   m_cpgs.size()) ;
+            for(size_t i=from; i<to; i++)
+            {   weights[n] += 1 + getDepth(m_cpgs.getChrom(i),
+                                           m_cpgs.getStart(i)) ;
+            }
+        }
+    }
+    uint64_t total = 0 ;
+    for(uint64_t weight : weights)
+    {   total += weight ; }
+    if(total == 0)
+    {   total = 1 ; }
+
+    // a unit goes to the shard containing the weight 
+    // preceding it, the shards are thus consecutive 
+    // runs of units
+    std::vector<bool> keep(n_units, false) ;
+    uint64_t before = 0 ;
+    for(size_t n=0; n<n_units; n++)
+    {   size_t unit_shard = (before * n_shards) / total ;
+        keep[n] = (unit_shard + 1 == shard) ;
+        before += weights[n] ;
+    }
+
+    // keep the units of the shard only
+    if(m_sweep)
+    {   std::vector<PacBio::BAM::GenomicInterval> tiles ;
+        for(size_t n=0; n<n_units; n++)
+        {   if(keep[n])
+            {   tiles.push_back(m_tiles[n]) ; }
+        }
+        m_tiles = tiles ;
+    }
+    else
+    {   ngsai::app::CpGTable cpgs ;
+        for(size_t i=0; i<m_cpgs.size(); i++)
+        {   if(keep[i / m_chunk_size])
+            {   cpgs.add(m_cpgs.getChrom(i),
+                         m_cpgs.getStart(i),
+                         m_cpgs.getEnd(i)) ;
+            }
+        }
+        m_cpgs = cpgs ;
+    }
+
+    return this->getExitCodeSuccess() ;
+}
+
+
 void 
 ngsai::app::ApplicationPredict::predictRoutine(
-            size_t from,
-            size_t to,
-            std::promise<std::list<double>>& promise) const
+            size_t thread_index,
+            ngsai::app::ChunkScheduler& scheduler,
+            ngsai::app::ReorderBuffer& buffer) const
 {   
-    double prob_unmeth = 1. - m_prob_meth ;
+    PacBio::BAM::BamRecord record_bam ;
+    PacBio::BAM::GenomicIntervalCompositeBamReader& reader_bam = 
+                                *(m_readers_bam[thread_index]) ;
+
+    // the windows are extracted as the CCSs are read, 
+    // the arena memory is reused from one CpG to the next
+    bool use_arena = this->useArena() ;
+    size_t window_size = m_table_classifier.getTableMeth().size() ;
+    ngsai::app::WindowArena arena ;
+
+    ngsai::app::Profiler& profiler = 
+                        ngsai::app::Profiler::getInstance() ;
+    ngsai::app::StageTimer timer(stages::bam_fetch) ;
+
+    // chunks below this limit can be pushed without 
+    // waiting for the preceding ones
+    size_t n = 0 ;
+    // stop as soon as another thread failed
+    while((not buffer.hasFailed()) and
+          scheduler.getNext(thread_index, 
+                            buffer.getNextIndex() + 
+                                buffer.getCapacity(),
+                            n))
+    {   // results of this chunk in BED 6 format
+        std::ostringstream chunk ;
+        chunk << std::setprecision(4) ;
+
+        // CpGs [from,to) of this chunk
+        size_t from = n * m_chunk_size ;
+        size_t to   = std::min(from + m_chunk_size,
+                               m_cpgs.size()) ;
+        size_t i    = from ;
+        while(i < to)
+        {   // CpGs [i,last) are fetched at once
+            size_t last = this->getMergeEnd(i, to) ;
 
-    // will contain the prob of methylation of each CpG treated
-    std::list<double> probs ;
+            // a single CpG, extract overlapping CCSs
+            if(last == i + 1)
+            {   ngsai::genome::CpGRegion cpg = 
+                                    m_cpgs.getCpG(i) ;
+                PacBio::BAM::GenomicInterval interval(
+                                                cpg.chrom, 
+                                                cpg.start,
+                                                cpg.end) ;
+                timer.switchTo(stages::bam_fetch) ;
+                reader_bam.Interval(interval) ;
+                std::pair<double,double> prob ;
+                if(use_arena)
+                {   // the blocks are classified as the CCSs 
+                    // are read, the reading stops once the 
+                    // CpG is decided. The reading is timed 
+                    // with the extraction, per CpG
+                    timer.switchTo(stages::extraction) ;
+                    arena.reset(window_size,
+                                m_max_depth,
+                                getSeed(cpg)) ;
+                    size_t first = 0 ;
+                    double prob_meth = m_prob_meth ;
+                    ngsai::app::EarlyStop stop(m_stop_prob) ;
+                    bool done = false ;
+                    while((not done) and 
+                          reader_bam.GetNext(record_bam))
+                    {   profiler.count(counters::records_read, 1) ;
+                        m_table_classifier.extract(cpg,
+                                                   record_bam,
+                                                   arena) ;
+                        done = this->classifyBlocks(arena,
+                                                    false,
+                                                    first,
+                                                    prob_meth,
+                                                    stop) ;
+                    }
+                    timer.switchTo(stages::classification) ;
+                    if(not done)
+                    {   this->classifyBlocks(arena,
+                                             true,
+                                             first,
+                                             prob_meth,
+                                             stop) ;
+                    }
+                    prob = std::make_pair(prob_meth, 1. - prob_meth) ;
+                }
+                else
+                {   std::list<PacBio::BAM::BamRecord> ccss ;
+                    while(reader_bam.GetNext(record_bam))
+                    {   ccss.push_back(record_bam) ; }
+                    profiler.count(counters::records_read, ccss.size()) ;
+                    timer.switchTo(stages::classification) ;
+                    prob = this->classify(cpg, std::move(ccss)) ;
+                }
+                // the line is written within the classification
+                this->writeCpG(chunk, i, prob.first) ;
+                i++ ;
+                continue ;
+            }
 
+            // several CpGs, fetch the CCSs overlapping any
+            // of them once and dispatch them to the CpGs
+            timer.switchTo(stages::bam_fetch) ;
+            std::vector<PacBio::BAM::BamRecord> records ;
+            PacBio::BAM::GenomicInterval interval(
+                                    m_cpgs.getChrom(i), 
+                                    m_cpgs.getStart(i),
+                                    m_cpgs.getEnd(last-1)) ;
+            reader_bam.Interval(interval) ;
+            while(reader_bam.GetNext(record_bam))
+            {   records.push_back(record_bam) ; }
+            profiler.count(counters::records_read, records.size()) ;
+            ngsai::app::sort_by_start(records) ;
+
+            // sweep the CpGs, active contains the records 
+            // starting before the current CpG end that may 
+            // still overlap it
+            std::vector<size_t> active ;
+            std::vector<const PacBio::BAM::BamRecord*> ccss_arena ;
+            size_t next = 0 ;
+            for( ; i<last; i++)
+            {   int32_t start = m_cpgs.getStart(i) ;
+                int32_t end   = m_cpgs.getEnd(i) ;
+                ngsai::app::sweep_records(records,
+                                          start,
+                                          end,
+                                          next,
+                                          active) ;
+
+                ngsai::genome::CpGRegion cpg = 
+                                    m_cpgs.getCpG(i) ;
+                std::pair<double,double> prob ;
+                if(use_arena)
+                {   ccss_arena.clear() ;
+                    for(size_t j : active)
+                    {   ccss_arena.push_back(&(records[j])) ; }
+                    prob = this->classify(cpg,
+                                          ccss_arena,
+                                          arena,
+                                          timer) ;
+                }
+                else
+                {   timer.switchTo(stages::classification) ;
+                    std::list<PacBio::BAM::BamRecord> ccss ;
+                    for(size_t j : active)
+                    {   ccss.push_back(records[j]) ; }
+                    prob = this->classify(cpg, std::move(ccss)) ;
+                }
+                this->writeCpG(chunk, i, prob.first) ;
+            }
+        }
+
+        timer.switchTo(stages::output) ;
+        buffer.push(n, chunk.str()) ;
+    }
+}
+
+
+void 
+ngsai::app::ApplicationPredict::sweepRoutine(
+            size_t thread_index,
+            ngsai::app::ChunkScheduler& scheduler,
+            ngsai::app::ReorderBuffer& buffer) const
+{   
     PacBio::BAM::BamRecord record_bam ;
-    PacBio::BAM::GenomicIntervalCompositeBamReader reader_bam(m_paths_bam) ;
-
-    std::list<ngsai::genome::CpGRegion>::const_iterator cpg = m_cpgs.begin();
-    std::advance(cpg, from) ;
-    for(size_t i=from; i<to; i++)
-    {   // extract overlapping CCSs
-        std::list<PacBio::BAM::BamRecord> ccss ;
-        PacBio::BAM::GenomicInterval interval(cpg->chrom, 
-                                              cpg->start,
-                                              cpg->end) ;
+    PacBio::BAM::GenomicIntervalCompositeBamReader& reader_bam = 
+                                *(m_readers_bam[thread_index]) ;
+
+    bool use_arena = this->useArena() ;
+    ngsai::app::WindowArena arena ;
+    std::vector<const PacBio::BAM::BamRecord*> ccss_arena ;
+
+    // finding the CpGs in the CCSs is part of the fetch
+    ngsai::app::Profiler& profiler = 
+                        ngsai::app::Profiler::getInstance() ;
+    ngsai::app::StageTimer timer(stages::bam_fetch) ;
+
+    size_t n = 0 ;
+    // stop as soon as another thread failed
+    while((not buffer.hasFailed()) and
+          scheduler.getNext(thread_index, 
+                            buffer.getNextIndex() + 
+                                buffer.getCapacity(),
+                            n))
+    {   // results of this tile in BED 6 format
+        std::ostringstream chunk ;
+        chunk << std::setprecision(4) ;
+
+        // the CpGs starting in [from,to) belong to this 
+        // tile. The G of the last one is at position to, 
+        // the CCSs starting there also overlap it
+        const std::string chrom = m_tiles[n].Name() ;
+        int32_t from = m_tiles[n].Start() ;
+        int32_t to   = m_tiles[n].Stop() ;
+        PacBio::BAM::GenomicInterval interval(chrom, 
+                                              from, 
+                                              to + 1) ;
+
+        // the CCSs that may overlap an open CpG and the 
+        // positions of the open CpGs. The records are 
+        // swapped in and erased in place, never copied
+        std::list<PacBio::BAM::BamRecord> active ;
+        std::set<int32_t> sites ;
+
+        // predicts the first open CpG from the active 
+        // CCSs overlapping it and closes it
+        auto close = [&]() -> void
+        {   int32_t start = *(sites.begin()) ;
+            int32_t end   = start + 2 ;
+            ngsai::BedRecord record ;
+            record.chrom  = chrom ;
+            record.start  = start ;
+            record.end    = end ;
+            record.strand = ngsai::genome::strand::UNORIENTED ;
+            ngsai::genome::CpGRegion cpg(record) ;
+
+            std::pair<double,double> prob ;
+            if(use_arena)
+            {   ccss_arena.clear() ;
+                for(const auto& ccs : active)
+                {   if((ccs.ReferenceStart() < end) and
+                       (ccs.ReferenceEnd() > start))
+                    {   ccss_arena.push_back(&ccs) ; }
+                }
+                prob = this->classify(cpg,
+                                      ccss_arena,
+                                      arena,
+                                      timer) ;
+            }
+            else
+            {   timer.switchTo(stages::classification) ;
+                std::list<PacBio::BAM::BamRecord> ccss ;
+                for(const auto& ccs : active)
+                {   if((ccs.ReferenceStart() < end) and
+                       (ccs.ReferenceEnd() > start))
+                    {   ccss.push_back(ccs) ; }
+                }
+                prob = this->classify(cpg, std::move(ccss)) ;
+            }
+            this->writeCpG(chunk, cpg, prob.first) ;
+            sites.erase(sites.begin()) ;
+            timer.switchTo(stages::bam_fetch) ;
+        } ;
+
+        // the reader returns the CCSs by increasing 
+        // start, once the stream passed a CpG end, all 
+        // its CCSs have been seen
+        timer.switchTo(stages::bam_fetch) ;
         reader_bam.Interval(interval) ;
         while(reader_bam.GetNext(record_bam))
-        {   ccss.push_back(record_bam) ; }
-        std::pair<double,double> prob = 
-                    m_classifier.classify(*cpg, 
-                                          ccss,
-                                          m_prob_meth,
-                                          prob_unmeth) ;
-        probs.push_back(prob.first) ;
-        cpg++ ;
+        {   profiler.count(counters::records_read, 1) ;
+            if(not record_bam.IsMapped())
+            {   continue ; }
+            int32_t start = record_bam.ReferenceStart() ;
+            while((not sites.empty()) and
+                  (*(sites.begin()) + 2 <= start))
+            {   close() ; }
+
+            // the CCSs ending before the first open CpG 
+            // and the current CCS will not overlap any
+            int32_t first = sites.empty() ? 
+                                start : 
+                                std::min(*(sites.begin()), 
+                                         start) ;
+            active.remove_if(
+                        [first](const PacBio::BAM::BamRecord& ccs)
+                        {   return ccs.ReferenceEnd() <= first ; }) ;
+
+            ngsai::app::ApplicationPredict::findCpGs(
+                                                record_bam,
+                                                from,
+                                                to,
+                                                sites) ;
+            // the next record is read in a fresh one
+            active.emplace_back() ;
+            std::swap(active.back(), record_bam) ;
+        }
+        while(not sites.empty())
+        {   close() ; }
+
+        timer.switchTo(stages::output) ;
+        buffer.push(n, chunk.str()) ;
+    }
+}
+
+
+void
+ngsai::app::ApplicationPredict::findCpGs(
+                        const PacBio::BAM::BamRecord& ccs,
+                        int32_t from,
+                        int32_t to,
+                        std::set<int32_t>& sites)
+{   
+    // the sequence as stored, on the reference forward 
+    // strand and with the soft clipped bases
+    std::string seq = ccs.Sequence(
+                        PacBio::BAM::Orientation::GENOMIC) ;
+    int32_t pos_ref = ccs.ReferenceStart() ;
+    size_t  pos_seq = 0 ;
+    // whether the previous base was a C aligned to 
+    // pos_ref - 1
+    bool prev_c = false ;
+
+    for(const auto& op : ccs.CigarData())
+    {   uint32_t length = op.Length() ;
+        switch(op.Type())
+        {   case PacBio::BAM::CigarOperationType::ALIGNMENT_MATCH :
+            case PacBio::BAM::CigarOperationType::SEQUENCE_MATCH :
+            case PacBio::BAM::CigarOperationType::SEQUENCE_MISMATCH :
+            {   for(uint32_t k=0; 
+                    (k<length) and (pos_seq<seq.size()); 
+                    k++, pos_ref++, pos_seq++)
+                {   char base = seq[pos_seq] ;
+                    if(prev_c and 
+                       (base == 'G') and
+                       (pos_ref - 1 >= from) and
+                       (pos_ref - 1 < to))
+                    {   sites.insert(pos_ref - 1) ; }
+                    prev_c = (base == 'C') ;
+                }
+                break ;
+            }
+            // bases absent from the reference
+            case PacBio::BAM::CigarOperationType::INSERTION :
+            case PacBio::BAM::CigarOperationType::SOFT_CLIP :
+            {   pos_seq += length ;
+                prev_c   = false ;
+                break ;
+            }
+            // reference positions absent from the CCS
+            case PacBio::BAM::CigarOperationType::DELETION :
+            case PacBio::BAM::CigarOperationType::REFERENCE_SKIP :
+            {   pos_ref += length ;
+                prev_c   = false ;
+                break ;
+            }
+            // hard clipping and padding consume nothing
+            default :
+            {   break ; }
+        }
+    }
+}
+
+
+size_t
+ngsai::app::ApplicationPredict::getMergeEnd(size_t first,
+                                            size_t end) const
+{   
+    size_t last = first + 1 ;
+    if(m_merge_dist < 0)
+    {   return last ; }
+
+    size_t prev = first ;
+    while((last < end) and
+          (m_cpgs.getChromId(last) == 
+                m_cpgs.getChromId(prev)) and
+          (m_cpgs.getStart(last) >= m_cpgs.getStart(prev)) and
+          (m_cpgs.getStart(last) <= 
+                m_cpgs.getEnd(prev) + 
+                    static_cast<uint32_t>(m_merge_dist)))
+    {   prev = last ;
+        last++ ;
+    }
+    return last ;
+}
+
+
+std::pair<double,double>
+ngsai::app::ApplicationPredict::classify(
+            const ngsai::genome::CpGRegion& cpg,
+            std::list<PacBio::BAM::BamRecord>&& ccss) const
+{   
+    // bound the cost of deeply covered CpGs
+    if((m_max_depth > 0) and
+       (ccss.size() > m_max_depth))
+    {   this->subsample(cpg, ccss) ; }
+
+    if(m_stop_reads == 0)
+    {   return this->classify(cpg, ccss, m_prob_meth) ; }
+
+    // the CCSs are independent given the state, the 
+    // posterior of a block is thus the prior of the next 
+    // one. Stop once two consecutive block boundaries 
+    // agree on the same state
+    double prob_meth = m_prob_meth ;
+    ngsai::app::EarlyStop stop(m_stop_prob) ;
+    while(not ccss.empty())
+    {   std::list<PacBio::BAM::BamRecord> block ;
+        block.splice(block.end(),
+                     ccss,
+                     ccss.begin(),
+                     std::next(ccss.begin(),
+                               std::min(m_stop_reads,
+                                        ccss.size()))) ;
+        prob_meth = this->classify(cpg, block, prob_meth).first ;
+        if(stop.update(prob_meth))
+        {   break ; }
+    }
+    return std::make_pair(prob_meth, 1. - prob_meth) ;
+}
+
+
+std::pair<double,double>
+ngsai::app::ApplicationPredict::classify(
+            const ngsai::genome::CpGRegion& cpg,
+            const std::list<PacBio::BAM::BamRecord>& ccss,
+            double prob_meth) const
+{   double prob_unmeth = 1. - prob_meth ;
+    if(not m_use_table)
+    {   return m_classifier.classify(cpg,
+                                     ccss,
+                                     prob_meth,
+                                     prob_unmeth) ;
+    }
+
+    std::pair<double,double> prob = 
+                m_table_classifier.classify(cpg,
+                                            ccss,
+                                            prob_meth,
+                                            prob_unmeth) ;
+    if(m_check_table)
+    {   std::pair<double,double> prob_ref = 
+                m_classifier.classify(cpg,
+                                      ccss,
+                                      prob_meth,
+                                      prob_unmeth) ;
+        double diff = std::abs(prob.first - prob_ref.first) ;
+        std::lock_guard<std::mutex> lock(m_check_mutex) ;
+        m_check_n++ ;
+        m_check_max_diff = std::max(m_check_max_diff, diff) ;
+    }
+    return prob ;
+}
+
+
+std::pair<double,double>
+ngsai::app::ApplicationPredict::classify(
+            const ngsai::genome::CpGRegion& cpg,
+            const std::vector<const PacBio::BAM::BamRecord*>& ccss,
+            ngsai::app::WindowArena& arena,
+            ngsai::app::StageTimer& timer) const
+{   
+    // the number of CCSs is known, only those sampled 
+    // are extracted, the draws are those of an arena 
+    std::vector<size_t> sample = 
+            ngsai::app::WindowArena::sample(ccss.size(),
+                                            m_max_depth,
+                                            getSeed(cpg)) ;
+    arena.reset(m_table_classifier.getTableMeth().size(),
+                0,
+                0) ;
+
+    size_t block = (m_stop_reads > 0) ? 
+                        m_stop_reads : 
+                        std::max(sample.size(), size_t(1)) ;
+    size_t first = 0 ;
+    double prob_meth = m_prob_meth ;
+    ngsai::app::EarlyStop stop(m_stop_prob) ;
+    bool done = false ;
+    for(size_t i=0; (i<sample.size()) and (not done); i+=block)
+    {   timer.switchTo(stages::extraction) ;
+        size_t last = std::min(i + block, sample.size()) ;
+        for(size_t j=i; j<last; j++)
+        {   m_table_classifier.extract(cpg,
+                                       *(ccss[sample[j]]),
+                                       arena) ;
+        }
+        timer.switchTo(stages::classification) ;
+        done = this->classifyBlocks(arena,
+                                    last == sample.size(),
+                                    first,
+                                    prob_meth,
+                                    stop) ;
+    }
+    return std::make_pair(prob_meth, 1. - prob_meth) ;
+}
+
+
+bool
+ngsai::app::ApplicationPredict::classifyBlocks(
+            ngsai::app::WindowArena& arena,
+            bool complete,
+            size_t& first,
+            double& prob_meth,
+            ngsai::app::EarlyStop& stop) const
+{   
+    // a reservoir may still replace any CCS
+    if((not complete) and (m_max_depth > 0))
+    {   return false ; }
+
+    size_t n_ccss = arena.getSlotNumber() ;
+    while(first < n_ccss)
+    {   size_t last = (m_stop_reads > 0) ? 
+                        std::min(first + m_stop_reads, n_ccss) : 
+                        n_ccss ;
+        // an incomplete block waits for more CCSs
+        if((not complete) and 
+           ((m_stop_reads == 0) or (last - first < m_stop_reads)))
+        {   return false ; }
+        m_table_classifier.score(arena, first, last) ;
+        prob_meth = m_table_classifier.classify(arena,
+                                                first,
+                                                last,
+                                                prob_meth,
+                                                1. - prob_meth).first ;
+        first = last ;
+        if((m_stop_reads > 0) and stop.update(prob_meth))
+        {   return true ; }
+    }
+    return complete ;
+}
+
+
+bool
+ngsai::app::ApplicationPredict::useArena() const
+{   return m_use_table and (not m_check_table) ; }
+
+
+uint32_t
+ngsai::app::ApplicationPredict::getSeed(
+            const ngsai::genome::CpGRegion& cpg)
+{   // FNV-1a hash of the coordinates, stable across 
+    // platforms unlike std::hash
+    uint32_t seed = 2166136261u ;
+    for(char c : cpg.chrom)
+    {   seed = (seed ^ static_cast<uint8_t>(c)) * 16777619u ; }
+    for(size_t k=0; k<sizeof(uint32_t); k++)
+    {   uint8_t byte = (static_cast<uint32_t>(cpg.start) >> 
+                                                (8*k)) & 0xff ;
+        seed = (seed ^ byte) * 16777619u ;
+    }
+    return seed ;
+}
+
+
+void
+ngsai::app::ApplicationPredict::subsample(
+            const ngsai::genome::CpGRegion& cpg,
+            std::list<PacBio::BAM::BamRecord>& ccss) const
+{   
+    // the same subsample as in an arena
+    std::vector<size_t> reservoir = 
+            ngsai::app::WindowArena::sample(ccss.size(),
+                                            m_max_depth,
+                                            getSeed(cpg)) ;
+
+    // keep the sampled CCSs in their order
+    size_t i = 0 ;
+    size_t k = 0 ;
+    for(auto iter=ccss.begin(); iter!=ccss.end(); i++)
+    {   if((k < reservoir.size()) and 
+           (reservoir[k] == i))
+        {   iter++ ;
+            k++ ;
+        }
+        else
+        {   iter = ccss.erase(iter) ; }
     }
+}
+
+
+void
+ngsai::app::ApplicationPredict::writeCpG(
+                                std::ostream& stream,
+                                size_t i,
+                                double prob) const
+{   stream << m_cpgs.getChrom(i) << '\t'
+           << m_cpgs.getStart(i) << '\t'
+           << m_cpgs.getEnd(i)   << '\t'
+           << ""                 << '\t'
+           << prob               << '\t'
+           << ngsai::genome::strand_to_char(
+                ngsai::genome::strand::UNORIENTED)
+           << '\n' ;
+}
+
 
-    promise.set_value(std::move(probs)) ;
+void
+ngsai::app::ApplicationPredict::writeCpG(
+                    std::ostream& stream,
+                    const ngsai::genome::CpGRegion& cpg,
+                    double prob) const
+{   stream << cpg.chrom << '\t'
+           << cpg.start << '\t'
+           << cpg.end   << '\t'
+           << ""        << '\t'
+           << prob      << '\t'
+           << ngsai::genome::strand_to_char(
+                ngsai::genome::strand::UNORIENTED)
+           << '\n' ;
 }
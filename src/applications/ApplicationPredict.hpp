@@ -3,9 +3,28 @@
 
 #include <applications/ApplicationInterface.hpp>
 
+#include <applications/ReorderBuffer.hpp>
+#include <applications/ChunkScheduler.hpp>
+#include <applications/CpGTable.hpp>
+#include <applications/KineticTableClassifier.hpp>
+#include <applications/CheckpointLog.hpp>
+#include <applications/WindowArena.hpp>
+#include <applications/EarlyStop.hpp>
+#include <applications/Profiler.hpp>
+
 #include <string>
 #include <vector>
-#include <future>
+#include <list>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <mutex>
+#include <memory>           // std::unique_ptr
+#include <ostream>
+#include <boost/program_options/options_description.hpp>  // boost::program_options::options_description
+#include <pbbam/BamRecord.h>
+#include <pbbam/CompositeBamReader.h>
+#include <pbbam/GenomicInterval.h>
 #include <ngsaipp/epigenetics/KineticModel.hpp>
 #include <ngsaipp/epigenetics/KineticClassifier.hpp>
 #include <ngsaipp/genome/CpGRegion.hpp>
@@ -50,6 +69,122 @@ namespace ngsai
                 run() override ;
 
             protected:
+                /*!
+                 * \brief The values of the options shared 
+                 * by the commands that predict CpGs, 
+                 * predict and serve.
+                 */
+                struct PredictOptions
+                {   std::string path_bam ;
+                    std::string path_mod_m ;
+                    std::string path_mod_u ;
+                    double prob_meth  = 0.5 ;
+                    size_t n_threads  = 1 ;
+                    size_t chunk_size = 1000 ;
+                    int    merge_dist = -1 ;
+                    bool   use_table   = false ;
+                    bool   use_llr     = false ;
+                    bool   check_llr   = false ;
+                    bool   check_table = false ;
+                    size_t max_depth  = 0 ;
+                    size_t stop_reads = 0 ;
+                    double stop_prob  = 0.99 ;
+                } ;
+
+                /*!
+                 * \brief the resolution, in bp, at which 
+                 * the read depth is estimated to balance 
+                 * the shards.
+                 */
+                static const size_t depth_bin_size ;
+
+            protected:
+                /*!
+                * \brief Constructor.
+                * Saves the argc and argv values and, if 
+                * requested, parses the options. Derived 
+                * applications parse their own options and 
+                * must set the app as runnable themselves.
+                * \param argc the number of command line 
+                * argument.
+                * \param argv the command line argument 
+                * vector.
+                * \param parse_options whether to parse the 
+                * options with 
+                * ApplicationPredict::parseOptions().
+                */
+                ApplicationPredict(int argc,
+                                   char** argv,
+                                   bool parse_options) ;
+
+                /*!
+                 * \brief Computes the predictions of all 
+                 * the CpGs in m_cpgs, or of all the CpGs 
+                 * found in the CCSs if m_sweep is set, 
+                 * and writes them on the given stream, 
+                 * in BED 6 format and in the CpG order.
+                 * \param stream the stream to write on.
+                 * \return an exit code, 
+                 * getExitCodeSuccess() if it went well.
+                 */
+                int
+                predict(std::ostream& stream) ;
+
+                /*!
+                 * \brief Computes the predictions like 
+                 * predict(std::ostream&) does, starting 
+                 * at a given chunk of CpGs, or tile, and 
+                 * records the chunks written in a 
+                 * checkpoint log.
+                 * \param stream the stream to write on.
+                 * \param first the index of the first 
+                 * chunk to process.
+                 * \param n_bytes the number of bytes 
+                 * already written on the stream.
+                 * \param checkpoint the checkpoint log, 
+                 * nullptr for none.
+                 * \return an exit code, 
+                 * getExitCodeSuccess() if it went well.
+                 */
+                int
+                predict(std::ostream& stream,
+                        size_t first,
+                        size_t n_bytes,
+                        ngsai::app::CheckpointLog* checkpoint) ;
+
+                /*!
+                 * \brief Computes the predictions and 
+                 * writes them in m_path_out. If 
+                 * m_checkpoint is set, the chunks written 
+                 * are recorded in a checkpoint log and, 
+                 * if m_resume is set, the run resumes 
+                 * after the last chunk recorded in this 
+                 * log.
+                 * \return an exit code, 
+                 * getExitCodeSuccess() if it went well.
+                 */
+                int
+                predictFile() ;
+
+                /*!
+                 * \brief Returns the line starting the 
+                 * output of a shard, which predict-merge 
+                 * reads to put the shards in order.
+                 * \return "# shard i/N" and a newline, 
+                 * an empty string if the run is not 
+                 * sharded.
+                 */
+                std::string
+                getShardHeader() const ;
+
+                /*!
+                 * \brief Returns the number of chunks of 
+                 * CpGs, or of tiles if m_sweep is set.
+                 * \return the number of chunks.
+                 */
+                size_t
+                getChunkNumber() const ;
+
                 /*!
                  * \brief Parses the command line options 
                  * and sets the fields.
@@ -60,6 +195,40 @@ namespace ngsai
                 int
                 parseOptions() override ;
 
+                /*!
+                 * \brief Returns the description of the 
+                 * options shared by the commands that 
+                 * predict CpGs: the bam files, the models 
+                 * and how the CCSs are classified.
+                 * \param options where the parsed values 
+                 * are stored, it must outlive the parsing.
+                 * \return the options description, to add 
+                 * to the command description.
+                 */
+                static
+                boost::program_options::options_description
+                getPredictOptions(PredictOptions& options) ;
+
+                /*!
+                 * \brief Checks the values of the shared 
+                 * options, loads the models, checks the 
+                 * bam files and sets the corresponding 
+                 * fields.
+                 * \param options the parsed values.
+                 * \return an exit code, 
+                 * getExitCodeSuccess() if it went well.
+                 */
+                int
+                setPredictOptions(const PredictOptions& options) ;
+
+                /*!
+                 * \brief Reports on stderr the comparison 
+                 * of the table and model classifier 
+                 * predictions, if m_check_table is set.
+                 */
+                void
+                reportCheck() const ;
+
                 /*!
                  * \brief Loads the kinetic signal models 
                  * and builds the classifier.
@@ -77,6 +246,25 @@ namespace ngsai
                     const std::string& path_model_meth,
                     const std::string& path_unmodel_meth) ;
                 
+                /*!
+                 * \brief Loads kinetic signal models 
+                 * saved in binary format, by mapping them 
+                 * in memory, and builds the table 
+                 * classifier.
+                 * \param path_model_meth the path to the 
+                 * file containt the methylated kinetic 
+                 * signal model to load.
+                 * \param path_model_unmeth the path to the 
+                 * file containt the unmethylated kinetic 
+                 * signal model to load.
+                 * \return an exit code, 
+                 * getExitCodeSuccess() if it went well.
+                 */
+                int
+                loadTables(
+                    const std::string& path_model_meth,
+                    const std::string& path_model_unmeth) ;
+
                 /*!
                  * \brief Loads the content of the BED 
                  * file.
@@ -86,41 +274,412 @@ namespace ngsai
                 int
                 loadBed(const std::string& path_bed) ;
                 
+                /*!
+                 * \brief Splits the reference sequences 
+                 * listed in the headers of the BAM files 
+                 * into consecutive tiles of the given size 
+                 * and stores them in m_tiles. The sequences 
+                 * are the union of those of the headers, in 
+                 * the order in which they are first listed.
+                 * \param paths_bam the paths to the BAM 
+                 * files.
+                 * \param tile_size the tile size in bp.
+                 * \return an exit code, 
+                 * getExitCodeSuccess() if it went well.
+                 */
+                int
+                loadTiles(const std::vector<std::string>& paths_bam,
+                          size_t tile_size) ;
+
+                /*!
+                 * \brief Estimates the read depth along 
+                 * the genome from the PacBio index of the 
+                 * BAM files, without reading the records.
+                 * \param depth where the number of CCSs 
+                 * overlapping each bin of depth_bin_size 
+                 * bp is stored, for each chromosome.
+                 * \return an exit code, 
+                 * getExitCodeSuccess() if it went well.
+                 */
+                int
+                loadDepth(
+                    std::unordered_map<std::string,
+                                       std::vector<uint32_t>>& depth) 
+                    const ;
+
+                /*!
+                 * \brief Restricts the work to one shard 
+                 * out of several. The chunks of CpGs, or 
+                 * the tiles if m_sweep is set, are 
+                 * weighted by their estimated number of 
+                 * CCSs and cut into shards of consecutive 
+                 * chunks of similar weights. The shards 
+                 * only depend on the CpGs, the tiles and 
+                 * the BAM indices, such that each process 
+                 * of a cluster computes the same shards.
+                 * \param shard the index of the shard to 
+                 * keep, in [1,n_shards].
+                 * \param n_shards the number of shards.
+                 * \return an exit code, 
+                 * getExitCodeSuccess() if it went well.
+                 */
+                int
+                selectShard(size_t shard,
+                            size_t n_shards) ;
+
                 /*!
                  * \brief The prediction routine ran by 
-                 * worker threads. The predictions will 
-                 * be computed on the CpG slice [from,to).
-                 * \param from the index of the 1st CpG in 
-                 * the list to compute a prediction for.
-                 * \param to the index of the past last CpG 
-                 * in the list to compute a prediction for.
-                 * \param promise a promise to collect a 
-                 * list of methylation probabilities 
-                 * corresponding to each CpG in the range 
-                 * [from,to). The promise is filled when 
-                 * the worker thread is done.
+                 * worker threads. The CpGs are processed 
+                 * by chunks of consecutive CpGs that are 
+                 * obtained from the scheduler until none 
+                 * is left. The predictions of each chunk 
+                 * are pushed in the buffer, in BED 6 
+                 * format, as soon as the chunk is done.
+                 * \param thread_index the index of the 
+                 * worker thread, in [0,m_threads_n).
+                 * \param scheduler the scheduler 
+                 * distributing the chunks.
+                 * \param buffer the buffer in which the 
+                 * results are pushed.
                  */
                 void
                 predictRoutine(
-                    size_t from,
-                    size_t to,
-                    std::promise<std::list<double>>& promise) 
+                    size_t thread_index,
+                    ngsai::app::ChunkScheduler& scheduler,
+                    ngsai::app::ReorderBuffer& buffer) 
+                    const ;
+
+                /*!
+                 * \brief The sweep prediction routine ran 
+                 * by worker threads. The tiles are 
+                 * obtained from the scheduler until none 
+                 * is left. The CCSs overlapping a tile are 
+                 * streamed once, in coordinate order. The 
+                 * CpGs found in the CCSs are kept open 
+                 * until the stream passes them, at which 
+                 * point all their CCSs have been seen and 
+                 * they are predicted. The predictions of 
+                 * each tile are pushed in the buffer, in 
+                 * BED 6 format, as soon as the tile is 
+                 * done.
+                 * \param thread_index the index of the 
+                 * worker thread, in [0,m_threads_n).
+                 * \param scheduler the scheduler 
+                 * distributing the tiles.
+                 * \param buffer the buffer in which the 
+                 * results are pushed.
+                 */
+                void
+                sweepRoutine(
+                    size_t thread_index,
+                    ngsai::app::ChunkScheduler& scheduler,
+                    ngsai::app::ReorderBuffer& buffer) 
+                    const ;
+
+                /*!
+                 * \brief Finds the CpGs of a CCS, that is 
+                 * the C directly followed by a G in the 
+                 * CCS sequence and aligned to consecutive 
+                 * reference positions, and inserts their 
+                 * reference positions in a set.
+                 * \param ccs the mapped CCS.
+                 * \param from the first reference 
+                 * position of interest.
+                 * \param to the past last reference 
+                 * position of interest.
+                 * \param sites the set in which the 
+                 * positions of the C of the CpGs in 
+                 * [from,to) are inserted.
+                 */
+                static
+                void
+                findCpGs(const PacBio::BAM::BamRecord& ccs,
+                         int32_t from,
+                         int32_t to,
+                         std::set<int32_t>& sites) ;
+
+                /*!
+                 * \brief Finds the CpGs for which the 
+                 * CCSs can be fetched together with the 
+                 * given one. These are the CpGs following 
+                 * it on the same chromosome, each being at 
+                 * most m_merge_dist bp away from the 
+                 * previous one.
+                 * \param first the index of the first 
+                 * CpG of the group.
+                 * \param end the index of the past last 
+                 * CpG that can be included in the group.
+                 * \return the index of the past last CpG 
+                 * of the group.
+                 */
+                size_t
+                getMergeEnd(size_t first,
+                            size_t end) const ;
+
+                /*!
+                 * \brief Computes the probabilities that a 
+                 * CpG is methylated and unmethylated. 
+                 * If m_max_depth is set, at most this 
+                 * number of CCSs is used. If m_stop_reads 
+                 * is set, the CCSs are classified by 
+                 * blocks of m_stop_reads CCSs, the 
+                 * posterior of a block being the prior of 
+                 * the next one, and the classification 
+                 * stops once two consecutive block 
+                 * boundaries agree on the same state with 
+                 * a probability past m_stop_prob, see 
+                 * EarlyStop.
+                 * \param cpg the CpG of interest.
+                 * \param ccss the CCSs overlapping the 
+                 * CpG, they are consumed.
+                 * \return the posterior probabilities of 
+                 * methylation and non-methylation.
+                 */
+                std::pair<double,double>
+                classify(
+                    const ngsai::genome::CpGRegion& cpg,
+                    std::list<PacBio::BAM::BamRecord>&& ccss)
+                    const ;
+
+                /*!
+                 * \brief Computes the probabilities that a 
+                 * CpG is methylated and unmethylated given 
+                 * a prior, using the compiled model tables 
+                 * if m_use_table is set, the model 
+                 * classifier otherwise. If m_check_table is 
+                 * set, the result is also computed with 
+                 * the model classifier and the difference 
+                 * is recorded.
+                 * \param cpg the CpG of interest.
+                 * \param ccss the CCSs overlapping the CpG.
+                 * \param prob_meth the prior probability 
+                 * of methylation.
+                 * \return the posterior probabilities of 
+                 * methylation and non-methylation.
+                 */
+                std::pair<double,double>
+                classify(
+                    const ngsai::genome::CpGRegion& cpg,
+                    const std::list<PacBio::BAM::BamRecord>& ccss,
+                    double prob_meth)
                     const ;
 
+                /*!
+                 * \brief Computes the probabilities that a 
+                 * CpG is methylated and unmethylated with 
+                 * the table classifier, extracting the 
+                 * windows of its CCSs into an arena, with 
+                 * the same subsampling and early stop as 
+                 * classify(const ngsai::genome::CpGRegion&, 
+                 * std::list<PacBio::BAM::BamRecord>&&). 
+                 * The CCSs are extracted block by block 
+                 * and those past an early stop are never 
+                 * extracted nor scored.
+                 * \param cpg the CpG of interest.
+                 * \param ccss the CCSs overlapping the 
+                 * CpG.
+                 * \param arena the arena to use.
+                 * \param timer the timer, switched to the 
+                 * extraction and classification stages 
+                 * once per block.
+                 * \return the posterior probabilities of 
+                 * methylation and non-methylation.
+                 */
+                std::pair<double,double>
+                classify(
+                    const ngsai::genome::CpGRegion& cpg,
+                    const std::vector<const PacBio::BAM::BamRecord*>& ccss,
+                    ngsai::app::WindowArena& arena,
+                    ngsai::app::StageTimer& timer) const ;
+
+                /*!
+                 * \brief Scores and classifies the CCSs 
+                 * extracted into an arena, block by block 
+                 * of m_stop_reads CCSs, from a given 
+                 * position in WindowArena::getOrder(). This 
+                 * allows the CCSs to be classified as they 
+                 * are extracted.
+                 * \param arena the arena.
+                 * \param complete whether all the CCSs of 
+                 * the CpG have been extracted. If not, only 
+                 * the complete blocks are classified, and 
+                 * none if the arena subsamples the CCSs.
+                 * \param first the position of the first 
+                 * CCS not classified yet, it is updated.
+                 * \param prob_meth the prior probability 
+                 * of methylation, it is updated to the 
+                 * posterior.
+                 * \param stop the early stop of the CpG.
+                 * \return whether the classification is 
+                 * over, because it stopped early or 
+                 * because all the CCSs were classified.
+                 */
+                bool
+                classifyBlocks(ngsai::app::WindowArena& arena,
+                               bool complete,
+                               size_t& first,
+                               double& prob_meth,
+                               ngsai::app::EarlyStop& stop) const ;
+
+                /*!
+                 * \brief Indicates whether the CCSs can be 
+                 * extracted into a WindowArena as they are 
+                 * read rather than kept in a list. This is 
+                 * the case with the compiled model tables, 
+                 * unless they are compared to the models.
+                 * \return whether to use an arena.
+                 */
+                bool
+                useArena() const ;
+
+                /*!
+                 * \brief Computes the seed of the random 
+                 * generator subsampling the CCSs of a CpG, 
+                 * from its coordinates.
+                 * \param cpg the CpG of interest.
+                 * \return the seed.
+                 */
+                static
+                uint32_t
+                getSeed(const ngsai::genome::CpGRegion& cpg) ;
+
+                /*!
+                 * \brief Subsamples the CCSs of a CpG 
+                 * down to m_max_depth CCSs, with reservoir 
+                 * sampling. The random generator is seeded 
+                 * with the CpG coordinates, such that a 
+                 * CpG always gets the same subsample, 
+                 * whatever the threads, the chunks or the 
+                 * shards.
+                 * \param cpg the CpG of interest.
+                 * \param ccss the CCSs overlapping the 
+                 * CpG, in the order of the BAM files. 
+                 * The CCSs not sampled are removed, the 
+                 * others keep their order.
+                 */
+                void
+                subsample(
+                    const ngsai::genome::CpGRegion& cpg,
+                    std::list<PacBio::BAM::BamRecord>& ccss)
+                    const ;
+
+                /*!
+                 * \brief Writes the prediction of a CpG 
+                 * in BED 6 format.
+                 * \param stream the stream to write on.
+                 * \param i the index of the CpG.
+                 * \param prob the methylation probability 
+                 * of the CpG.
+                 */
+                void
+                writeCpG(std::ostream& stream,
+                         size_t i,
+                         double prob) const ;
+
+                /*!
+                 * \brief Writes the prediction of a CpG 
+                 * in BED 6 format.
+                 * \param stream the stream to write on.
+                 * \param cpg the CpG.
+                 * \param prob the methylation probability 
+                 * of the CpG.
+                 */
+                void
+                writeCpG(std::ostream& stream,
+                         const ngsai::genome::CpGRegion& cpg,
+                         double prob) const ;
+
             protected:
                 /*!
                  * \brief the paths to the bam files.
                  */
                 std::vector<std::string> m_paths_bam ;
+                /*!
+                 * \brief the BAM readers of each worker 
+                 * thread. They are opened once and reused 
+                 * by the subsequent predictions.
+                 */
+                std::vector<std::unique_ptr<
+                    PacBio::BAM::GenomicIntervalCompositeBamReader>>
+                                                m_readers_bam ;
                 /*!
                  * \brief the signal classifier.
                  */
                 ngsai::KineticClassifier m_classifier ;
                 /*!
-                 * \brief The list of CpGs to compute 
-                 * predictions from.
+                 * \brief the signal classifier using the 
+                 * models compiled into tables.
+                 */
+                ngsai::app::KineticTableClassifier m_table_classifier ;
+                /*!
+                 * \brief whether to score the CCSs with 
+                 * the compiled model tables.
+                 */
+                bool m_use_table ;
+                /*!
+                 * \brief whether to compare the table 
+                 * predictions, fused or not, to the model 
+                 * classifier predictions.
+                 */
+                bool m_check_table ;
+                /*!
+                 * \brief the number of CpGs compared when 
+                 * checking the table predictions.
+                 */
+                mutable size_t m_check_n ;
+                /*!
+                 * \brief the maximum absolute difference 
+                 * between the table and the model 
+                 * classifier methylation probabilities.
+                 */
+                mutable double m_check_max_diff ;
+                /*!
+                 * \brief protects the check results.
+                 */
+                mutable std::mutex m_check_mutex ;
+                /*!
+                 * \brief The CpGs to compute predictions 
+                 * from.
+                 */
+                ngsai::app::CpGTable m_cpgs ;
+                /*!
+                 * \brief whether to predict all the CpGs 
+                 * found in the CCSs, in a single sweep of 
+                 * the BAM files, instead of those in 
+                 * m_cpgs.
+                 */
+                bool m_sweep ;
+                /*!
+                 * \brief the genomic tiles swept, in the 
+                 * reference sequence order.
+                 */
+                std::vector<PacBio::BAM::GenomicInterval> m_tiles ;
+                /*!
+                 * \brief the path to the output file, 
+                 * empty to write on stdout.
+                 */
+                std::string m_path_out ;
+                /*!
+                 * \brief whether to record the chunks 
+                 * written in a checkpoint log.
+                 */
+                bool m_checkpoint ;
+                /*!
+                 * \brief whether to resume from the 
+                 * checkpoint log.
+                 */
+                bool m_resume ;
+                /*!
+                 * \brief the index of the shard processed, 
+                 * in [1,m_n_shards], 0 if the run is not 
+                 * sharded.
+                 */
+                size_t m_shard ;
+                /*!
+                 * \brief the number of shards, 0 if the 
+                 * run is not sharded.
                  */
-                std::list<ngsai::genome::CpGRegion> m_cpgs ;
+                size_t m_n_shards ;
                 /*!
                  * \brief the prior probability of 
                  * methylation.
@@ -130,6 +689,36 @@ namespace ngsai
                  * \brief the number of worker threads
                  */
                 size_t m_threads_n ;
+                /*!
+                 * \brief the number of CpGs in each 
+                 * chunk of work.
+                 */
+                size_t m_chunk_size ;
+                /*!
+                 * \brief the maximum distance between 
+                 * two consecutive CpGs for their CCSs to 
+                 * be fetched together, -1 to fetch each 
+                 * CpG individually.
+                 */
+                int m_merge_dist ;
+                /*!
+                 * \brief the maximum number of CCSs used 
+                 * per CpG, 0 for no limit.
+                 */
+                size_t m_max_depth ;
+                /*!
+                 * \brief the size of the blocks of CCSs 
+                 * at the boundaries of which the early 
+                 * stop of the classification of a CpG is 
+                 * decided, 0 to never stop early.
+                 */
+                size_t m_stop_reads ;
+                /*!
+                 * \brief the posterior probability of the 
+                 * most likely state past which the 
+                 * classification of a CpG may stop early.
+                 */
+                double m_stop_prob ;
         } ;
     }
 }
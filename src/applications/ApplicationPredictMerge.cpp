@@ -0,0 +1,240 @@
+#include <applications/ApplicationPredictMerge.hpp>
+
+#include <iostream>
+#include <fstream>                         // std::ifstream
+#include <string>
+#include <vector>
+#include <stdexcept>                       // std::invalid_argument, std::runtime_error
+#include <boost/program_options.hpp>       // variable_map, options_descriptions
+
+#include <ngsaipp/utility/string_utility.hpp>       // ngsai::split()
+
+
+namespace po = boost::program_options ;
+
+
+/*!
+ * \brief Reads the shard header written by predict 
+ * --shard, the first non empty line of a shard output.
+ * \param stream the stream to read from.
+ * \param path the path of the file, for the messages.
+ * \param shard a reference to store the shard index,
+ * in [1,n_shards].
+ * \param n_shards a reference to store the number of
+ * shards.
+ * \throw std::invalid_argument if the file does not
+ * start with a valid "# shard i/N" line.
+ */
+static
+void
+readShardHeader(std::istream& stream,
+                const std::string& path,
+                size_t& shard,
+                size_t& n_shards)
+{   std::string line ;
+    while(std::getline(stream, line) and line.empty())
+    { ; }
+    std::string prefix("# shard ") ;
+    bool valid = (line.compare(0, prefix.size(), prefix) == 0) ;
+    if(valid)
+    {   std::vector<std::string> fields = 
+                ngsai::split(line.substr(prefix.size()), '/') ;
+        try
+        {   valid = (fields.size() == 2) ;
+            if(valid)
+            {   shard    = std::stoul(fields[0]) ;
+                n_shards = std::stoul(fields[1]) ;
+                valid    = (shard >= 1) and (shard <= n_shards) ;
+            }
+        }
+        catch(const std::exception& e)
+        {   valid = false ; }
+    }
+    if(not valid)
+    {   throw std::invalid_argument(
+                    path + " does not start with a valid "
+                    "\"# shard i/N\" line, it was not written "
+                    "by predict --shard") ;
+    }
+}
+
+
+ngsai::app::ApplicationPredictMerge::ApplicationPredictMerge(
+                        int argc,
+                        char** argv)
+    : ApplicationInterface(argc, argv),
+      m_paths_bed()
+{   int parsing = this->parseOptions() ;
+    if(parsing == this->getExitCodeSuccess())
+    {   m_is_runnable = true ; }
+    else
+    {   m_is_runnable = false ; }
+}
+
+
+ngsai::app::ApplicationPredictMerge::~ApplicationPredictMerge()
+{ ; }
+
+
+int
+ngsai::app::ApplicationPredictMerge::run()
+{
+    if(not this->isRunnable())
+    {   return this->getExitCodeError() ; }
+
+    try
+    {   ngsai::app::ApplicationPredictMerge::mergeShards(
+                                                m_paths_bed,
+                                                std::cout) ;
+    }
+    catch(const std::exception& e)
+    {   std::cerr << "Error! could not merge the BED "
+                     "files:"
+                  << std::endl
+                  << e.what() << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    std::cout.flush() ;
+
+    return this->getExitCodeSuccess() ;
+}
+
+
+void
+ngsai::app::ApplicationPredictMerge::mergeShards(
+                    const std::vector<std::string>& paths_bed,
+                    std::ostream& stream)
+{
+    // the file of each shard, all the shards of the
+    // same run must be there exactly once
+    std::vector<std::string> paths_shard ;
+    size_t n_shards(0) ;
+    for(const auto& path_bed : paths_bed)
+    {   std::ifstream file(path_bed) ;
+        if(not file.is_open())
+        {   throw std::runtime_error("could not open " + 
+                                     path_bed) ;
+        }
+        size_t shard(0) ;
+        size_t n(0) ;
+        readShardHeader(file, path_bed, shard, n) ;
+        if(paths_shard.empty())
+        {   n_shards = n ;
+            paths_shard.resize(n_shards) ;
+        }
+        else if(n != n_shards)
+        {   throw std::invalid_argument(
+                        path_bed + " is a shard out of " + 
+                        std::to_string(n) + " but " + 
+                        paths_bed.front() + " is out of " +
+                        std::to_string(n_shards)) ;
+        }
+        if(paths_shard[shard-1] != "")
+        {   throw std::invalid_argument(
+                        paths_shard[shard-1] + " and " + 
+                        path_bed + " are both shard " +
+                        std::to_string(shard)) ;
+        }
+        paths_shard[shard-1] = path_bed ;
+    }
+    for(size_t i=0; i<paths_shard.size(); i++)
+    {   if(paths_shard[i] == "")
+        {   throw std::invalid_argument(
+                        "shard " + std::to_string(i+1) + "/" +
+                        std::to_string(n_shards) + 
+                        " is missing") ;
+        }
+    }
+
+    // the shards are made of consecutive chunks, 
+    // their lines are thus concatenated in shard order
+    std::string line ;
+    for(const auto& path_shard : paths_shard)
+    {   std::ifstream file(path_shard) ;
+        if(not file.is_open())
+        {   throw std::runtime_error("could not open " + 
+                                     path_shard) ;
+        }
+        size_t shard(0) ;
+        size_t n(0) ;
+        readShardHeader(file, path_shard, shard, n) ;
+        while(std::getline(file, line))
+        {   if(not line.empty())
+            {   stream << line << '\n' ; }
+        }
+    }
+}
+
+
+int
+ngsai::app::ApplicationPredictMerge::parseOptions()
+{
+    // check arguments were given
+    if(m_argc == 1)
+    {   std::cerr << "Error ! no options given"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    // help messages
+    std::string desc_msg =  "\n"
+                            "Usage : predict-merge [options] > [FILE]"
+                            "\n"
+                            "\tMerges the BED outputs of several predict\n"
+                            "\tshards (--shard) into a single BED file\n"
+                            "\treturned on stdout. Each output starts\n"
+                            "\twith its shard i/N, all the shards 1 to N\n"
+                            "\tmust be given exactly once, in any order.\n"
+                            "\tThey are concatenated in shard order.\n\n" ;
+    std::string opt_help_msg = "Produces this help message." ;
+    std::string opt_bed_msg  = "A coma separated list of paths to the bed\n"
+                               "files to merge, in any order." ;
+
+    // option parser
+    std::string paths_bed("") ;
+
+    po::variables_map vm ;
+    po::options_description desc(desc_msg) ;
+    desc.add_options()
+        ("help,h",      opt_help_msg.c_str())
+        ("bed",         po::value<std::string>(&(paths_bed)),
+                        opt_bed_msg.c_str()) ;
+
+    // parse
+    try
+    {   po::store(po::parse_command_line(m_argc,
+                                         m_argv,
+                                         desc), vm) ;
+        po::notify(vm) ;
+    }
+    catch(std::invalid_argument& e)
+    {   std::string msg = std::string("Error! Invalid "
+                                      "option given\n") +
+                          std::string(e.what()) ;
+        return this->getExitCodeError() ;
+    }
+    catch(...)
+    {   std::cerr << "Error! an unknown error occured "
+                     "while parsing the options"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    // display help if needed
+    bool help = vm.count("help") ;
+    if(help)
+    {   std::cout << desc << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    // check options
+    if(paths_bed == "")
+    {   std::cerr <<"Error! no bed file given (--bed)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    m_paths_bed = ngsai::split(paths_bed, ',') ;
+
+    return this->getExitCodeSuccess() ;
+}
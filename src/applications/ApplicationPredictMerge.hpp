@@ -0,0 +1,98 @@
+#ifndef NGSAI_APP_APPLICATIONPREDICTMERGE_HPP
+#define NGSAI_APP_APPLICATIONPREDICTMERGE_HPP
+
+#include <applications/ApplicationInterface.hpp>
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief The ApplicationPredictMerge class creates
+        * a standalone application that merges the BED
+        * outputs of several predict shards into a single
+        * BED file.
+        * Each output starts with the "# shard i/N" line
+        * written by predict --shard. All the shards of a
+        * run must be given, exactly once and in any
+        * order. The shards are made of consecutive
+        * chunks, their lines are concatenated in shard
+        * order, such that the order of the chromosomes,
+        * karyotypic or not, is preserved.
+        */
+        class ApplicationPredictMerge :
+            public ngsai::app::ApplicationInterface
+        {
+            public:
+                /*!
+                * \brief Constructor.
+                * Saves the argc and argv values and sets
+                * the app as not runnable.
+                * \param argc the number of command line
+                * argument.
+                * \param argv the command line argument
+                * vector.
+                */
+                ApplicationPredictMerge(int argc, char** argv) ;
+
+                /*!
+                * \brief Destructor.
+                */
+                virtual
+                ~ApplicationPredictMerge() override ;
+
+                /*!
+                * \brief Runs the application, with all its
+                * functionalities.
+                * \return the exit code to return to the OS.
+                */
+                virtual
+                int
+                run() override ;
+
+                /*!
+                 * \brief Concatenates the BED outputs of 
+                 * the shards of a run in shard order, 
+                 * without their shard lines.
+                 * \param paths_bed the paths to the BED 
+                 * files, in any order.
+                 * \param stream the stream to write the 
+                 * merged lines to.
+                 * \throw std::runtime_error if a file 
+                 * cannot be opened.
+                 * \throw std::invalid_argument if a file 
+                 * does not start with a valid shard line, 
+                 * if the files are shards of different 
+                 * numbers of shards or if a shard is 
+                 * missing or given twice.
+                 */
+                static
+                void
+                mergeShards(const std::vector<std::string>& paths_bed,
+                            std::ostream& stream) ;
+
+            protected:
+                /*!
+                 * \brief Parses the command line options
+                 * and sets the fields.
+                 * \return an exit code,
+                 * getExitCodeSuccess() if it went well.
+                 */
+                virtual
+                int
+                parseOptions() override ;
+
+                /*!
+                 * \brief the paths to the BED files to
+                 * merge.
+                 */
+                std::vector<std::string> m_paths_bed ;
+        } ;
+    }
+}
+#endif // NGSAI_APP_APPLICATIONPREDICTMERGE_HPP
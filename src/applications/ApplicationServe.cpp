@@ -0,0 +1,383 @@
+#include <applications/ApplicationServe.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cerrno>                          // errno
+#include <csignal>                         // std::sig_atomic_t, SIGINT, SIGTERM
+#include <cstring>                         // std::strerror(), std::memset()
+#include <stdexcept>                       // std::invalid_argument
+#include <boost/program_options.hpp>       // variable_map, options_descriptions
+#include <unistd.h>                        // close(), unlink()
+#include <sys/stat.h>                      // lstat()
+#include <sys/socket.h>                    // socket(), bind(), listen(), accept(), setsockopt()
+#include <sys/time.h>                      // timeval
+#include <sys/un.h>                        // sockaddr_un
+#include <pbbam/BamFile.h>                  // PacBio::BAM::BamFile
+
+#include <ngsaipp/utility/string_utility.hpp>       // ngsai::split(), ngsai::endswith()
+#include <applications/KineticTable.hpp>            // ngsai::app::KineticTable
+#include <applications/SocketBuffer.hpp>            // ngsai::app::SocketBuffer
+
+
+namespace po = boost::program_options ;
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief Set when the server is requested to 
+        * stop.
+        */
+        volatile std::sig_atomic_t serve_stop = 0 ;
+
+        /*!
+        * \brief Requests the server to stop.
+        * \param signal the signal received.
+        */
+        extern "C"
+        void
+        serve_handle_signal(int signal)
+        {   (void)signal ;
+            serve_stop = 1 ; 
+        }
+
+    }  // namespace app
+
+}  // namespace ngsai
+
+
+ngsai::app::ApplicationServe::ApplicationServe(
+                        int argc,
+                        char** argv)
+    : ApplicationPredict(argc, argv, false),
+      m_path_socket(""),
+      m_timeout(60),
+      m_chroms()
+{   int parsing = this->parseOptions() ;
+    if(parsing == this->getExitCodeSuccess())
+    {   m_is_runnable = true ; }
+    else
+    {   m_is_runnable = false ; }
+}
+
+
+ngsai::app::ApplicationServe::~ApplicationServe()
+{ ; }
+
+
+int
+ngsai::app::ApplicationServe::run()
+{   
+    if(not this->isRunnable())
+    {   return this->getExitCodeError() ; }
+
+    // stop on SIGINT and SIGTERM, without restarting 
+    // accept() such that the loop can exit
+    struct sigaction action ;
+    std::memset(&action, 0, sizeof(action)) ;
+    action.sa_handler = serve_handle_signal ;
+    sigemptyset(&action.sa_mask) ;
+    sigaction(SIGINT,  &action, nullptr) ;
+    sigaction(SIGTERM, &action, nullptr) ;
+
+    // remove a socket left by a previous server
+    struct stat info ;
+    if(lstat(m_path_socket.c_str(), &info) == 0)
+    {   if(not S_ISSOCK(info.st_mode))
+        {   std::cerr << "Error! " << m_path_socket 
+                      << " exists and is not a socket "
+                         "(--socket)"
+                      << std::endl ;
+            return this->getExitCodeError() ;
+        }
+        unlink(m_path_socket.c_str()) ;
+    }
+
+    // listen
+    struct sockaddr_un address ;
+    std::memset(&address, 0, sizeof(address)) ;
+    address.sun_family = AF_UNIX ;
+    m_path_socket.copy(address.sun_path, 
+                       sizeof(address.sun_path) - 1) ;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0) ;
+    if((fd < 0) or
+       (bind(fd, 
+             reinterpret_cast<struct sockaddr*>(&address),
+             sizeof(address)) != 0) or
+       (listen(fd, 64) != 0))
+    {   std::cerr << "Error! could not listen on "
+                  << m_path_socket << " : "
+                  << std::strerror(errno)
+                  << std::endl ;
+        if(fd >= 0)
+        {   close(fd) ; }
+        return this->getExitCodeError() ;
+    }
+    std::cerr << "serving on " << m_path_socket 
+              << std::endl ;
+
+    // serve the clients one after the other
+    int exit_code = this->getExitCodeSuccess() ;
+    while(not serve_stop)
+    {   int fd_client = accept(fd, nullptr, nullptr) ;
+        if(fd_client < 0)
+        {   if(errno == EINTR)
+            {   continue ; }
+            std::cerr << "Error! could not accept a "
+                         "connection : "
+                      << std::strerror(errno)
+                      << std::endl ;
+            exit_code = this->getExitCodeError() ;
+            break ;
+        }
+        // a stalled client cannot hold the server 
+        // forever
+        struct timeval timeout ;
+        timeout.tv_sec  = static_cast<time_t>(m_timeout) ;
+        timeout.tv_usec = 0 ;
+        if((setsockopt(fd_client,
+                       SOL_SOCKET,
+                       SO_RCVTIMEO,
+                       &timeout,
+                       sizeof(timeout)) != 0) or
+           (setsockopt(fd_client,
+                       SOL_SOCKET,
+                       SO_SNDTIMEO,
+                       &timeout,
+                       sizeof(timeout)) != 0))
+        {   std::cerr << "Error! could not set the client "
+                         "timeout : "
+                      << std::strerror(errno)
+                      << std::endl ;
+            close(fd_client) ;
+            continue ;
+        }
+        this->serveClient(fd_client) ;
+        close(fd_client) ;
+    }
+
+    close(fd) ;
+    unlink(m_path_socket.c_str()) ;
+    return exit_code ;
+}
+
+
+int
+ngsai::app::ApplicationServe::parseOptions()
+{
+    // check arguments were given
+    if(m_argc == 1)
+    {   std::cerr << "Error ! no options given"
+                  << std::endl ; 
+        return this->getExitCodeError() ;
+    }
+
+    // help messages
+    std::string desc_msg =  "\n"
+                            "Usage : serve [options]"
+                            "\n"
+                            "\tLoads the kinetic models and opens the bam\n"
+                            "\tfiles once and serves CpG methylation\n"
+                            "\tpredictions over a UNIX socket, until\n"
+                            "\tinterrupted. Use the client command to send\n"
+                            "\tthe CpGs of a BED file to the server.\n"
+                            "\tThe prediction options are those of predict.\n"
+                            "\tThe CpGs come from the clients and the\n"
+                            "\tpredictions go back on the socket, the\n"
+                            "\tpredict options --bed, --sweep, --tile,\n"
+                            "\t--shard, --out, --checkpoint and --resume\n"
+                            "\tthus do not apply.\n\n" ;
+    std::string opt_help_msg  = "Produces this help message." ;
+    std::string opt_socket_msg = "The path to the UNIX socket to listen on." ;
+    std::string opt_timeout_msg = "The time in seconds after which a client\n"
+                                  "that stopped sending its CpGs, or\n"
+                                  "reading the predictions, is\n"
+                                  "disconnected. By default 60." ;
+
+    // option parser
+    PredictOptions options ;
+    std::string path_socket("") ;
+    size_t timeout(60) ;
+
+    po::variables_map vm ;
+    po::options_description desc(desc_msg) ;
+    desc.add_options()
+        ("help,h",      opt_help_msg.c_str())
+        ("socket",      po::value<std::string>(&(path_socket)), 
+                        opt_socket_msg.c_str())
+        ("timeout",     po::value<size_t>(&(timeout)), 
+                        opt_timeout_msg.c_str()) ;
+    desc.add(getPredictOptions(options)) ;
+    
+    // parse
+    try
+    {   po::store(po::parse_command_line(m_argc, 
+                                         m_argv, 
+                                         desc), vm) ;
+        po::notify(vm) ;
+    }
+    catch(std::invalid_argument& e)
+    {   std::string msg = std::string("Error! Invalid "
+                                      "option given\n") + 
+                          std::string(e.what()) ;
+        return this->getExitCodeError() ;
+    }
+    catch(...)
+    {   std::cerr << "Error! an unknown error occured "
+                     "while parsing the options" 
+                  << std::endl ; 
+        return this->getExitCodeError() ;
+    }
+
+    // display help if needed
+    bool help = vm.count("help") ;
+    if(help)
+    {   std::cout << desc << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    // check options
+    if(path_socket == "")
+    {   std::cerr <<"Error! no socket given (--socket)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(path_socket.size() >= 
+                sizeof(sockaddr_un::sun_path))
+    {   std::cerr <<"Error! socket path is too long "
+                    "(--socket)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    else if(timeout == 0)
+    {   std::cerr <<"Error! timeout must be > 0 "
+                    "(--timeout)"
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    // load models and check bam files once
+    if((this->setPredictOptions(options) !=
+        this->getExitCodeSuccess()) or
+       (this->loadChromosomes() !=
+        this->getExitCodeSuccess()))
+    {   return this->getExitCodeError() ; }
+
+    // set remaining fields
+    m_path_socket = path_socket ;
+    m_timeout     = timeout ;
+
+    return this->getExitCodeSuccess() ;
+}
+
+
+int
+ngsai::app::ApplicationServe::loadChromosomes()
+{   m_chroms.clear() ;
+    for(const auto& path_bam : m_paths_bam)
+    {   try
+        {   PacBio::BAM::BamFile bam_file(path_bam) ;
+            for(const auto& sequence : 
+                        bam_file.Header().Sequences())
+            {   m_chroms.insert(sequence.Name()) ; }
+        }
+        catch(const std::exception& e)
+        {   std::cerr << "Error! could not read the reference "
+                         "sequences from the header of "
+                      << path_bam << ":" << std::endl 
+                      << e.what() << std::endl ;
+            return this->getExitCodeError() ;
+        }
+    }
+    return this->getExitCodeSuccess() ;
+}
+
+
+int
+ngsai::app::ApplicationServe::serveClient(int fd)
+{   ngsai::app::SocketBuffer buffer(fd) ;
+    std::iostream stream(&buffer) ;
+
+    // read the CpGs until the client closes its end
+    m_cpgs.clear() ;
+    std::string line ;
+    size_t n_line = 0 ;
+    try
+    {   while(std::getline(stream, line))
+        {   n_line++ ;
+            if(line.empty())
+            {   continue ; }
+            std::vector<std::string> fields = 
+                                ngsai::split(line, '\t') ;
+            if(fields.size() < 3)
+            {   throw std::invalid_argument(
+                                "expected chrom, start and "
+                                "end") ;
+            }
+            // the BAM reading would throw in the 
+            // prediction threads
+            if(m_chroms.find(fields[0]) == m_chroms.end())
+            {   throw std::invalid_argument(
+                                "chromosome " + fields[0] + 
+                                " is not in the bam headers") ;
+            }
+            m_cpgs.add(fields[0],
+                       std::stoul(fields[1]),
+                       std::stoul(fields[2])) ;
+        }
+    }
+    catch(const std::exception& e)
+    {   stream.clear() ;
+        stream << "# error : invalid request at line "
+               << n_line << " : " << e.what() 
+               << std::endl ;
+        std::cerr << "Error! invalid request : "
+                  << e.what() << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    // reading stopped on the end of the input, or on 
+    // a timeout in which case the request is incomplete
+    if(buffer.hasFailed())
+    {   std::cerr << "Error! could not read the request : "
+                  << std::strerror(buffer.getErrno()) 
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+
+    // a failed request must not stop the server. The 
+    // client tells a complete reply by its last line
+    stream.clear() ;
+    int exit_code = this->getExitCodeError() ;
+    try
+    {   exit_code = this->predict(stream) ; }
+    catch(const std::exception& e)
+    {   std::cerr << "Error! could not compute the "
+                     "predictions:"
+                  << std::endl
+                  << e.what() << std::endl ;
+    }
+    if(exit_code == this->getExitCodeSuccess())
+    {   stream << "# done " << m_cpgs.size() << '\n' ; }
+    else
+    {   stream << "# error : the predictions could not "
+                  "be computed\n" ;
+    }
+    stream.flush() ;
+    if(buffer.hasFailed())
+    {   std::cerr << "Error! could not send the "
+                     "predictions : "
+                  << std::strerror(buffer.getErrno())
+                  << std::endl ;
+        return this->getExitCodeError() ;
+    }
+    if(exit_code != this->getExitCodeSuccess())
+    {   return exit_code ; }
+    std::cerr << "served " << m_cpgs.size() << " CpGs"
+              << std::endl ;
+    this->reportCheck() ;
+    return exit_code ;
+}
@@ -0,0 +1,115 @@
+#ifndef NGSAI_APP_APPLICATIONSERVE_HPP
+#define NGSAI_APP_APPLICATIONSERVE_HPP
+
+#include <applications/ApplicationPredict.hpp>
+
+#include <string>
+#include <unordered_set>
+
+
+namespace ngsai
+{
+    namespace app
+    {   
+        /*!
+        * \brief The ApplicationServe class creates a 
+        * standalone application that loads the kinetic 
+        * models and opens the BAM files once, and then 
+        * serves CpG methylation predictions over a 
+        * local UNIX socket.
+        * A client sends CpGs, one per line as 
+        * chrom<TAB>start<TAB>end, and closes its writing 
+        * end. The server then writes the predictions in 
+        * BED 6 format, in the same order, followed by a 
+        * "# done <n>" line giving the number of CpGs 
+        * predicted, and closes the connection. If the 
+        * request is invalid, for instance if a CpG is on 
+        * a chromosome absent from the BAM headers, a 
+        * single line starting with "# error" is sent 
+        * instead. If the prediction fails, the "# error" 
+        * line follows the predictions sent so far.
+        * The clients are served one at a time, each 
+        * using all the threads.
+        */
+        class ApplicationServe : 
+            public ngsai::app::ApplicationPredict
+        {   
+            public:
+                /*!
+                * \brief Constructor.
+                * Saves the argc and argv values and sets 
+                * the app as not runnable.
+                * \param argc the number of command line 
+                * argument.
+                * \param argv the command line argument 
+                * vector.
+                */
+                ApplicationServe(int argc, char** argv) ;
+
+                /*!
+                * \brief Destructor.
+                */
+                virtual 
+                ~ApplicationServe() override ;
+                
+                /*!
+                * \brief Runs the application, with all its
+                * functionalities. It serves the clients 
+                * until SIGINT or SIGTERM is received.
+                * \return the exit code to return to the OS.
+                */
+                virtual 
+                int
+                run() override ;
+
+            protected:
+                /*!
+                 * \brief Parses the command line options 
+                 * and sets the fields.
+                 * \return an exit code, 
+                 * getExitCodeSuccess() if it went well.
+                 */
+                virtual
+                int
+                parseOptions() override ;
+
+                /*!
+                 * \brief Reads the names of the reference 
+                 * sequences from the BAM headers.
+                 * \return an exit code, 
+                 * getExitCodeSuccess() if it went well.
+                 */
+                int
+                loadChromosomes() ;
+
+                /*!
+                 * \brief Reads the CpGs sent by a client 
+                 * and writes their predictions back.
+                 * \param fd the connected socket.
+                 * \return an exit code, 
+                 * getExitCodeSuccess() if it went well.
+                 */
+                int
+                serveClient(int fd) ;
+
+            protected:
+                /*!
+                 * \brief the path to the socket.
+                 */
+                std::string m_path_socket ;
+                /*!
+                 * \brief the time, in seconds, after which 
+                 * a stalled client is disconnected.
+                 */
+                size_t m_timeout ;
+                /*!
+                 * \brief the names of the reference 
+                 * sequences listed in the BAM headers, 
+                 * the only chromosomes accepted from the 
+                 * clients.
+                 */
+                std::unordered_set<std::string> m_chroms ;
+        } ;
+    }
+}
+#endif // NGSAI_APP_APPLICATIONSERVE_HPP
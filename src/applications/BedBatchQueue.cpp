@@ -0,0 +1,58 @@
+#include <applications/BedBatchQueue.hpp>
+
+#include <stdexcept>            // std::invalid_argument
+#include <mutex>                // std::mutex, std::unique_lock, std::lock_guard
+
+
+ngsai::app::BedBatchQueue::BedBatchQueue(size_t capacity)
+    : m_capacity(capacity),
+      m_closed(false),
+      m_batches(),
+      m_mutex(),
+      m_pushed(),
+      m_popped()
+{   if(capacity == 0)
+    {   throw std::invalid_argument("BedBatchQueue error! "
+                                    "capacity must be > 0") ;
+    }
+}
+
+
+ngsai::app::BedBatchQueue::~BedBatchQueue()
+{ ; }
+
+
+void
+ngsai::app::BedBatchQueue::push(BedBatch&& batch)
+{   std::unique_lock<std::mutex> lock(m_mutex) ;
+    m_popped.wait(lock,
+                  [this]()
+                  {   return m_batches.size() < m_capacity ; }) ;
+    m_batches.push_back(std::move(batch)) ;
+    m_pushed.notify_one() ;
+}
+
+
+bool
+ngsai::app::BedBatchQueue::pop(BedBatch& batch)
+{   std::unique_lock<std::mutex> lock(m_mutex) ;
+    m_pushed.wait(lock,
+                  [this]()
+                  {   return m_closed or 
+                             (not m_batches.empty()) ;
+                  }) ;
+    if(m_batches.empty())
+    {   return false ; }
+    batch = std::move(m_batches.front()) ;
+    m_batches.pop_front() ;
+    m_popped.notify_one() ;
+    return true ;
+}
+
+
+void
+ngsai::app::BedBatchQueue::close()
+{   std::lock_guard<std::mutex> lock(m_mutex) ;
+    m_closed = true ;
+    m_pushed.notify_all() ;
+}
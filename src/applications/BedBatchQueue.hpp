@@ -0,0 +1,134 @@
+#ifndef NGSAI_APP_BEDBATCHQUEUE_HPP
+#define NGSAI_APP_BEDBATCHQUEUE_HPP
+
+#include <vector>
+#include <deque>
+#include <mutex>                    // std::mutex
+#include <condition_variable>       // std::condition_variable
+
+#include <ngsaipp/io/BedRecord.hpp>  // ngsai::BedRecord
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief A batch of consecutive BED records and
+        * its index in the BED file.
+        */
+        struct BedBatch
+        {   /*!
+            * \brief the index of the batch, the
+            * batches being numbered from 0 in the file
+            * order.
+            */
+            size_t index ;
+            /*!
+            * \brief the records.
+            */
+            std::vector<ngsai::BedRecord> records ;
+            /*!
+            * \brief the label of each record, the
+            * index of the BED file it was read from.
+            */
+            std::vector<size_t> labels ;
+        } ;
+
+
+        /*!
+        * \brief The BedBatchQueue class passes batches
+        * of BED records from a thread reading a BED file
+        * to worker threads, such that the file is never
+        * held in memory as a whole.
+        * The queue is bounded: the reader waits while it
+        * is full and the workers wait while it is empty.
+        * The workers pull a batch whenever they are done
+        * with the previous one, such that the batches
+        * are dynamically balanced among them.
+        */
+        class BedBatchQueue
+        {
+            public:
+                /*!
+                * \brief Constructor.
+                * \param capacity the maximum number of
+                * batches in the queue. It must be > 0.
+                * \throw std::invalid_argument if the
+                * capacity is 0.
+                */
+                BedBatchQueue(size_t capacity) ;
+
+                BedBatchQueue(const BedBatchQueue& other) = delete ;
+
+                BedBatchQueue&
+                operator = (const BedBatchQueue& other) = delete ;
+
+                /*!
+                * \brief Destructor.
+                */
+                virtual
+                ~BedBatchQueue() ;
+
+                /*!
+                * \brief Adds a batch at the end of the
+                * queue, waiting until there is room for
+                * it.
+                * \param batch the batch.
+                */
+                void
+                push(BedBatch&& batch) ;
+
+                /*!
+                * \brief Removes the batch at the front of
+                * the queue, waiting until there is one or
+                * until the queue is closed.
+                * \param batch where the batch is moved.
+                * \return whether a batch was returned,
+                * false once the queue is closed and
+                * empty.
+                */
+                bool
+                pop(BedBatch& batch) ;
+
+                /*!
+                * \brief Indicates that no batch will be
+                * pushed anymore. The workers get the
+                * remaining batches and then stop.
+                */
+                void
+                close() ;
+
+            protected:
+                /*!
+                * \brief the maximum number of batches.
+                */
+                size_t m_capacity ;
+                /*!
+                * \brief whether the queue is closed.
+                */
+                bool m_closed ;
+                /*!
+                * \brief the batches.
+                */
+                std::deque<BedBatch> m_batches ;
+                /*!
+                * \brief protects the queue.
+                */
+                std::mutex m_mutex ;
+                /*!
+                * \brief signals a batch was pushed or the
+                * queue was closed.
+                */
+                std::condition_variable m_pushed ;
+                /*!
+                * \brief signals a batch was popped.
+                */
+                std::condition_variable m_popped ;
+        } ;
+
+    }  // namespace app
+
+}  // namespace ngsai
+
+#endif  // NGSAI_APP_BEDBATCHQUEUE_HPP
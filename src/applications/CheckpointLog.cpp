@@ -0,0 +1,82 @@
+#include <applications/CheckpointLog.hpp>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>           // std::filesystem::exists(), std::filesystem::resize_file()
+#include <stdexcept>            // std::runtime_error
+#include <mutex>                // std::mutex, std::lock_guard
+
+
+ngsai::app::CheckpointLog::CheckpointLog(
+                                const std::string& path,
+                                const std::string& header,
+                                bool resume)
+    : m_path(path),
+      m_entries(),
+      m_file(),
+      m_mutex()
+{
+    if(resume and std::filesystem::exists(path))
+    {   // read the complete lines only
+        std::ifstream f_in(path) ;
+        std::string line ;
+        size_t n_bytes = 0 ;
+        bool first = true ;
+        while(std::getline(f_in, line) and
+              (not f_in.eof()))
+        {   if(first and (line != header))
+            {   throw std::runtime_error(
+                        "CheckpointLog error! " + path +
+                        " belongs to another run") ;
+            }
+            else if(not first)
+            {   m_entries.push_back(line) ; }
+            first = false ;
+            n_bytes += line.size() + 1 ;
+        }
+        f_in.close() ;
+
+        // an interruption before the header was complete
+        if(first)
+        {   resume = false ; }
+        // drop an incomplete last line
+        else
+        {   std::filesystem::resize_file(path, n_bytes) ; }
+    }
+    else
+    {   resume = false ; }
+
+    if(resume)
+    {   m_file.open(path, std::ios::app) ; }
+    else
+    {   m_file.open(path, std::ios::trunc) ;
+        m_file << header << '\n' ;
+        m_file.flush() ;
+    }
+    if(not m_file)
+    {   throw std::runtime_error("CheckpointLog error! "
+                                 "cannot write " + path) ;
+    }
+}
+
+
+ngsai::app::CheckpointLog::~CheckpointLog()
+{   m_file.close() ; }
+
+
+const std::vector<std::string>&
+ngsai::app::CheckpointLog::getEntries() const
+{   return m_entries ; }
+
+
+void
+ngsai::app::CheckpointLog::append(const std::string& entry)
+{   std::lock_guard<std::mutex> lock(m_mutex) ;
+    m_file << entry << '\n' ;
+    m_file.flush() ;
+    if(not m_file)
+    {   throw std::runtime_error("CheckpointLog error! "
+                                 "cannot write " + m_path) ;
+    }
+}
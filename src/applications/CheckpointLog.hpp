@@ -0,0 +1,102 @@
+#ifndef NGSAI_APP_CHECKPOINTLOG_HPP
+#define NGSAI_APP_CHECKPOINTLOG_HPP
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <mutex>                // std::mutex
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief The CheckpointLog class records the
+        * progress of a long run in an append-only text
+        * file, such that an interrupted run can be
+        * resumed.
+        * The file starts with a header line describing
+        * the run, followed by one line per entry. Each
+        * entry is appended and flushed at once and the
+        * previous entries are never rewritten, making
+        * checkpoints cheap. When resuming, an incomplete
+        * last line, left by an interruption while it was
+        * written, is discarded.
+        */
+        class CheckpointLog
+        {
+            public:
+                /*!
+                * \brief Constructor. Opens a log.
+                * \param path the path to the log file.
+                * \param header a single line describing
+                * the run, used to check that a log
+                * belongs to the resumed run.
+                * \param resume whether to resume from the
+                * log. If the file exists, its entries are
+                * read and the new entries are appended.
+                * Otherwise, or if resume is false, a new
+                * log is created.
+                * \throw std::runtime_error if the file
+                * cannot be opened or if its header
+                * differs from the given one.
+                */
+                CheckpointLog(const std::string& path,
+                              const std::string& header,
+                              bool resume) ;
+
+                CheckpointLog(const CheckpointLog& other) = delete ;
+
+                CheckpointLog&
+                operator = (const CheckpointLog& other) = delete ;
+
+                /*!
+                * \brief Destructor.
+                */
+                virtual
+                ~CheckpointLog() ;
+
+                /*!
+                * \brief Returns the entries read from the
+                * log when resuming, in their order.
+                * \return the entries.
+                */
+                const std::vector<std::string>&
+                getEntries() const ;
+
+                /*!
+                * \brief Appends an entry to the log and
+                * flushes it. This method is thread safe.
+                * \param entry the entry, it must not
+                * contain any new line.
+                * \throw std::runtime_error if the entry
+                * could not be written.
+                */
+                void
+                append(const std::string& entry) ;
+
+            protected:
+                /*!
+                * \brief the path to the log file.
+                */
+                std::string m_path ;
+                /*!
+                * \brief the entries read when resuming.
+                */
+                std::vector<std::string> m_entries ;
+                /*!
+                * \brief the log file.
+                */
+                std::ofstream m_file ;
+                /*!
+                * \brief protects the log file.
+                */
+                std::mutex m_mutex ;
+        } ;
+
+    }  // namespace app
+
+}  // namespace ngsai
+
+#endif  // NGSAI_APP_CHECKPOINTLOG_HPP
@@ -0,0 +1,124 @@
+#include <applications/ChunkScheduler.hpp>
+
+#include <limits>               // std::numeric_limits
+#include <stdexcept>            // std::invalid_argument
+#include <mutex>                // std::mutex, std::lock_guard
+
+
+ngsai::app::ChunkScheduler::ChunkScheduler(
+                                size_t n_chunks,
+                                size_t n_threads)
+    : ChunkScheduler(0, n_chunks, n_threads)
+{ ; }
+
+
+ngsai::app::ChunkScheduler::ChunkScheduler(
+                                size_t first,
+                                size_t n_chunks,
+                                size_t n_threads)
+    : m_queues(),
+      m_steal_n(0),
+      m_mutex()
+{   if(n_threads == 0)
+    {   throw std::invalid_argument("ChunkScheduler error! "
+                                    "number of threads must "
+                                    "be > 0") ;
+    }
+
+    for(size_t i=0; i<n_threads; i++)
+    {   m_queues.push_back(std::unique_ptr<Queue>(new Queue())) ; }
+
+    // interleave the chunks such that all threads work
+    // on neighbouring chunks at any time
+    for(size_t i=first; i<n_chunks; i++)
+    {   m_queues[i % n_threads]->chunks.push_back(i) ; }
+}
+
+
+ngsai::app::ChunkScheduler::~ChunkScheduler()
+{ ; }
+
+
+bool
+ngsai::app::ChunkScheduler::getNext(size_t thread_index,
+                                    size_t limit,
+                                    size_t& chunk)
+{
+    // own next chunk
+    size_t own = std::numeric_limits<size_t>::max() ;
+    {   Queue& queue = *(m_queues[thread_index]) ;
+        std::lock_guard<std::mutex> lock(queue.mutex) ;
+        if(not queue.chunks.empty())
+        {   own = queue.chunks.front() ;
+            if(own < limit)
+            {   chunk = own ;
+                queue.chunks.pop_front() ;
+                return true ;
+            }
+        }
+    }
+
+    // own queue empty or next chunk too far ahead
+    if(this->steal(thread_index, own, chunk))
+    {   return true ; }
+
+    // nothing better to steal, take own next chunk
+    // anyway. It may have been stolen in the meantime
+    Queue& queue = *(m_queues[thread_index]) ;
+    std::lock_guard<std::mutex> lock(queue.mutex) ;
+    if(queue.chunks.empty())
+    {   return false ; }
+    chunk = queue.chunks.front() ;
+    queue.chunks.pop_front() ;
+    return true ;
+}
+
+
+size_t
+ngsai::app::ChunkScheduler::getStealCount() const
+{   std::lock_guard<std::mutex> lock(m_mutex) ;
+    return m_steal_n ;
+}
+
+
+bool
+ngsai::app::ChunkScheduler::steal(size_t thread_index,
+                                  size_t bound,
+                                  size_t& chunk)
+{
+    // the queues are scanned one after the other and the
+    // victim front chunk is checked again when stealing
+    // because it may have changed in the meantime
+    while(true)
+    {
+        // find the lowest pending chunk
+        size_t victim = m_queues.size() ;
+        size_t lowest = bound ;
+        for(size_t i=0; i<m_queues.size(); i++)
+        {   if(i == thread_index)
+            {   continue ; }
+            Queue& queue = *(m_queues[i]) ;
+            std::lock_guard<std::mutex> lock(queue.mutex) ;
+            if((not queue.chunks.empty()) and
+               (queue.chunks.front() < lowest))
+            {   lowest = queue.chunks.front() ;
+                victim = i ;
+            }
+        }
+
+        if(victim == m_queues.size())
+        {   return false ; }
+
+        // steal it
+        Queue& queue = *(m_queues[victim]) ;
+        std::lock_guard<std::mutex> lock(queue.mutex) ;
+        if((not queue.chunks.empty()) and
+           (queue.chunks.front() == lowest))
+        {   chunk = lowest ;
+            queue.chunks.pop_front() ;
+            std::lock_guard<std::mutex> lock_n(m_mutex) ;
+            m_steal_n++ ;
+            return true ;
+        }
+    }
+}
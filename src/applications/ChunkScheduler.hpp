@@ -0,0 +1,151 @@
+#ifndef NGSAI_APP_CHUNKSCHEDULER_HPP
+#define NGSAI_APP_CHUNKSCHEDULER_HPP
+
+#include <vector>
+#include <deque>
+#include <mutex>        // std::mutex
+#include <memory>       // std::unique_ptr
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief The ChunkScheduler class distributes
+        * chunks of work, identified by their indices
+        * [0,n), to a set of worker threads with work
+        * stealing.
+        * Each thread owns a queue containing every n-th
+        * chunk, starting with the chunk having its own
+        * index, and processes it in increasing order.
+        * A thread that has no chunk left, or whose next
+        * chunk is too far ahead of the results already
+        * written, steals the lowest pending chunk of the
+        * other threads. Chunks are never split, such
+        * that each of them is processed sequentially by
+        * a single thread.
+        */
+        class ChunkScheduler
+        {
+            public:
+                /*!
+                * \brief Constructor.
+                * \param n_chunks the number of chunks to
+                * distribute.
+                * \param n_threads the number of worker
+                * threads. It must be > 0.
+                * \throw std::invalid_argument if the
+                * number of threads is 0.
+                */
+                ChunkScheduler(size_t n_chunks,
+                               size_t n_threads) ;
+
+                /*!
+                * \brief Constructor. Distributes the
+                * chunks [first,n_chunks) only, for
+                * instance to resume an interrupted run.
+                * \param first the index of the first
+                * chunk to distribute.
+                * \param n_chunks the number of chunks.
+                * \param n_threads the number of worker
+                * threads. It must be > 0.
+                * \throw std::invalid_argument if the
+                * number of threads is 0.
+                */
+                ChunkScheduler(size_t first,
+                               size_t n_chunks,
+                               size_t n_threads) ;
+
+                /*!
+                * \brief Destructor.
+                */
+                virtual
+                ~ChunkScheduler() ;
+
+                /*!
+                * \brief Gets the next chunk to process
+                * for a given thread. The thread takes the
+                * next chunk from its own queue if its
+                * index is lower than the given limit.
+                * Otherwise, it steals the lowest pending
+                * chunk from the other threads if this one
+                * is lower than its own next chunk.
+                * \param thread_index the index of the
+                * thread, in [0,n_threads).
+                * \param limit the chunks with an index
+                * lower than this value can be processed
+                * without waiting.
+                * \param chunk a reference to store the
+                * index of the chunk to process.
+                * \return whether a chunk was assigned,
+                * false if all the chunks have been
+                * distributed.
+                */
+                bool
+                getNext(size_t thread_index,
+                        size_t limit,
+                        size_t& chunk) ;
+
+                /*!
+                * \brief Returns the number of chunks
+                * that have been stolen so far.
+                * \return the number of stolen chunks.
+                */
+                size_t
+                getStealCount() const ;
+
+            protected:
+                /*!
+                * \brief Steals the lowest pending chunk
+                * from the other threads queues, if it is
+                * lower than the given bound.
+                * \param thread_index the index of the
+                * thief thread.
+                * \param bound only a chunk lower than
+                * this value can be stolen.
+                * \param chunk a reference to store the
+                * index of the stolen chunk.
+                * \return whether a chunk was stolen.
+                */
+                bool
+                steal(size_t thread_index,
+                      size_t bound,
+                      size_t& chunk) ;
+
+            protected:
+                /*!
+                * \brief A queue of chunk indices owned
+                * by a thread, in increasing order.
+                */
+                struct Queue
+                {   /*!
+                    * \brief the chunk indices.
+                    */
+                    std::deque<size_t> chunks ;
+                    /*!
+                    * \brief protects the chunk indices.
+                    */
+                    std::mutex mutex ;
+                } ;
+
+            protected:
+                /*!
+                * \brief the queue of each thread.
+                */
+                std::vector<std::unique_ptr<Queue>> m_queues ;
+                /*!
+                * \brief the number of chunks stolen.
+                */
+                size_t m_steal_n ;
+                /*!
+                * \brief protects the steal counter.
+                */
+                mutable std::mutex m_mutex ;
+        } ;
+
+    }  // namespace app
+
+}  // namespace ngsai
+
+#endif  // NGSAI_APP_CHUNKSCHEDULER_HPP
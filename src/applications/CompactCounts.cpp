@@ -0,0 +1,103 @@
+#include <applications/CompactCounts.hpp>
+
+#include <vector>
+#include <cstdint>
+
+
+/*!
+ * \brief Adds a range of counts to an array.
+ * \param counts the counts.
+ * \param from the index of the first count.
+ * \param n the number of counts.
+ * \param values the array, of n values.
+ */
+template<class T>
+static
+void
+add_to(const std::vector<T>& counts,
+       size_t from,
+       size_t n,
+       double* values)
+{   const T* c = counts.data() + from ;
+    for(size_t i=0; i<n; i++)
+    {   values[i] += static_cast<double>(c[i]) ; }
+}
+
+
+/*!
+ * \brief Copies counts into a vector of wider
+ * integers and frees the original vector.
+ * \param from the counts.
+ * \param to the vector to copy to.
+ */
+template<class T, class U>
+static
+void
+widen_to(std::vector<T>& from,
+         std::vector<U>& to)
+{   to.assign(from.begin(), from.end()) ;
+    std::vector<T>().swap(from) ;
+}
+
+
+ngsai::app::CompactCounts::CompactCounts(size_t size)
+    : m_width(16),
+      m_counts_16(size, 0),
+      m_counts_32(),
+      m_counts_64()
+{ ; }
+
+
+ngsai::app::CompactCounts::~CompactCounts()
+{ ; }
+
+
+size_t
+ngsai::app::CompactCounts::size() const
+{   if(m_width == 16)
+    {   return m_counts_16.size() ; }
+    else if(m_width == 32)
+    {   return m_counts_32.size() ; }
+    return m_counts_64.size() ;
+}
+
+
+size_t
+ngsai::app::CompactCounts::getWidth() const
+{   return m_width ; }
+
+
+uint64_t
+ngsai::app::CompactCounts::get(size_t i) const
+{   if(m_width == 16)
+    {   return m_counts_16[i] ; }
+    else if(m_width == 32)
+    {   return m_counts_32[i] ; }
+    return m_counts_64[i] ;
+}
+
+
+void
+ngsai::app::CompactCounts::addTo(size_t from,
+                                 size_t n,
+                                 double* values) const
+{   if(m_width == 16)
+    {   add_to(m_counts_16, from, n, values) ; }
+    else if(m_width == 32)
+    {   add_to(m_counts_32, from, n, values) ; }
+    else
+    {   add_to(m_counts_64, from, n, values) ; }
+}
+
+
+void
+ngsai::app::CompactCounts::widen()
+{   if(m_width == 16)
+    {   widen_to(m_counts_16, m_counts_32) ;
+        m_width = 32 ;
+    }
+    else if(m_width == 32)
+    {   widen_to(m_counts_32, m_counts_64) ;
+        m_width = 64 ;
+    }
+}
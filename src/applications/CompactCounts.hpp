@@ -0,0 +1,138 @@
+#ifndef NGSAI_APP_COMPACTCOUNTS_HPP
+#define NGSAI_APP_COMPACTCOUNTS_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>          // size_t
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief The CompactCounts class stores a vector
+        * of counts in the narrowest unsigned integers, of
+        * 16, 32 or 64 bits, that can hold them. The
+        * counts start on 16 bits and the whole vector is
+        * widened the first time a count would overflow,
+        * such that the counts of a histogram use 4 times
+        * less memory and cache than 64 bits values as long
+        * as they remain small. The counts are converted to
+        * floating point only when read.
+        * It is only used by the dense CountTable of
+        * model-kinetic --shared.
+        * This class is not thread safe.
+        */
+        class CompactCounts
+        {
+            public:
+                /*!
+                * \brief Constructor. Creates a vector in
+                * which all the counts are 0, stored on 16
+                * bits.
+                * \param size the number of counts.
+                */
+                CompactCounts(size_t size) ;
+
+                /*!
+                * \brief Destructor.
+                */
+                ~CompactCounts() ;
+
+                /*!
+                * \brief Returns the number of counts.
+                * \return the number of counts.
+                */
+                size_t
+                size() const ;
+
+                /*!
+                * \brief Returns the number of bits on
+                * which the counts are currently stored.
+                * \return 16, 32 or 64.
+                */
+                size_t
+                getWidth() const ;
+
+                /*!
+                * \brief Increments a count, widening the
+                * vector if it would overflow.
+                * \param i the index of the count.
+                */
+                void
+                increment(size_t i)
+                {   if(m_width == 16)
+                    {   if(m_counts_16[i] < UINT16_MAX)
+                        {   m_counts_16[i]++ ;
+                            return ;
+                        }
+                        this->widen() ;
+                    }
+                    if(m_width == 32)
+                    {   if(m_counts_32[i] < UINT32_MAX)
+                        {   m_counts_32[i]++ ;
+                            return ;
+                        }
+                        this->widen() ;
+                    }
+                    m_counts_64[i]++ ;
+                }
+
+                /*!
+                * \brief Returns a count.
+                * \param i the index of the count.
+                * \return the count.
+                */
+                uint64_t
+                get(size_t i) const ;
+
+                /*!
+                * \brief Adds a range of counts to an
+                * array.
+                * \param from the index of the first count.
+                * \param n the number of counts.
+                * \param values the array, of n values.
+                */
+                void
+                addTo(size_t from,
+                      size_t n,
+                      double* values) const ;
+
+            protected:
+                /*!
+                * \brief Moves the counts to the next
+                * wider integer type and frees the
+                * narrower ones.
+                */
+                void
+                widen() ;
+
+            protected:
+                /*!
+                * \brief the number of bits of the counts
+                * in use.
+                */
+                size_t m_width ;
+                /*!
+                * \brief the counts when stored on 16
+                * bits, empty otherwise.
+                */
+                std::vector<uint16_t> m_counts_16 ;
+                /*!
+                * \brief the counts when stored on 32
+                * bits, empty otherwise.
+                */
+                std::vector<uint32_t> m_counts_32 ;
+                /*!
+                * \brief the counts when stored on 64
+                * bits, empty otherwise.
+                */
+                std::vector<uint64_t> m_counts_64 ;
+        } ;
+
+    }  // namespace app
+
+}  // namespace ngsai
+
+#endif  // NGSAI_APP_COMPACTCOUNTS_HPP
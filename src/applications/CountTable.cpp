@@ -0,0 +1,141 @@
+#include <applications/CountTable.hpp>
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>        // std::sort(), std::max(), std::min()
+#include <stdexcept>        // std::invalid_argument
+#include <mutex>            // std::mutex, std::lock_guard
+
+
+const size_t ngsai::app::CountTable::stripe_number = 1024 ;
+
+
+const size_t ngsai::app::CountTable::chunk_size = 1 << 22 ;
+
+
+ngsai::app::CountTable::CountTable(
+                KineticTable::layouts layout,
+                size_t size,
+                size_t nb_bins,
+                double xmin,
+                double xmax,
+                std::shared_ptr<const ngsai::KmerMap> kmermap,
+                storages storage,
+                size_t n_stripes)
+    : m_layout(KineticTable::makeLayout(layout,
+                                        size,
+                                        nb_bins,
+                                        xmin,
+                                        xmax,
+                                        kmermap)),
+      m_storage(storage),
+      m_counts(),
+      m_sparse(),
+      m_stripe_size(0),
+      m_mutexes(nullptr)
+{   if(n_stripes == 0)
+    {   throw std::invalid_argument("CountTable error! number "
+                                    "of stripes must be > 0") ;
+    }
+    size_t n_values = m_layout.getValueNumber() ;
+    m_stripe_size = std::max(size_t(1),
+                             (n_values + n_stripes - 1) /
+                                n_stripes) ;
+    size_t n_mutexes = (n_values + m_stripe_size - 1) /
+                            m_stripe_size ;
+    m_mutexes.reset(new std::mutex[n_mutexes]) ;
+    if(m_storage == storages::dense)
+    {   m_counts.reserve(n_mutexes) ;
+        for(size_t i=0; i<n_mutexes; i++)
+        {   size_t from = i * m_stripe_size ;
+            m_counts.emplace_back(std::min(m_stripe_size,
+                                           n_values - from)) ;
+        }
+    }
+    else
+    {   m_sparse.resize(n_mutexes) ; }
+}
+
+
+ngsai::app::CountTable::~CountTable()
+{ ; }
+
+
+const ngsai::app::KineticTable&
+ngsai::app::CountTable::getLayout() const
+{   return m_layout ; }
+
+
+void
+ngsai::app::CountTable::add(std::vector<size_t>& indices)
+{   // each stripe is locked once per batch
+    std::sort(indices.begin(), indices.end()) ;
+    size_t i = 0 ;
+    while(i < indices.size())
+    {   size_t stripe = indices[i] / m_stripe_size ;
+        size_t end    = (stripe + 1) * m_stripe_size ;
+        std::lock_guard<std::mutex> lock(m_mutexes[stripe]) ;
+        if(m_storage == storages::dense)
+        {   // a stripe is widened under its lock
+            ngsai::app::CompactCounts& counts = m_counts[stripe] ;
+            size_t start = stripe * m_stripe_size ;
+            for( ; (i < indices.size()) and (indices[i] < end); i++)
+            {   counts.increment(indices[i] - start) ; }
+        }
+        else
+        {   std::unordered_map<size_t,uint64_t>& counts =
+                                            m_sparse[stripe] ;
+            for( ; (i < indices.size()) and (indices[i] < end); i++)
+            {   counts[indices[i]]++ ; }
+        }
+    }
+    indices.clear() ;
+}
+
+
+void
+ngsai::app::CountTable::save(const std::string& path,
+                             KineticTable::contents contents,
+                             double pseudo_counts,
+                             size_t n_chunk) const
+{   KineticTable::writeCounts(
+                m_layout,
+                path,
+                contents,
+                pseudo_counts,
+                n_chunk,
+                [this](size_t from, size_t n, double* chunk)
+                {   this->addCounts(from, n, chunk) ; }) ;
+}
+
+
+void
+ngsai::app::CountTable::addCounts(size_t from,
+                                  size_t n,
+                                  double* values) const
+{   if(n == 0)
+    {   return ; }
+
+    // only the stripes overlapping the range
+    size_t to    = from + n ;
+    size_t first = from / m_stripe_size ;
+    size_t last  = (to - 1) / m_stripe_size + 1 ;
+    if(m_storage == storages::dense)
+    {   for(size_t stripe=first; stripe<last; stripe++)
+        {   size_t start = stripe * m_stripe_size ;
+            size_t begin = std::max(from, start) ;
+            size_t stop  = std::min(to, start + m_stripe_size) ;
+            m_counts[stripe].addTo(begin - start,
+                                   stop - begin,
+                                   values + (begin - from)) ;
+        }
+        return ;
+    }
+    for(size_t stripe=first; stripe<last; stripe++)
+    {   for(const auto& count : m_sparse[stripe])
+        {   if((count.first >= from) and (count.first < to))
+            {   values[count.first - from] += count.second ; }
+        }
+    }
+}
@@ -0,0 +1,238 @@
+#ifndef NGSAI_APP_COUNTTABLE_HPP
+#define NGSAI_APP_COUNTTABLE_HPP
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <memory>           // std::shared_ptr, std::unique_ptr
+#include <mutex>            // std::mutex
+#include <cstdint>
+
+#include <ngsaipp/epigenetics/KmerMap.hpp>       // ngsai::KmerMap
+#include <applications/KineticTable.hpp>         // ngsai::app::KineticTable
+#include <applications/CompactCounts.hpp>        // ngsai::app::CompactCounts
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief The CountTable class accumulates the
+        * histogram counts of a kinetic signal model,
+        * with the layout of a KineticTable, such that
+        * several threads can train a single model.
+        * The threads collect the indices of the bins to
+        * increment in small private batches and add them
+        * with add(). The table is split into stripes of
+        * consecutive bins, each protected by its own
+        * mutex, such that threads adding at the same time
+        * mostly lock different stripes. The memory does
+        * not depend on the number of threads.
+        * The counts are stored either densely, each
+        * stripe in the narrowest integers that can hold
+        * its counts, or sparsely in a hash map per stripe
+        * that only contains the bins seen, which uses less
+        * memory when most bins of the 2D histograms of
+        * large models are empty.
+        * Once trained, the counts are turned into a
+        * KineticTable of log densities, or saved as one
+        * by chunks.
+        */
+        class CountTable
+        {
+            public:
+                /*!
+                * \brief the default number of stripes.
+                */
+                static const size_t stripe_number ;
+
+                /*!
+                * \brief the default number of values 
+                * written at once by save().
+                */
+                static const size_t chunk_size ;
+
+                /*!
+                * \brief How the counts are stored.
+                */
+                enum class storages {dense,
+                                     sparse} ;
+
+            public:
+                /*!
+                * \brief Constructor. Creates a table in
+                * which all the counts are 0.
+                * \param layout the model layout.
+                * \param size the window size in bp.
+                * \param nb_bins the number of bins of each
+                * histogram axis.
+                * \param xmin the lower limit of the lower
+                * bin.
+                * \param xmax the upper limit of the upper
+                * bin.
+                * \param kmermap the KmerMap used to
+                * normalize the signal, nullptr for models
+                * of raw signal.
+                * \param storage how the counts are 
+                * stored.
+                * \param n_stripes the number of stripes.
+                * \throw std::invalid_argument if the
+                * parameters are inconsistent.
+                */
+                CountTable(KineticTable::layouts layout,
+                           size_t size,
+                           size_t nb_bins,
+                           double xmin,
+                           double xmax,
+                           std::shared_ptr<const ngsai::KmerMap>
+                                                        kmermap,
+                           storages storage=storages::dense,
+                           size_t n_stripes=stripe_number) ;
+
+                CountTable(const CountTable& other) = delete ;
+
+                CountTable&
+                operator = (const CountTable& other) = delete ;
+
+                /*!
+                * \brief Destructor.
+                */
+                virtual
+                ~CountTable() ;
+
+                /*!
+                * \brief Returns an empty table with the
+                * layout of this one, which gives the
+                * binning and the factor positions.
+                * \return the layout table.
+                */
+                const KineticTable&
+                getLayout() const ;
+
+                /*!
+                * \brief Appends the indices of the bins
+                * that a window of signal falls in, one per
+                * factor, to a batch.
+                * \param ipd the IPD signal of the window,
+                * it must contain getLayout().size()
+                * values.
+                * \param pwd the PWD signal of the window,
+                * it must contain getLayout().size()
+                * values.
+                * \param indices the batch.
+                */
+                template<class T>
+                void
+                getIndices(const T* ipd,
+                           const T* pwd,
+                           std::vector<size_t>& indices) const ;
+
+                /*!
+                * \brief Increments the bins of a batch.
+                * This method is thread safe.
+                * \param indices the batch, it is sorted
+                * and then emptied.
+                */
+                void
+                add(std::vector<size_t>& indices) ;
+
+                /*!
+                * \brief Saves the counts, or their log 
+                * densities, as a KineticTable in binary 
+                * format, by chunks, such that the dense 
+                * table is never held in memory.
+                * \param path the path to the file.
+                * \param contents what to save.
+                * \param pseudo_counts a number of counts
+                * added to each bin.
+                * \param n_chunk the number of values 
+                * written at once.
+                * \throw std::runtime_error if the file
+                * cannot be written.
+                */
+                void
+                save(const std::string& path,
+                     KineticTable::contents contents,
+                     double pseudo_counts,
+                     size_t n_chunk=chunk_size) const ;
+
+            protected:
+                /*!
+                * \brief Adds the counts of a range of 
+                * bins to an array.
+                * \param from the index of the first bin.
+                * \param n the number of bins.
+                * \param values the array, of n values.
+                */
+                void
+                addCounts(size_t from,
+                          size_t n,
+                          double* values) const ;
+
+            protected:
+                /*!
+                * \brief the layout table, without any 
+                * value.
+                */
+                KineticTable m_layout ;
+                /*!
+                * \brief how the counts are stored.
+                */
+                storages m_storage ;
+                /*!
+                * \brief the dense counts of each stripe, 
+                * in the value order of the layout table.
+                */
+                std::vector<CompactCounts> m_counts ;
+                /*!
+                * \brief the sparse counts of each 
+                * stripe, indexed by value.
+                */
+                std::vector<std::unordered_map<size_t,uint64_t>> 
+                                                    m_sparse ;
+                /*!
+                * \brief the number of bins per stripe.
+                */
+                size_t m_stripe_size ;
+                /*!
+                * \brief the mutex of each stripe.
+                */
+                std::unique_ptr<std::mutex[]> m_mutexes ;
+        } ;
+
+    }  // namespace app
+
+}  // namespace ngsai
+
+
+template<class T>
+void
+ngsai::app::CountTable::getIndices(const T* ipd,
+                                   const T* pwd,
+                                   std::vector<size_t>& indices) const
+{   size_t nb_bins   = m_layout.getBinNumber() ;
+    size_t n_factors = m_layout.getFactorNumber() ;
+    size_t length    = m_layout.getFactorLength() ;
+    const std::vector<uint32_t>& pos_a = m_layout.getPositionsA() ;
+    const std::vector<uint32_t>& pos_b = m_layout.getPositionsB() ;
+    bool is_raw = m_layout.getLayout() ==
+                  KineticTable::layouts::raw ;
+
+    const T* signals[2] = {ipd, pwd} ;
+    for(size_t s=0; s<2; s++)
+    {   const T* x = signals[s] ;
+        size_t offset = s * n_factors * length ;
+        for(size_t f=0; f<n_factors; f++, offset+=length)
+        {   size_t bin_a = m_layout.getBin(x[pos_a[f]]) ;
+            if(is_raw)
+            {   indices.push_back(offset + bin_a) ; }
+            else
+            {   size_t bin_b = m_layout.getBin(x[pos_b[f]]) ;
+                indices.push_back(offset + bin_a*nb_bins + bin_b) ;
+            }
+        }
+    }
+}
+
+#endif  // NGSAI_APP_COUNTTABLE_HPP
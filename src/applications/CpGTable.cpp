@@ -0,0 +1,108 @@
+#include <applications/CpGTable.hpp>
+
+#include <string>
+#include <limits>           // std::numeric_limits
+#include <stdexcept>        // std::invalid_argument
+
+#include <ngsaipp/io/BedRecord.hpp>          // ngsai::BedRecord
+#include <ngsaipp/genome/constants.hpp>      // ngsai::genome::strand
+
+
+ngsai::app::CpGTable::CpGTable()
+    : m_chrom_names(),
+      m_chrom_ids(),
+      m_chroms(),
+      m_starts(),
+      m_ends()
+{ ; }
+
+
+ngsai::app::CpGTable::~CpGTable()
+{ ; }
+
+
+void
+ngsai::app::CpGTable::add(const std::string& chrom,
+                          size_t start,
+                          size_t end)
+{   if((start > std::numeric_limits<uint32_t>::max()) or
+       (end   > std::numeric_limits<uint32_t>::max()))
+    {   throw std::invalid_argument("CpGTable error! CpG "
+                                    "coordinates must fit "
+                                    "on 32 bits") ;
+    }
+    else if(start > end)
+    {   throw std::invalid_argument("CpGTable error! CpG "
+                                    "start must be <= end") ;
+    }
+
+    // chromosome id, new chromosomes get the next id
+    auto iter = m_chrom_ids.find(chrom) ;
+    if(iter == m_chrom_ids.end())
+    {   iter = m_chrom_ids.emplace(
+                    chrom,
+                    static_cast<uint32_t>(
+                        m_chrom_names.size())).first ;
+        m_chrom_names.push_back(chrom) ;
+    }
+
+    m_chroms.push_back(iter->second) ;
+    m_starts.push_back(static_cast<uint32_t>(start)) ;
+    m_ends.push_back(static_cast<uint32_t>(end)) ;
+}
+
+
+void
+ngsai::app::CpGTable::clear()
+{   m_chrom_names.clear() ;
+    m_chrom_ids.clear() ;
+    m_chroms.clear() ;
+    m_starts.clear() ;
+    m_ends.clear() ;
+}
+
+
+size_t
+ngsai::app::CpGTable::size() const
+{   return m_starts.size() ; }
+
+
+size_t
+ngsai::app::CpGTable::getChromNumber() const
+{   return m_chrom_names.size() ; }
+
+
+uint32_t
+ngsai::app::CpGTable::getChromId(size_t i) const
+{   return m_chroms[i] ; }
+
+
+const std::string&
+ngsai::app::CpGTable::getChrom(size_t i) const
+{   return m_chrom_names[m_chroms[i]] ; }
+
+
+const std::string&
+ngsai::app::CpGTable::getChromName(uint32_t id) const
+{   return m_chrom_names[id] ; }
+
+
+uint32_t
+ngsai::app::CpGTable::getStart(size_t i) const
+{   return m_starts[i] ; }
+
+
+uint32_t
+ngsai::app::CpGTable::getEnd(size_t i) const
+{   return m_ends[i] ; }
+
+
+ngsai::genome::CpGRegion
+ngsai::app::CpGTable::getCpG(size_t i) const
+{   ngsai::BedRecord record ;
+    record.chrom  = this->getChrom(i) ;
+    record.start  = m_starts[i] ;
+    record.end    = m_ends[i] ;
+    record.strand = ngsai::genome::strand::UNORIENTED ;
+    return ngsai::genome::CpGRegion(record) ;
+}
@@ -0,0 +1,160 @@
+#ifndef NGSAI_APP_CPGTABLE_HPP
+#define NGSAI_APP_CPGTABLE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include <ngsaipp/genome/CpGRegion.hpp>     // ngsai::genome::CpGRegion
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief The CpGTable class stores a list of CpG
+        * coordinates in a contiguous structure of arrays.
+        * Each chromosome name is stored only once and
+        * CpGs refer to it through a chromosome id. The
+        * CpG coordinates are stored as 32-bit integers.
+        * The CpGs are addressed by their index, in the
+        * order in which they were added.
+        */
+        class CpGTable
+        {
+            public:
+                /*!
+                * \brief Constructor. Creates an empty
+                * table.
+                */
+                CpGTable() ;
+
+                /*!
+                * \brief Destructor.
+                */
+                virtual
+                ~CpGTable() ;
+
+                /*!
+                * \brief Adds a CpG at the end of the
+                * table.
+                * \param chrom the CpG chromosome.
+                * \param start the CpG start coordinate.
+                * \param end the CpG end coordinate.
+                * \throw std::invalid_argument if the
+                * coordinates do not fit on 32 bits or if
+                * start > end.
+                */
+                void
+                add(const std::string& chrom,
+                    size_t start,
+                    size_t end) ;
+
+                /*!
+                * \brief Removes all the CpGs and the
+                * chromosome names.
+                */
+                void
+                clear() ;
+
+                /*!
+                * \brief Returns the number of CpGs in the
+                * table.
+                * \return the number of CpGs.
+                */
+                size_t
+                size() const ;
+
+                /*!
+                * \brief Returns the number of different
+                * chromosomes in the table.
+                * \return the number of chromosomes.
+                */
+                size_t
+                getChromNumber() const ;
+
+                /*!
+                * \brief Returns the chromosome id of the
+                * i-th CpG.
+                * \param i the CpG index.
+                * \return the chromosome id.
+                */
+                uint32_t
+                getChromId(size_t i) const ;
+
+                /*!
+                * \brief Returns the chromosome name of
+                * the i-th CpG.
+                * \param i the CpG index.
+                * \return the chromosome name.
+                */
+                const std::string&
+                getChrom(size_t i) const ;
+
+                /*!
+                * \brief Returns the name of a chromosome
+                * given its id.
+                * \param id the chromosome id.
+                * \return the chromosome name.
+                */
+                const std::string&
+                getChromName(uint32_t id) const ;
+
+                /*!
+                * \brief Returns the start coordinate of
+                * the i-th CpG.
+                * \param i the CpG index.
+                * \return the start coordinate.
+                */
+                uint32_t
+                getStart(size_t i) const ;
+
+                /*!
+                * \brief Returns the end coordinate of
+                * the i-th CpG.
+                * \param i the CpG index.
+                * \return the end coordinate.
+                */
+                uint32_t
+                getEnd(size_t i) const ;
+
+                /*!
+                * \brief Creates an unoriented CpGRegion
+                * corresponding to the i-th CpG.
+                * \param i the CpG index.
+                * \return the CpG region.
+                */
+                ngsai::genome::CpGRegion
+                getCpG(size_t i) const ;
+
+            protected:
+                /*!
+                * \brief the chromosome names, by id.
+                */
+                std::vector<std::string> m_chrom_names ;
+                /*!
+                * \brief the id of each chromosome name.
+                */
+                std::unordered_map<std::string,uint32_t>
+                                            m_chrom_ids ;
+                /*!
+                * \brief the chromosome id of each CpG.
+                */
+                std::vector<uint32_t> m_chroms ;
+                /*!
+                * \brief the start coordinate of each CpG.
+                */
+                std::vector<uint32_t> m_starts ;
+                /*!
+                * \brief the end coordinate of each CpG.
+                */
+                std::vector<uint32_t> m_ends ;
+        } ;
+
+    }  // namespace app
+
+}  // namespace ngsai
+
+#endif  // NGSAI_APP_CPGTABLE_HPP
@@ -0,0 +1,39 @@
+#include <applications/EarlyStop.hpp>
+
+#include <stdexcept>            // std::invalid_argument
+
+
+ngsai::app::EarlyStop::EarlyStop(double stop_prob)
+    : m_stop_prob(stop_prob),
+      m_state(states::undecided)
+{   if((stop_prob <= 0.5) or (stop_prob > 1.))
+    {   throw std::invalid_argument("EarlyStop error! stop "
+                                    "probability must belong "
+                                    "to (0.5,1]") ;
+    }
+}
+
+
+ngsai::app::EarlyStop::~EarlyStop()
+{ ; }
+
+
+ngsai::app::EarlyStop::states
+ngsai::app::EarlyStop::getState(double prob_meth,
+                                double stop_prob)
+{   if(prob_meth >= stop_prob)
+    {   return states::methylated ; }
+    else if(1. - prob_meth >= stop_prob)
+    {   return states::unmethylated ; }
+    return states::undecided ;
+}
+
+
+bool
+ngsai::app::EarlyStop::update(double prob_meth)
+{   states state = getState(prob_meth, m_stop_prob) ;
+    bool stop    = (state != states::undecided) and
+                   (state == m_state) ;
+    m_state      = state ;
+    return stop ;
+}
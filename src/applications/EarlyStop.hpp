@@ -0,0 +1,92 @@
+#ifndef NGSAI_APP_EARLYSTOP_HPP
+#define NGSAI_APP_EARLYSTOP_HPP
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief The EarlyStop class decides when the
+        * classification of a CpG by blocks of CCSs can
+        * stop. The posterior of each block is the prior
+        * of the next one. At each block boundary, the
+        * state favoured by the posterior is recorded if
+        * its probability is past a threshold, and the
+        * classification stops once two consecutive
+        * boundaries agree on the same state.
+        */
+        class EarlyStop
+        {
+            public:
+                /*!
+                * \brief The states of a CpG at a block
+                * boundary.
+                */
+                enum class states {undecided,
+                                   methylated,
+                                   unmethylated} ;
+
+            public:
+                /*!
+                * \brief Constructor.
+                * \param stop_prob the probability that a
+                * state must reach to be recorded. It
+                * must be > 0.5.
+                * \throw std::invalid_argument if the
+                * probability is not in (0.5,1].
+                */
+                EarlyStop(double stop_prob) ;
+
+                /*!
+                * \brief Destructor.
+                */
+                virtual
+                ~EarlyStop() ;
+
+                /*!
+                * \brief Returns the state favoured by a
+                * posterior if its probability is past a
+                * threshold.
+                * \param prob_meth the posterior
+                * probability of methylation.
+                * \param stop_prob the threshold.
+                * \return the state, undecided if none
+                * reaches the threshold.
+                */
+                static
+                states
+                getState(double prob_meth,
+                         double stop_prob) ;
+
+                /*!
+                * \brief Records the posterior at a block
+                * boundary.
+                * \param prob_meth the posterior
+                * probability of methylation after the
+                * block.
+                * \return whether the classification can
+                * stop, that is whether this boundary and
+                * the previous one agree on a state.
+                */
+                bool
+                update(double prob_meth) ;
+
+            protected:
+                /*!
+                * \brief the probability that a state
+                * must reach to be recorded.
+                */
+                double m_stop_prob ;
+                /*!
+                * \brief the state at the previous block
+                * boundary.
+                */
+                states m_state ;
+        } ;
+
+    }  // namespace app
+
+}  // namespace ngsai
+
+#endif  // NGSAI_APP_EARLYSTOP_HPP
@@ -0,0 +1,429 @@
+#include <applications/KineticKernel.hpp>
+
+#include <vector>
+#include <utility>          // std::make_pair()
+#include <stdexcept>        // std::invalid_argument
+
+#if defined(__GNUC__) and (defined(__x86_64__) or defined(__i386__))
+#define NGSAI_APP_KINETICKERNEL_X86
+#include <immintrin.h>      // AVX2 and AVX-512 intrinsics
+#endif
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief Bins a range of signal values, like
+        * KineticTable::getBin() does.
+        * \param table the model.
+        * \param x the signal values.
+        * \param from the index of the first value to bin.
+        * \param to the index of the past last value to
+        * bin.
+        * \param bins the address at which the bins are
+        * written, at the same indices as the values.
+        */
+        void
+        bin_scalar(const KineticTable& table,
+                   const uint16_t* x,
+                   size_t from,
+                   size_t to,
+                   int32_t* bins)
+        {   for(size_t i=from; i<to; i++)
+            {   bins[i] = static_cast<int32_t>(
+                                    table.getBin(x[i])) ;
+            }
+        }
+
+        /*!
+        * \brief Computes the log likelihood of a range of
+        * binned windows.
+        * \param table the model.
+        * \param bins the bins of the windows, the IPD
+        * bins followed by the PWD bins, each in the same
+        * order as the signal.
+        * \param n_windows the total number of windows.
+        * \param from the index of the first window to
+        * score.
+        * \param to the index of the past last window to
+        * score.
+        * \param scores the address at which the log
+        * likelihoods are written.
+        */
+        void
+        lookup_scalar(const KineticTable& table,
+                      const int32_t* bins,
+                      size_t n_windows,
+                      size_t from,
+                      size_t to,
+                      double* scores)
+        {   const auto& pos_a = table.getPositionsA() ;
+            const auto& pos_b = table.getPositionsB() ;
+            size_t n_factors  = pos_a.size() ;
+            size_t length     = table.getFactorLength() ;
+            size_t nb_bins    = table.getBinNumber() ;
+            bool is_2d        = table.getLayout() !=
+                                    KineticTable::layouts::raw ;
+            for(size_t w=from; w<to; w++)
+            {   double ll = 0. ;
+                for(size_t s=0; s<2; s++)
+                {   const int32_t* b = bins +
+                                       s*table.size()*n_windows ;
+                    const double* v  = table.data() +
+                                       s*n_factors*length ;
+                    for(size_t f=0; f<n_factors; f++, v+=length)
+                    {   size_t i = b[pos_a[f]*n_windows + w] ;
+                        if(is_2d)
+                        {   i = i*nb_bins +
+                                b[pos_b[f]*n_windows + w] ;
+                        }
+                        ll += v[i] ;
+                    }
+                }
+                scores[w] = ll ;
+            }
+        }
+
+        /*!
+        * \brief Scalar kernel.
+        * \param table the model.
+        * \param ipd the IPD signal of the windows.
+        * \param pwd the PWD signal of the windows.
+        * \param n_windows the number of windows.
+        * \param bins a buffer of 2*size*n_windows values
+        * to store the bins.
+        * \param scores the address at which the log
+        * likelihoods are written.
+        */
+        void
+        score_scalar(const KineticTable& table,
+                     const uint16_t* ipd,
+                     const uint16_t* pwd,
+                     size_t n_windows,
+                     int32_t* bins,
+                     double* scores)
+        {   size_t n = table.size() * n_windows ;
+            bin_scalar(table, ipd, 0, n, bins) ;
+            bin_scalar(table, pwd, 0, n, bins + n) ;
+            lookup_scalar(table, bins, n_windows,
+                          0, n_windows, scores) ;
+        }
+
+#ifdef NGSAI_APP_KINETICKERNEL_X86
+// the intrinsics initialise their unused lanes from
+// _mm*_undefined_*(), which some GCC versions report
+// as uninitialised once inlined
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Wuninitialized"
+
+        /*!
+        * \brief Bins 4 signal values given as doubles.
+        * \param x the values.
+        * \param xmin the lower limit of the lower bin.
+        * \param scale the number of bins per unit of
+        * signal.
+        * \param bmax the index of the upper bin.
+        * \return the bins.
+        */
+        __attribute__((target("avx2")))
+        __m128i
+        bin_avx2(__m256d x,
+                 __m256d xmin,
+                 __m256d scale,
+                 __m256d bmax)
+        {   __m256d b = _mm256_mul_pd(_mm256_sub_pd(x, xmin),
+                                      scale) ;
+            b = _mm256_max_pd(b, _mm256_setzero_pd()) ;
+            b = _mm256_min_pd(b, bmax) ;
+            return _mm256_cvttpd_epi32(b) ;
+        }
+
+        /*!
+        * \brief AVX2 kernel, 8 values are binned and 4
+        * windows are looked up at a time.
+        * \param table the model.
+        * \param ipd the IPD signal of the windows.
+        * \param pwd the PWD signal of the windows.
+        * \param n_windows the number of windows.
+        * \param bins a buffer of 2*size*n_windows values
+        * to store the bins.
+        * \param scores the address at which the log
+        * likelihoods are written.
+        */
+        __attribute__((target("avx2")))
+        void
+        score_avx2(const KineticTable& table,
+                   const uint16_t* ipd,
+                   const uint16_t* pwd,
+                   size_t n_windows,
+                   int32_t* bins,
+                   double* scores)
+        {   // binning
+            size_t n = table.size() * n_windows ;
+            __m256d xmin  = _mm256_set1_pd(table.getXmin()) ;
+            __m256d scale = _mm256_set1_pd(
+                                static_cast<double>(
+                                    table.getBinNumber()) /
+                                (table.getXmax() -
+                                 table.getXmin())) ;
+            __m256d bmax  = _mm256_set1_pd(
+                                static_cast<double>(
+                                    table.getBinNumber() - 1)) ;
+            for(const auto& p : {std::make_pair(ipd, bins),
+                                 std::make_pair(pwd, bins + n)})
+            {   size_t i = 0 ;
+                for( ; i+8<=n; i+=8)
+                {   __m128i x  = _mm_loadu_si128(
+                                    reinterpret_cast<const __m128i*>(
+                                                    p.first + i)) ;
+                    __m256d lo = _mm256_cvtepi32_pd(
+                                    _mm_cvtepu16_epi32(x)) ;
+                    __m256d hi = _mm256_cvtepi32_pd(
+                                    _mm_cvtepu16_epi32(
+                                        _mm_srli_si128(x, 8))) ;
+                    _mm_storeu_si128(
+                        reinterpret_cast<__m128i*>(p.second + i),
+                        bin_avx2(lo, xmin, scale, bmax)) ;
+                    _mm_storeu_si128(
+                        reinterpret_cast<__m128i*>(p.second + i + 4),
+                        bin_avx2(hi, xmin, scale, bmax)) ;
+                }
+                bin_scalar(table, p.first, i, n, p.second) ;
+            }
+
+            // lookup
+            const auto& pos_a = table.getPositionsA() ;
+            const auto& pos_b = table.getPositionsB() ;
+            size_t n_factors  = pos_a.size() ;
+            size_t length     = table.getFactorLength() ;
+            bool is_2d        = table.getLayout() !=
+                                    KineticTable::layouts::raw ;
+            __m128i nb_bins   = _mm_set1_epi32(
+                                    static_cast<int32_t>(
+                                        table.getBinNumber())) ;
+            size_t w = 0 ;
+            for( ; w+4<=n_windows; w+=4)
+            {   __m256d ll = _mm256_setzero_pd() ;
+                for(size_t s=0; s<2; s++)
+                {   const int32_t* b = bins + s*n + w ;
+                    const double* v  = table.data() +
+                                       s*n_factors*length ;
+                    for(size_t f=0; f<n_factors; f++, v+=length)
+                    {   __m128i i = _mm_loadu_si128(
+                                        reinterpret_cast<const __m128i*>(
+                                            b + pos_a[f]*n_windows)) ;
+                        if(is_2d)
+                        {   __m128i j = _mm_loadu_si128(
+                                        reinterpret_cast<const __m128i*>(
+                                            b + pos_b[f]*n_windows)) ;
+                            i = _mm_add_epi32(
+                                    _mm_mullo_epi32(i, nb_bins), j) ;
+                        }
+                        ll = _mm256_add_pd(
+                                ll, _mm256_i32gather_pd(v, i, 8)) ;
+                    }
+                }
+                _mm256_storeu_pd(scores + w, ll) ;
+            }
+            lookup_scalar(table, bins, n_windows,
+                          w, n_windows, scores) ;
+        }
+
+        /*!
+        * \brief AVX-512 kernel, 8 values are binned and 8
+        * windows are looked up at a time.
+        * \param table the model.
+        * \param ipd the IPD signal of the windows.
+        * \param pwd the PWD signal of the windows.
+        * \param n_windows the number of windows.
+        * \param bins a buffer of 2*size*n_windows values
+        * to store the bins.
+        * \param scores the address at which the log
+        * likelihoods are written.
+        */
+        __attribute__((target("avx2,avx512f")))
+        void
+        score_avx512(const KineticTable& table,
+                     const uint16_t* ipd,
+                     const uint16_t* pwd,
+                     size_t n_windows,
+                     int32_t* bins,
+                     double* scores)
+        {   // binning
+            size_t n = table.size() * n_windows ;
+            __m512d xmin  = _mm512_set1_pd(table.getXmin()) ;
+            __m512d scale = _mm512_set1_pd(
+                                static_cast<double>(
+                                    table.getBinNumber()) /
+                                (table.getXmax() -
+                                 table.getXmin())) ;
+            __m512d bmax  = _mm512_set1_pd(
+                                static_cast<double>(
+                                    table.getBinNumber() - 1)) ;
+            for(const auto& p : {std::make_pair(ipd, bins),
+                                 std::make_pair(pwd, bins + n)})
+            {   size_t i = 0 ;
+                for( ; i+8<=n; i+=8)
+                {   __m128i x = _mm_loadu_si128(
+                                    reinterpret_cast<const __m128i*>(
+                                                    p.first + i)) ;
+                    __m512d b = _mm512_cvtepi32_pd(
+                                    _mm256_cvtepu16_epi32(x)) ;
+                    b = _mm512_mul_pd(_mm512_sub_pd(b, xmin),
+                                      scale) ;
+                    b = _mm512_max_pd(b, _mm512_setzero_pd()) ;
+                    b = _mm512_min_pd(b, bmax) ;
+                    _mm256_storeu_si256(
+                        reinterpret_cast<__m256i*>(p.second + i),
+                        _mm512_cvttpd_epi32(b)) ;
+                }
+                bin_scalar(table, p.first, i, n, p.second) ;
+            }
+
+            // lookup
+            const auto& pos_a = table.getPositionsA() ;
+            const auto& pos_b = table.getPositionsB() ;
+            size_t n_factors  = pos_a.size() ;
+            size_t length     = table.getFactorLength() ;
+            bool is_2d        = table.getLayout() !=
+                                    KineticTable::layouts::raw ;
+            __m256i nb_bins   = _mm256_set1_epi32(
+                                    static_cast<int32_t>(
+                                        table.getBinNumber())) ;
+            size_t w = 0 ;
+            for( ; w+8<=n_windows; w+=8)
+            {   __m512d ll = _mm512_setzero_pd() ;
+                for(size_t s=0; s<2; s++)
+                {   const int32_t* b = bins + s*n + w ;
+                    const double* v  = table.data() +
+                                       s*n_factors*length ;
+                    for(size_t f=0; f<n_factors; f++, v+=length)
+                    {   __m256i i = _mm256_loadu_si256(
+                                        reinterpret_cast<const __m256i*>(
+                                            b + pos_a[f]*n_windows)) ;
+                        if(is_2d)
+                        {   __m256i j = _mm256_loadu_si256(
+                                        reinterpret_cast<const __m256i*>(
+                                            b + pos_b[f]*n_windows)) ;
+                            i = _mm256_add_epi32(
+                                    _mm256_mullo_epi32(i, nb_bins), j) ;
+                        }
+                        ll = _mm512_add_pd(
+                                ll, _mm512_i32gather_pd(i, v, 8)) ;
+                    }
+                }
+                _mm512_storeu_pd(scores + w, ll) ;
+            }
+            lookup_scalar(table, bins, n_windows,
+                          w, n_windows, scores) ;
+        }
+#pragma GCC diagnostic pop
+#endif  // NGSAI_APP_KINETICKERNEL_X86
+
+    }  // namespace app
+
+}  // namespace ngsai
+
+
+ngsai::app::KineticKernel::isas
+ngsai::app::KineticKernel::getBestIsa()
+{   if(isSupported(isas::avx512))
+    {   return isas::avx512 ; }
+    else if(isSupported(isas::avx2))
+    {   return isas::avx2 ; }
+    return isas::scalar ;
+}
+
+
+bool
+ngsai::app::KineticKernel::isSupported(isas isa)
+{
+#ifdef NGSAI_APP_KINETICKERNEL_X86
+    if(isa == isas::avx512)
+    {   return __builtin_cpu_supports("avx2") and
+               __builtin_cpu_supports("avx512f") ;
+    }
+    else if(isa == isas::avx2)
+    {   return __builtin_cpu_supports("avx2") ; }
+#endif
+    return isa == isas::scalar ;
+}
+
+
+std::string
+ngsai::app::KineticKernel::toString(isas isa)
+{   if(isa == isas::avx512)
+    {   return "avx512" ; }
+    else if(isa == isas::avx2)
+    {   return "avx2" ; }
+    return "scalar" ;
+}
+
+
+ngsai::app::KineticKernel::KineticKernel()
+    : m_isa(getBestIsa())
+{ ; }
+
+
+ngsai::app::KineticKernel::KineticKernel(isas isa)
+    : m_isa(isa)
+{   if(not isSupported(isa))
+    {   throw std::invalid_argument("KineticKernel error! "
+                                    "instruction set " +
+                                    toString(isa) +
+                                    " is not supported by "
+                                    "the CPU") ;
+    }
+}
+
+
+ngsai::app::KineticKernel::~KineticKernel()
+{ ; }
+
+
+ngsai::app::KineticKernel::isas
+ngsai::app::KineticKernel::getIsa() const
+{   return m_isa ; }
+
+
+void
+ngsai::app::KineticKernel::score(const KineticTable& table,
+                                 const uint16_t* ipd,
+                                 const uint16_t* pwd,
+                                 size_t n_windows,
+                                 double* scores) const
+{   std::vector<int32_t> bins ;
+    this->score(table, ipd, pwd, n_windows, scores, bins) ;
+}
+
+
+void
+ngsai::app::KineticKernel::score(const KineticTable& table,
+                                 const uint16_t* ipd,
+                                 const uint16_t* pwd,
+                                 size_t n_windows,
+                                 double* scores,
+                                 std::vector<int32_t>& bins) const
+{   if(n_windows == 0)
+    {   return ; }
+
+    if(bins.size() < 2 * table.size() * n_windows)
+    {   bins.resize(2 * table.size() * n_windows) ; }
+#ifdef NGSAI_APP_KINETICKERNEL_X86
+    if(m_isa == isas::avx512)
+    {   score_avx512(table, ipd, pwd, n_windows,
+                     bins.data(), scores) ;
+        return ;
+    }
+    else if(m_isa == isas::avx2)
+    {   score_avx2(table, ipd, pwd, n_windows,
+                   bins.data(), scores) ;
+        return ;
+    }
+#endif
+    score_scalar(table, ipd, pwd, n_windows,
+                 bins.data(), scores) ;
+}
@@ -0,0 +1,158 @@
+#ifndef NGSAI_APP_KINETICKERNEL_HPP
+#define NGSAI_APP_KINETICKERNEL_HPP
+
+#include <string>
+#include <cstdint>
+#include <vector>
+
+#include <applications/KineticTable.hpp>    // ngsai::app::KineticTable
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief The KineticKernel class scores batches of
+        * windows of raw kinetic signal under a
+        * KineticTable.
+        * The windows are given as structures of arrays :
+        * the signal of all the windows at the 1st
+        * position, then at the 2nd position, etc, such
+        * that consecutive windows can be binned and
+        * looked up together in vector registers.
+        * The kernel uses the widest instruction set
+        * supported by the CPU among AVX-512, AVX2 and
+        * plain scalar code. All of them return the same
+        * values as KineticTable::logLikelihood().
+        */
+        class KineticKernel
+        {
+            public:
+                /*!
+                * \brief The instruction sets the kernel
+                * can use.
+                */
+                enum class isas {scalar,
+                                 avx2,
+                                 avx512} ;
+
+            public:
+                /*!
+                * \brief Returns the widest instruction set
+                * supported by the CPU.
+                * \return the instruction set.
+                */
+                static
+                isas
+                getBestIsa() ;
+
+                /*!
+                * \brief Checks whether the CPU supports
+                * an instruction set.
+                * \param isa the instruction set.
+                * \return whether it is supported.
+                */
+                static
+                bool
+                isSupported(isas isa) ;
+
+                /*!
+                * \brief Returns the name of an
+                * instruction set.
+                * \param isa the instruction set.
+                * \return the name.
+                */
+                static
+                std::string
+                toString(isas isa) ;
+
+            public:
+                /*!
+                * \brief Constructor. Creates a kernel
+                * using the widest instruction set
+                * supported by the CPU.
+                */
+                KineticKernel() ;
+
+                /*!
+                * \brief Constructor. Creates a kernel
+                * using the given instruction set.
+                * \param isa the instruction set.
+                * \throw std::invalid_argument if the CPU
+                * does not support the instruction set.
+                */
+                KineticKernel(isas isa) ;
+
+                /*!
+                * \brief Destructor.
+                */
+                virtual
+                ~KineticKernel() ;
+
+                /*!
+                * \brief Returns the instruction set used.
+                * \return the instruction set.
+                */
+                isas
+                getIsa() const ;
+
+                /*!
+                * \brief Computes the log likelihood of
+                * a batch of windows.
+                * \param table the model, it must contain
+                * at most 2^31 values per factor.
+                * \param ipd the IPD signal of the windows,
+                * the value of window w at position p is
+                * ipd[p*n_windows + w].
+                * \param pwd the PWD signal of the windows,
+                * in the same order as the IPD signal.
+                * \param n_windows the number of windows.
+                * \param scores the address at which the
+                * log likelihood of each window is written,
+                * there must be room for n_windows values.
+                */
+                void
+                score(const KineticTable& table,
+                      const uint16_t* ipd,
+                      const uint16_t* pwd,
+                      size_t n_windows,
+                      double* scores) const ;
+
+                /*!
+                * \brief Computes the log likelihood of
+                * a batch of windows, like
+                * score(const KineticTable&, const uint16_t*,
+                * const uint16_t*, size_t, double*) does,
+                * using a caller provided buffer for the
+                * bins, such that repeated calls do not
+                * allocate memory.
+                * \param table the model.
+                * \param ipd the IPD signal of the windows.
+                * \param pwd the PWD signal of the windows.
+                * \param n_windows the number of windows.
+                * \param scores the address at which the
+                * log likelihood of each window is written.
+                * \param bins the bin buffer, it is grown
+                * if needed.
+                */
+                void
+                score(const KineticTable& table,
+                      const uint16_t* ipd,
+                      const uint16_t* pwd,
+                      size_t n_windows,
+                      double* scores,
+                      std::vector<int32_t>& bins) const ;
+
+            protected:
+                /*!
+                * \brief the instruction set used.
+                */
+                isas m_isa ;
+        } ;
+
+    }  // namespace app
+
+}  // namespace ngsai
+
+#endif  // NGSAI_APP_KINETICKERNEL_HPP
@@ -0,0 +1,824 @@
+#include <applications/KineticTable.hpp>
+
+#include <string>
+#include <vector>
+#include <cmath>            // std::log(), std::isinf()
+#include <cstring>          // std::memcpy(), std::memcmp()
+#include <sstream>          // std::ostringstream, std::istringstream
+#include <fstream>          // std::ofstream
+#include <stdexcept>        // std::invalid_argument, std::runtime_error
+#include <algorithm>        // std::copy(), std::min(), std::max()
+#include <functional>       // std::function
+#include <limits>           // std::numeric_limits
+#include <boost/archive/text_oarchive.hpp>  // boost::archive::text_oarchive
+#include <boost/archive/text_iarchive.hpp>  // boost::archive::text_iarchive
+
+#include <ngsaipp/epigenetics/RawKineticModel.hpp>                   // ngsai::RawKineticModel
+#include <ngsaipp/epigenetics/NormalizedKineticModel.hpp>            // ngsai::NormalizedKineticModel
+#include <ngsaipp/epigenetics/DiPositionKineticModel.hpp>            // ngsai::DiPositionKineticModel
+#include <ngsaipp/epigenetics/DiPositionNormalizedKineticModel.hpp>  // ngsai::DiPositionNormalizedKineticModel
+#include <ngsaipp/epigenetics/PairWiseKineticModel.hpp>              // ngsai::PairWiseKineticModel
+#include <ngsaipp/epigenetics/PairWiseNormalizedKineticModel.hpp>    // ngsai::PairWiseNormalizedKineticModel
+#include <applications/kinetic_model_utility.hpp>                    // ngsai::app::are_equal(), ngsai::app::has_histograms, ngsai::app::get_kmermap()
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief Compiles a histogram based kinetic model
+        * into a table.
+        * \param model the model, it must give access to
+        * its IPD and PWD histograms, one per factor, in
+        * the table factor order, each with a flat vector
+        * of counts. Those of a 2D layout hold the bins of
+        * both axes, row after row.
+        * \param layout the model layout.
+        * \param kmermap the KmerMap used to normalize the
+        * signal, nullptr if none.
+        * \return the table.
+        * \throw std::invalid_argument if the model type
+        * does not give access to its histograms or if
+        * they do not match the layout.
+        */
+        template<class M>
+        KineticTable
+        compile_model(const M& model,
+                      KineticTable::layouts layout,
+                      std::shared_ptr<const ngsai::KmerMap> kmermap)
+        {   if constexpr(not has_histograms<M>::value)
+            {   throw std::invalid_argument(
+                            "KineticTable error! the histograms "
+                            "of this kinetic model type are not "
+                            "accessible, train the tables with "
+                            "model-kinetic --shared instead") ;
+            }
+            else
+            {   const auto& hists_ipd = model.getHistogramsIPD() ;
+                const auto& hists_pwd = model.getHistogramsPWD() ;
+                if(hists_ipd.empty() or
+                   (hists_ipd.size() != hists_pwd.size()))
+                {   throw std::invalid_argument(
+                                "KineticTable error! model "
+                                "histograms are inconsistent") ;
+                }
+
+                const auto& first = hists_ipd.front() ;
+                KineticTable table(layout,
+                                   model.size(),
+                                   first.getBinNumber(),
+                                   first.getLowerBound(),
+                                   first.getUpperBound(),
+                                   kmermap) ;
+                if(table.getFactorNumber() != hists_ipd.size())
+                {   throw std::invalid_argument(
+                                "KineticTable error! unexpected "
+                                "number of model histograms") ;
+                }
+
+                size_t length = table.getFactorLength() ;
+                double* values = table.data() ;
+                for(const auto& hists : {&hists_ipd, &hists_pwd})
+                {   for(const auto& hist : *hists)
+                    {   const auto& counts = hist.getCounts() ;
+                        if(counts.size() != length)
+                        {   throw std::invalid_argument(
+                                        "KineticTable error! model "
+                                        "histograms do not match "
+                                        "the table layout") ;
+                        }
+                        values = std::copy(counts.begin(),
+                                           counts.end(),
+                                           values) ;
+                    }
+                }
+                return table ;
+            }
+        }
+
+        /*!
+        * \brief Multiplies two sizes unless the product
+        * overflows.
+        * \param a the first size.
+        * \param b the second size.
+        * \param product a reference to store the
+        * product.
+        * \return whether the product fits in a size_t.
+        */
+        bool
+        checked_multiply(size_t a,
+                         size_t b,
+                         size_t& product)
+        {   if((a != 0) and
+               (b > std::numeric_limits<size_t>::max() / a))
+            {   return false ; }
+            product = a * b ;
+            return true ;
+        }
+
+        /*!
+        * \brief Computes the number of values of a table,
+        * IPD and PWD factors together, without building
+        * it.
+        * \param layout the table layout.
+        * \param size the window size, it must be > 0
+        * and > 1 for the 2D layouts.
+        * \param nb_bins the number of bins per axis.
+        * \param n_values a reference to store the number
+        * of values.
+        * \return whether the number of values fits in a
+        * size_t.
+        */
+        bool
+        get_value_number(KineticTable::layouts layout,
+                         size_t size,
+                         size_t nb_bins,
+                         size_t& n_values)
+        {   size_t n_factors = size ;
+            size_t length    = nb_bins ;
+            if(layout == KineticTable::layouts::diposition)
+            {   n_factors = size - 1 ; }
+            else if(layout == KineticTable::layouts::pairwise)
+            {   // the product of 2 consecutive numbers is even
+                if(not checked_multiply(size, size - 1, n_factors))
+                {   return false ; }
+                n_factors /= 2 ;
+            }
+            if((layout != KineticTable::layouts::raw) and
+               (not checked_multiply(nb_bins, nb_bins, length)))
+            {   return false ; }
+            return checked_multiply(n_factors, length, n_values) and
+                   checked_multiply(n_values, 2, n_values) ;
+        }
+
+        /*!
+        * \brief The header of the binary table files.
+        * The values follow the header, the serialized
+        * KmerMap follows the values.
+        */
+        struct KineticTableHeader
+        {   /*!
+            * \brief identifies the file type.
+            */
+            char magic[8] ;
+            /*!
+            * \brief the format version.
+            */
+            uint32_t version ;
+            /*!
+            * \brief 0x01020304 as written by the
+            * machine, to detect byte order mismatches.
+            */
+            uint32_t byte_order ;
+            /*!
+            * \brief the model layout.
+            */
+            uint32_t layout ;
+            /*!
+            * \brief what the values are, 0 for log
+            * densities and 1 for counts.
+            */
+            uint32_t contents ;
+            /*!
+            * \brief the window size in bp.
+            */
+            uint64_t size ;
+            /*!
+            * \brief the number of bins per axis.
+            */
+            uint64_t nb_bins ;
+            /*!
+            * \brief the lower limit of the lower bin.
+            */
+            double xmin ;
+            /*!
+            * \brief the upper limit of the upper bin.
+            */
+            double xmax ;
+            /*!
+            * \brief the size of the serialized KmerMap in
+            * bytes, 0 if none.
+            */
+            uint64_t kmermap_size ;
+        } ;
+
+        static_assert(sizeof(KineticTableHeader) == 64,
+                      "unexpected KineticTableHeader size") ;
+
+        /*!
+        * \brief The value identifying the binary table
+        * files.
+        */
+        const char kinetic_table_magic[8] = {'P','A','P','E',
+                                             'T','K','T','B'} ;
+
+        /*!
+        * \brief Serializes the KmerMap of a table.
+        * \param table the table.
+        * \return the boost text archive of the KmerMap,
+        * empty if the signal is not normalized.
+        */
+        std::string
+        serialize_kmermap(const KineticTable& table)
+        {   if(not table.isNormalized())
+            {   return std::string() ; }
+            std::ostringstream stream ;
+            {   boost::archive::text_oarchive arch(stream) ;
+                arch << (*table.getKmerMap()) ;
+            }
+            return stream.str() ;
+        }
+
+        /*!
+        * \brief Creates the header of the binary file of
+        * a table.
+        * \param table the table.
+        * \param kmermap_size the size of the serialized
+        * KmerMap in bytes.
+        * \return the header.
+        */
+        KineticTableHeader
+        make_header(const KineticTable& table,
+                    size_t kmermap_size)
+        {   KineticTableHeader header ;
+            std::memcpy(header.magic,
+                        kinetic_table_magic,
+                        sizeof(header.magic)) ;
+            header.version      = KineticTable::version ;
+            header.byte_order   = 0x01020304 ;
+            header.layout       = static_cast<uint32_t>(
+                                        table.getLayout()) ;
+            header.contents     = static_cast<uint32_t>(
+                                        table.getContents()) ;
+            header.size         = table.size() ;
+            header.nb_bins      = table.getBinNumber() ;
+            header.xmin         = table.getXmin() ;
+            header.xmax         = table.getXmax() ;
+            header.kmermap_size = kmermap_size ;
+            return header ;
+        }
+
+    }  // namespace app
+
+}  // namespace ngsai
+
+
+ngsai::app::KineticTable
+ngsai::app::KineticTable::fromModel(
+                        const ngsai::KineticModel& model)
+{   if(not model.isInit())
+    {   throw std::invalid_argument("KineticTable error! "
+                                    "model is not "
+                                    "initialised") ;
+    }
+    else if(not model.isLog())
+    {   throw std::invalid_argument("KineticTable error! "
+                                    "model does not contain "
+                                    "log densities") ;
+    }
+
+    // normalized types first in case they derive from
+    // the raw signal types
+    if(auto m = dynamic_cast<
+        const ngsai::NormalizedKineticModel*>(&model))
+    {   return compile_model(
+                    *m,
+                    layouts::raw,
+                    std::make_shared<const ngsai::KmerMap>(
+                                        get_kmermap(*m))) ;
+    }
+    else if(auto m = dynamic_cast<
+        const ngsai::DiPositionNormalizedKineticModel*>(&model))
+    {   return compile_model(
+                    *m,
+                    layouts::diposition,
+                    std::make_shared<const ngsai::KmerMap>(
+                                        get_kmermap(*m))) ;
+    }
+    else if(auto m = dynamic_cast<
+        const ngsai::PairWiseNormalizedKineticModel*>(&model))
+    {   return compile_model(
+                    *m,
+                    layouts::pairwise,
+                    std::make_shared<const ngsai::KmerMap>(
+                                        get_kmermap(*m))) ;
+    }
+    else if(auto m = dynamic_cast<
+        const ngsai::RawKineticModel*>(&model))
+    {   return compile_model(*m, layouts::raw, nullptr) ; }
+    else if(auto m = dynamic_cast<
+        const ngsai::DiPositionKineticModel*>(&model))
+    {   return compile_model(*m, layouts::diposition, nullptr) ; }
+    else if(auto m = dynamic_cast<
+        const ngsai::PairWiseKineticModel*>(&model))
+    {   return compile_model(*m, layouts::pairwise, nullptr) ; }
+
+    throw std::invalid_argument("KineticTable error! "
+                                "unknown kinetic model "
+                                "type") ;
+}
+
+
+ngsai::app::KineticTable
+ngsai::app::KineticTable::difference(
+                            const KineticTable& table_a,
+                            const KineticTable& table_b)
+{   if(not table_a.isCompatible(table_b))
+    {   throw std::invalid_argument("KineticTable error! "
+                                    "cannot subtract tables "
+                                    "with different layouts, "
+                                    "binnings or KmerMaps") ;
+    }
+
+    KineticTable table(table_a) ;
+    const double* values_b = table_b.data() ;
+    double* values = table.data() ;
+    for(size_t i=0; i<table.getValueNumber(); i++)
+    {   // -inf - -inf is NaN
+        if(std::isinf(values[i]) and (values[i] == values_b[i]))
+        {   values[i] = 0. ; }
+        else
+        {   values[i] -= values_b[i] ; }
+    }
+    return table ;
+}
+
+
+const std::string
+ngsai::app::KineticTable::extension = ".binkineticmodel" ;
+
+
+const uint32_t
+ngsai::app::KineticTable::version = 1 ;
+
+
+ngsai::app::KineticTable
+ngsai::app::KineticTable::load(const std::string& path)
+{   auto file = std::make_shared<const MappedFile>(path) ;
+
+    // header
+    KineticTableHeader header ;
+    if(file->size() < sizeof(header))
+    {   throw std::runtime_error("KineticTable error! " +
+                                 path + " is too small to "
+                                 "be a table file") ;
+    }
+    std::memcpy(&header, file->data(), sizeof(header)) ;
+    if(std::memcmp(header.magic,
+                   kinetic_table_magic,
+                   sizeof(header.magic)) != 0)
+    {   throw std::runtime_error("KineticTable error! " +
+                                 path + " is not a table "
+                                 "file") ;
+    }
+    else if(header.version != version)
+    {   throw std::runtime_error("KineticTable error! " +
+                                 path + " has unsupported "
+                                 "format version " +
+                                 std::to_string(
+                                    header.version)) ;
+    }
+    else if(header.byte_order != 0x01020304)
+    {   throw std::runtime_error("KineticTable error! " +
+                                 path + " was written "
+                                 "with a different byte "
+                                 "order") ;
+    }
+    else if(header.layout >
+            static_cast<uint32_t>(layouts::pairwise))
+    {   throw std::runtime_error("KineticTable error! " +
+                                 path + " has an unknown "
+                                 "layout") ;
+    }
+    else if(header.contents >
+            static_cast<uint32_t>(contents::counts))
+    {   throw std::runtime_error("KineticTable error! " +
+                                 path + " has unknown "
+                                 "contents") ;
+    }
+
+    else if((header.size == 0) or
+            ((header.layout != static_cast<uint32_t>(
+                                        layouts::raw)) and
+             (header.size < 2)) or
+            (header.nb_bins == 0))
+    {   throw std::runtime_error("KineticTable error! " +
+                                 path + " has an invalid "
+                                 "size or number of bins") ;
+    }
+
+    // the header is checked against the file size before
+    // anything is built from it
+    size_t n_values    = 0 ;
+    size_t values_size = 0 ;
+    size_t data_size   = file->size() - sizeof(header) ;
+    if((not get_value_number(static_cast<layouts>(header.layout),
+                             header.size,
+                             header.nb_bins,
+                             n_values)) or
+       (not checked_multiply(n_values,
+                             sizeof(double),
+                             values_size)) or
+       (values_size > data_size) or
+       (header.kmermap_size != data_size - values_size))
+    {   throw std::runtime_error("KineticTable error! " +
+                                 path + " size does not "
+                                 "match its header") ;
+    }
+
+    // KmerMap
+    KineticTable table ;
+    table.init(static_cast<layouts>(header.layout),
+               header.size,
+               header.nb_bins,
+               header.xmin,
+               header.xmax,
+               nullptr) ;
+    table.m_contents = static_cast<contents>(header.contents) ;
+    if(header.kmermap_size > 0)
+    {   auto kmermap = std::make_shared<ngsai::KmerMap>(1) ;
+        std::istringstream stream(
+                    std::string(file->data() +
+                                    sizeof(header) +
+                                    values_size,
+                                header.kmermap_size)) ;
+        boost::archive::text_iarchive arch(stream) ;
+        arch >> (*kmermap) ;
+        table.m_kmermap = kmermap ;
+    }
+
+    // values are used in place
+    table.m_mapped = reinterpret_cast<const double*>(
+                                file->data() +
+                                sizeof(header)) ;
+    table.m_file   = file ;
+    return table ;
+}
+
+
+void
+ngsai::app::KineticTable::sum(
+                        const std::vector<std::string>& paths,
+                        const std::string& path_out,
+                        contents contents_out,
+                        double pseudo_counts,
+                        size_t chunk_size)
+{   if(paths.empty())
+    {   throw std::invalid_argument("KineticTable error! "
+                                    "no table to sum") ;
+    }
+
+    // the values are read in place from the files
+    std::vector<KineticTable> tables ;
+    for(const auto& path : paths)
+    {   tables.push_back(KineticTable::load(path)) ;
+        if(tables.back().getContents() != contents::counts)
+        {   throw std::invalid_argument("KineticTable error! " +
+                                        path + " does not "
+                                        "contain counts") ;
+        }
+        else if(not tables.back().isCompatible(tables.front()))
+        {   throw std::invalid_argument("KineticTable error! " +
+                                        path + " has a "
+                                        "different layout, "
+                                        "binning or KmerMap "
+                                        "than " + paths.front()) ;
+        }
+    }
+
+    // the sum is written as it is computed
+    KineticTable::writeCounts(
+                tables.front(),
+                path_out,
+                contents_out,
+                pseudo_counts,
+                chunk_size,
+                [&tables](size_t from, size_t n, double* chunk)
+                {   for(const auto& t : tables)
+                    {   const double* values = t.data() + from ;
+                        for(size_t i=0; i<n; i++)
+                        {   chunk[i] += values[i] ; }
+                    }
+                }) ;
+}
+
+
+void
+ngsai::app::KineticTable::writeCounts(
+                const KineticTable& layout,
+                const std::string& path_out,
+                contents contents_out,
+                double pseudo_counts,
+                size_t chunk_size,
+                const std::function<void(size_t,
+                                         size_t,
+                                         double*)>& add_counts)
+{   // only the parameters are needed for the header
+    KineticTable table = KineticTable::makeLayout(
+                                    layout.getLayout(),
+                                    layout.size(),
+                                    layout.getBinNumber(),
+                                    layout.getXmin(),
+                                    layout.getXmax(),
+                                    layout.getKmerMap()) ;
+    table.m_contents = contents_out ;
+    std::string kmermap = serialize_kmermap(table) ;
+    KineticTableHeader header = make_header(table,
+                                            kmermap.size()) ;
+
+    std::ofstream file(path_out, std::ios::binary) ;
+    file.write(reinterpret_cast<const char*>(&header),
+               sizeof(header)) ;
+
+    // chunks of whole factors, such that the densities 
+    // can be computed chunk by chunk
+    size_t length   = table.getFactorLength() ;
+    size_t n_values = table.getValueNumber() ;
+    chunk_size = std::max(size_t(1),
+                          (chunk_size + length - 1) / length) *
+                 length ;
+    std::vector<double> chunk ;
+    for(size_t from=0; from<n_values; from+=chunk_size)
+    {   size_t n = std::min(chunk_size, n_values - from) ;
+        chunk.assign(n, pseudo_counts) ;
+        add_counts(from, n, chunk.data()) ;
+        if(contents_out == contents::log_densities)
+        {   for(size_t offset=0; offset<n; offset+=length)
+            {   double total = 0. ;
+                for(size_t i=offset; i<offset+length; i++)
+                {   total += chunk[i] ; }
+                for(size_t i=offset; i<offset+length; i++)
+                {   if(total > 0.)
+                    {   chunk[i] = std::log(chunk[i] / total) ; }
+                    else
+                    {   chunk[i] = -std::log(double(length)) ; }
+                }
+            }
+        }
+        file.write(reinterpret_cast<const char*>(chunk.data()),
+                   n * sizeof(double)) ;
+    }
+    file.write(kmermap.data(), kmermap.size()) ;
+    file.close() ;
+    if(not file)
+    {   throw std::runtime_error("KineticTable error! "
+                                 "could not write " +
+                                 path_out) ;
+    }
+}
+
+
+ngsai::app::KineticTable
+ngsai::app::KineticTable::makeLayout(
+                layouts layout,
+                size_t size,
+                size_t nb_bins,
+                double xmin,
+                double xmax,
+                std::shared_ptr<const ngsai::KmerMap> kmermap)
+{   KineticTable table ;
+    table.init(layout, size, nb_bins, xmin, xmax, kmermap) ;
+    return table ;
+}
+
+
+ngsai::app::KineticTable::KineticTable()
+    : m_layout(layouts::raw),
+      m_contents(contents::log_densities),
+      m_size(0),
+      m_nb_bins(0),
+      m_xmin(0.),
+      m_xmax(0.),
+      m_bin_scale(0.),
+      m_kmermap(nullptr),
+      m_pos_a(),
+      m_pos_b(),
+      m_values(),
+      m_file(nullptr),
+      m_mapped(nullptr)
+{ ; }
+
+
+ngsai::app::KineticTable::KineticTable(
+                layouts layout,
+                size_t size,
+                size_t nb_bins,
+                double xmin,
+                double xmax,
+                std::shared_ptr<const ngsai::KmerMap> kmermap)
+    : KineticTable()
+{   this->init(layout, size, nb_bins, xmin, xmax, kmermap) ;
+    m_values.assign(this->getValueNumber(), 0.) ;
+}
+
+
+void
+ngsai::app::KineticTable::init(
+                layouts layout,
+                size_t size,
+                size_t nb_bins,
+                double xmin,
+                double xmax,
+                std::shared_ptr<const ngsai::KmerMap> kmermap)
+{   if(size == 0)
+    {   throw std::invalid_argument("KineticTable error! "
+                                    "size must be > 0") ;
+    }
+    else if((layout != layouts::raw) and (size < 2))
+    {   throw std::invalid_argument("KineticTable error! "
+                                    "size must be > 1 for "
+                                    "2D factors") ;
+    }
+    else if(nb_bins == 0)
+    {   throw std::invalid_argument("KineticTable error! "
+                                    "number of bins must "
+                                    "be > 0") ;
+    }
+    else if(not (xmin < xmax))
+    {   throw std::invalid_argument("KineticTable error! "
+                                    "xmin must be smaller "
+                                    "than xmax") ;
+    }
+    // getValueNumber() cannot overflow afterwards
+    size_t n_values = 0 ;
+    if(not get_value_number(layout, size, nb_bins, n_values))
+    {   throw std::invalid_argument("KineticTable error! "
+                                    "size and number of "
+                                    "bins are too large") ;
+    }
+    m_layout    = layout ;
+    m_size      = size ;
+    m_nb_bins   = nb_bins ;
+    m_xmin      = xmin ;
+    m_xmax      = xmax ;
+    m_bin_scale = static_cast<double>(nb_bins) /
+                  (xmax - xmin) ;
+    m_kmermap   = kmermap ;
+
+    // positions of the factor axes
+    m_pos_a.clear() ;
+    m_pos_b.clear() ;
+    if(m_layout == layouts::raw)
+    {   for(size_t i=0; i<m_size; i++)
+        {   m_pos_a.push_back(i) ;
+            m_pos_b.push_back(i) ;
+        }
+    }
+    else if(m_layout == layouts::diposition)
+    {   for(size_t i=0; i<m_size-1; i++)
+        {   m_pos_a.push_back(i) ;
+            m_pos_b.push_back(i+1) ;
+        }
+    }
+    else
+    {   for(size_t i=0; i<m_size; i++)
+        {   for(size_t j=i+1; j<m_size; j++)
+            {   m_pos_a.push_back(i) ;
+                m_pos_b.push_back(j) ;
+            }
+        }
+    }
+}
+
+
+ngsai::app::KineticTable::~KineticTable()
+{ ; }
+
+
+ngsai::app::KineticTable::layouts
+ngsai::app::KineticTable::getLayout() const
+{   return m_layout ; }
+
+
+ngsai::app::KineticTable::contents
+ngsai::app::KineticTable::getContents() const
+{   return m_contents ; }
+
+
+void
+ngsai::app::KineticTable::setContents(contents contents)
+{   m_contents = contents ; }
+
+
+size_t
+ngsai::app::KineticTable::size() const
+{   return m_size ; }
+
+
+size_t
+ngsai::app::KineticTable::getBinNumber() const
+{   return m_nb_bins ; }
+
+
+double
+ngsai::app::KineticTable::getXmin() const
+{   return m_xmin ; }
+
+
+double
+ngsai::app::KineticTable::getXmax() const
+{   return m_xmax ; }
+
+
+size_t
+ngsai::app::KineticTable::getFactorNumber() const
+{   return m_pos_a.size() ; }
+
+
+size_t
+ngsai::app::KineticTable::getFactorLength() const
+{   if(m_layout == layouts::raw)
+    {   return m_nb_bins ; }
+    return m_nb_bins * m_nb_bins ;
+}
+
+
+const std::vector<uint32_t>&
+ngsai::app::KineticTable::getPositionsA() const
+{   return m_pos_a ; }
+
+
+const std::vector<uint32_t>&
+ngsai::app::KineticTable::getPositionsB() const
+{   return m_pos_b ; }
+
+
+bool
+ngsai::app::KineticTable::isNormalized() const
+{   return m_kmermap != nullptr ; }
+
+
+const std::shared_ptr<const ngsai::KmerMap>&
+ngsai::app::KineticTable::getKmerMap() const
+{   return m_kmermap ; }
+
+
+bool
+ngsai::app::KineticTable::isCompatible(
+                        const KineticTable& other) const
+{   if((m_layout  != other.m_layout)  or
+       (m_size    != other.m_size)    or
+       (m_nb_bins != other.m_nb_bins) or
+       (m_xmin    != other.m_xmin)    or
+       (m_xmax    != other.m_xmax)    or
+       (this->isNormalized() != other.isNormalized()))
+    {   return false ; }
+    // the signal must be normalized the same way
+    if(this->isNormalized() and
+       (m_kmermap != other.m_kmermap))
+    {   return are_equal(*m_kmermap, *(other.m_kmermap)) ; }
+    return true ;
+}
+
+
+void
+ngsai::app::KineticTable::save(const std::string& path) const
+{   std::string kmermap = serialize_kmermap(*this) ;
+    KineticTableHeader header = make_header(*this,
+                                            kmermap.size()) ;
+
+    std::ofstream file(path, std::ios::binary) ;
+    file.write(reinterpret_cast<const char*>(&header),
+               sizeof(header)) ;
+    file.write(reinterpret_cast<const char*>(this->data()),
+               this->getValueNumber() * sizeof(double)) ;
+    file.write(kmermap.data(), kmermap.size()) ;
+    file.close() ;
+    if(not file)
+    {   throw std::runtime_error("KineticTable error! "
+                                 "could not write " +
+                                 path) ;
+    }
+}
+
+
+bool
+ngsai::app::KineticTable::isMapped() const
+{   return m_mapped != nullptr ; }
+
+
+size_t
+ngsai::app::KineticTable::getValueNumber() const
+{   return 2 * m_pos_a.size() * this->getFactorLength() ; }
+
+
+const double*
+ngsai::app::KineticTable::data() const
+{   if(m_mapped != nullptr)
+    {   return m_mapped ; }
+    return m_values.data() ;
+}
+
+
+double*
+ngsai::app::KineticTable::data()
+{   // the mapping is read-only
+    if(m_mapped != nullptr)
+    {   m_values.assign(m_mapped,
+                        m_mapped + this->getValueNumber()) ;
+        m_mapped = nullptr ;
+        m_file.reset() ;
+    }
+    return m_values.data() ;
+}
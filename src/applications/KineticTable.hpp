@@ -0,0 +1,592 @@
+#ifndef NGSAI_APP_KINETICTABLE_HPP
+#define NGSAI_APP_KINETICTABLE_HPP
+
+#include <string>
+#include <vector>
+#include <memory>           // std::shared_ptr
+#include <functional>       // std::function
+#include <cstdint>
+
+#include <ngsaipp/epigenetics/KineticModel.hpp>  // ngsai::KineticModel
+#include <ngsaipp/epigenetics/KmerMap.hpp>       // ngsai::KmerMap
+#include <applications/MappedFile.hpp>           // ngsai::app::MappedFile
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief The KineticTable class stores the
+        * histograms of a kinetic signal model in a single
+        * contiguous bin-indexed table of log densities.
+        * A model is made of factors, each factor being a
+        * histogram over the signal at one position (raw
+        * models) or over the joint signal at two
+        * positions (diposition and pairwise models). The
+        * table contains all the IPD factors followed by
+        * all the PWD factors. The values of a factor are
+        * stored contiguously, row-major for 2D factors.
+        * The log likelihood of a window is then computed
+        * by binning each position once and summing one
+        * table value per factor.
+        * Values outside [xmin,xmax) are assigned to the
+        * lowest or highest bin.
+        * Tables can be saved in a binary format that is
+        * loaded by mapping the file in memory, without
+        * parsing nor copying the values. The format is
+        * a 64 bytes header, the values as native doubles
+        * and the KmerMap, if any, as a boost text archive.
+        * Writing in a mapped table first copies its
+        * values in memory.
+        * A table may also hold the counts of the
+        * histograms instead of their log densities, for
+        * instance to sum partial models. Such tables
+        * cannot be used to compute likelihoods.
+        */
+        class KineticTable
+        {
+            public:
+                /*!
+                * \brief The possible model layouts.
+                */
+                enum class layouts {raw,
+                                    diposition,
+                                    pairwise} ;
+
+                /*!
+                * \brief What the values of a table are.
+                */
+                enum class contents {log_densities,
+                                     counts} ;
+
+            public:
+                /*!
+                * \brief Compiles a kinetic model into a
+                * table. The model must contain log
+                * densities.
+                * \param model the model to compile.
+                * \return the table.
+                * \throw std::invalid_argument if the
+                * model is not initialised, does not
+                * contain log densities or is of an
+                * unknown type.
+                */
+                static
+                KineticTable
+                fromModel(const ngsai::KineticModel& model) ;
+
+                /*!
+                * \brief Creates a table containing the
+                * difference between the values of two
+                * tables, for instance the log likelihood
+                * ratio of a methylated and an unmethylated
+                * model.
+                * \param table_a the first table.
+                * \param table_b the table to subtract.
+                * A bin empty in both tables, -inf in
+                * both, has a difference of 0, the bin
+                * gives no evidence for either model.
+                * \return the table of differences, with
+                * the layout, binning and KmerMap of the
+                * first table.
+                * \throw std::invalid_argument if the
+                * tables are not compatible.
+                */
+                static
+                KineticTable
+                difference(const KineticTable& table_a,
+                           const KineticTable& table_b) ;
+
+                /*!
+                * \brief Loads a table saved in binary
+                * format by mapping the file in memory.
+                * \param path the path to the file.
+                * \return the table.
+                * \throw std::runtime_error if the file
+                * cannot be read or is not a valid table
+                * file.
+                */
+                static
+                KineticTable
+                load(const std::string& path) ;
+
+                /*!
+                * \brief Sums tables of counts saved in
+                * binary format and saves the sum in binary
+                * format. The tables are mapped in memory
+                * and summed by chunks of whole factors,
+                * each chunk being written before the next
+                * one is summed, such that neither the
+                * tables nor their sum are ever held in
+                * memory as a whole.
+                * \param paths the paths to the files of
+                * the tables to sum.
+                * \param path_out the path to the file to
+                * write.
+                * \param contents_out what to write, the
+                * summed counts or their log densities.
+                * \param pseudo_counts a number of counts
+                * added once to each bin of the sum.
+                * \param chunk_size the number of values
+                * summed at once, rounded up to a whole
+                * number of factors.
+                * \throw std::invalid_argument if no
+                * table is given, if a table does not
+                * contain counts or if the tables are not
+                * compatible.
+                * \throw std::runtime_error if a file
+                * cannot be read or written.
+                */
+                static
+                void
+                sum(const std::vector<std::string>& paths,
+                    const std::string& path_out,
+                    contents contents_out,
+                    double pseudo_counts,
+                    size_t chunk_size) ;
+
+                /*!
+                * \brief Writes a table of counts, or of 
+                * their log densities, in binary format 
+                * by chunks of whole factors, each chunk 
+                * being written before the next one is 
+                * filled, such that the table is never 
+                * held in memory as a whole.
+                * \param layout a table giving the layout, 
+                * binning and KmerMap of the table to 
+                * write, its values are not used.
+                * \param path_out the path to the file to
+                * write.
+                * \param contents_out what to write, the
+                * counts or their log densities.
+                * \param pseudo_counts a number of counts
+                * added to each bin.
+                * \param chunk_size the number of values
+                * written at once, rounded up to a whole
+                * number of factors.
+                * \param add_counts a function called as 
+                * add_counts(from, n, chunk) that adds the 
+                * counts of the values [from, from+n) to 
+                * the chunk.
+                * \throw std::runtime_error if the file
+                * cannot be written.
+                */
+                static
+                void
+                writeCounts(const KineticTable& layout,
+                            const std::string& path_out,
+                            contents contents_out,
+                            double pseudo_counts,
+                            size_t chunk_size,
+                            const std::function<void(size_t,
+                                                     size_t,
+                                                     double*)>&
+                                                    add_counts) ;
+
+                /*!
+                * \brief Creates a table with the given 
+                * layout without allocating its values, 
+                * for instance to describe counts stored 
+                * elsewhere. Its values must not be 
+                * accessed.
+                * \param layout the model layout.
+                * \param size the window size in bp.
+                * \param nb_bins the number of bins of each
+                * histogram axis.
+                * \param xmin the lower limit of the lower
+                * bin.
+                * \param xmax the upper limit of the upper
+                * bin.
+                * \param kmermap the KmerMap used to
+                * normalize the signal, nullptr for models
+                * of raw signal.
+                * \return the table.
+                * \throw std::invalid_argument if the
+                * parameters are inconsistent.
+                */
+                static
+                KineticTable
+                makeLayout(layouts layout,
+                           size_t size,
+                           size_t nb_bins,
+                           double xmin,
+                           double xmax,
+                           std::shared_ptr<const ngsai::KmerMap>
+                                                    kmermap) ;
+
+                /*!
+                * \brief The extension of the files
+                * containing tables in binary format.
+                */
+                static const std::string extension ;
+
+                /*!
+                * \brief The version of the binary format
+                * written by save().
+                */
+                static const uint32_t version ;
+
+            public:
+                /*!
+                * \brief Constructor. Creates an empty
+                * table.
+                */
+                KineticTable() ;
+
+                /*!
+                * \brief Constructor. Creates a table
+                * with the given layout in which all values
+                * are 0.
+                * \param layout the model layout.
+                * \param size the window size in bp.
+                * \param nb_bins the number of bins of each
+                * histogram axis.
+                * \param xmin the lower limit of the lower
+                * bin.
+                * \param xmax the upper limit of the upper
+                * bin.
+                * \param kmermap the KmerMap used to
+                * normalize the signal, nullptr for models
+                * of raw signal.
+                * \throw std::invalid_argument if the
+                * parameters are inconsistent.
+                */
+                KineticTable(layouts layout,
+                             size_t size,
+                             size_t nb_bins,
+                             double xmin,
+                             double xmax,
+                             std::shared_ptr<const ngsai::KmerMap>
+                                                        kmermap) ;
+
+                /*!
+                * \brief Destructor.
+                */
+                virtual
+                ~KineticTable() ;
+
+                /*!
+                * \brief Returns the model layout.
+                * \return the layout.
+                */
+                layouts
+                getLayout() const ;
+
+                /*!
+                * \brief Returns what the values are, log
+                * densities unless set otherwise.
+                * \return the contents.
+                */
+                contents
+                getContents() const ;
+
+                /*!
+                * \brief Sets what the values are.
+                * \param contents the contents.
+                */
+                void
+                setContents(contents contents) ;
+
+                /*!
+                * \brief Returns the window size.
+                * \return the window size in bp.
+                */
+                size_t
+                size() const ;
+
+                /*!
+                * \brief Returns the number of bins of each
+                * histogram axis.
+                * \return the number of bins.
+                */
+                size_t
+                getBinNumber() const ;
+
+                /*!
+                * \brief Returns the lower limit of the
+                * lower bin.
+                * \return the lower limit.
+                */
+                double
+                getXmin() const ;
+
+                /*!
+                * \brief Returns the upper limit of the
+                * upper bin.
+                * \return the upper limit.
+                */
+                double
+                getXmax() const ;
+
+                /*!
+                * \brief Returns the number of factors per
+                * signal.
+                * \return the number of factors.
+                */
+                size_t
+                getFactorNumber() const ;
+
+                /*!
+                * \brief Returns the number of values of
+                * each factor, the number of bins for 1D
+                * factors and its square for 2D factors.
+                * \return the factor length.
+                */
+                size_t
+                getFactorLength() const ;
+
+                /*!
+                * \brief Returns the positions in the
+                * window of the first axis of each factor.
+                * \return the positions.
+                */
+                const std::vector<uint32_t>&
+                getPositionsA() const ;
+
+                /*!
+                * \brief Returns the positions in the
+                * window of the second axis of each factor.
+                * For 1D factors, they are the same as the
+                * first axis positions.
+                * \return the positions.
+                */
+                const std::vector<uint32_t>&
+                getPositionsB() const ;
+
+                /*!
+                * \brief Indicates whether the model is a
+                * model of normalized signal.
+                * \return whether the signal is normalized.
+                */
+                bool
+                isNormalized() const ;
+
+                /*!
+                * \brief Returns the KmerMap used to
+                * normalize the signal.
+                * \return the KmerMap, nullptr if the
+                * signal is not normalized.
+                */
+                const std::shared_ptr<const ngsai::KmerMap>&
+                getKmerMap() const ;
+
+                /*!
+                * \brief Checks whether another table has
+                * the same layout, window size, binning and
+                * signal normalization.
+                * \param other the other table.
+                * \return whether the tables are
+                * compatible.
+                */
+                bool
+                isCompatible(const KineticTable& other) const ;
+
+                /*!
+                * \brief Saves the table in binary format.
+                * \param path the path to the file.
+                * \throw std::runtime_error if the file
+                * cannot be written.
+                */
+                void
+                save(const std::string& path) const ;
+
+                /*!
+                * \brief Indicates whether the values are
+                * read from a file mapped in memory.
+                * \return whether the table is mapped.
+                */
+                bool
+                isMapped() const ;
+
+                /*!
+                * \brief Returns the total number of values
+                * in the table.
+                * \return the number of values.
+                */
+                size_t
+                getValueNumber() const ;
+
+                /*!
+                * \brief Returns a pointer to the table
+                * values.
+                * \return a pointer to the values.
+                */
+                const double*
+                data() const ;
+
+                /*!
+                * \brief Returns a pointer to the table
+                * values. If the table is mapped, the
+                * values are copied in memory first.
+                * \return a pointer to the values.
+                */
+                double*
+                data() ;
+
+                /*!
+                * \brief Returns the bin in which a value
+                * falls.
+                * \param x the value.
+                * \return the bin index.
+                */
+                size_t
+                getBin(double x) const
+                {   double b = (x - m_xmin) * m_bin_scale ;
+                    if(not (b > 0.))
+                    {   return 0 ; }
+                    size_t i = static_cast<size_t>(b) ;
+                    return (i < m_nb_bins) ? i : m_nb_bins - 1 ;
+                }
+
+                /*!
+                * \brief Computes the log likelihood of
+                * a window of signal.
+                * \param ipd the IPD signal of the window,
+                * it must contain size() values.
+                * \param pwd the PWD signal of the window,
+                * it must contain size() values.
+                * \return the sum of the table values of
+                * each factor.
+                */
+                template<class T>
+                double
+                logLikelihood(const T* ipd,
+                              const T* pwd) const ;
+
+            protected:
+                /*!
+                * \brief Sets the table parameters and
+                * computes the positions of each factor.
+                * No value is allocated.
+                * \param layout the model layout.
+                * \param size the window size in bp.
+                * \param nb_bins the number of bins of each
+                * histogram axis.
+                * \param xmin the lower limit of the lower
+                * bin.
+                * \param xmax the upper limit of the upper
+                * bin.
+                * \param kmermap the KmerMap used to
+                * normalize the signal, nullptr for models
+                * of raw signal.
+                * \throw std::invalid_argument if the
+                * parameters are inconsistent.
+                */
+                void
+                init(layouts layout,
+                     size_t size,
+                     size_t nb_bins,
+                     double xmin,
+                     double xmax,
+                     std::shared_ptr<const ngsai::KmerMap>
+                                                kmermap) ;
+
+            protected:
+                /*!
+                * \brief the model layout.
+                */
+                layouts m_layout ;
+                /*!
+                * \brief what the values are.
+                */
+                contents m_contents ;
+                /*!
+                * \brief the window size in bp.
+                */
+                size_t m_size ;
+                /*!
+                * \brief the number of bins per axis.
+                */
+                size_t m_nb_bins ;
+                /*!
+                * \brief the lower limit of the lower bin.
+                */
+                double m_xmin ;
+                /*!
+                * \brief the upper limit of the upper bin.
+                */
+                double m_xmax ;
+                /*!
+                * \brief the number of bins per unit of
+                * signal.
+                */
+                double m_bin_scale ;
+                /*!
+                * \brief the KmerMap to normalize the
+                * signal, if any.
+                */
+                std::shared_ptr<const ngsai::KmerMap> m_kmermap ;
+                /*!
+                * \brief the position of the first axis of
+                * each factor.
+                */
+                std::vector<uint32_t> m_pos_a ;
+                /*!
+                * \brief the position of the second axis
+                * of each factor.
+                */
+                std::vector<uint32_t> m_pos_b ;
+                /*!
+                * \brief the IPD factors values followed by
+                * the PWD factors values, if the table is
+                * not mapped.
+                */
+                std::vector<double> m_values ;
+                /*!
+                * \brief the mapped file containing the
+                * values, if any.
+                */
+                std::shared_ptr<const MappedFile> m_file ;
+                /*!
+                * \brief the address of the values in the
+                * mapped file, nullptr if the table is not
+                * mapped.
+                */
+                const double* m_mapped ;
+        } ;
+
+    }  // namespace app
+
+}  // namespace ngsai
+
+
+template<class T>
+double
+ngsai::app::KineticTable::logLikelihood(const T* ipd,
+                                        const T* pwd) const
+{   // bin of each position, IPD then PWD
+    uint32_t bins_stack[128] ;
+    std::vector<uint32_t> bins_heap ;
+    uint32_t* bins = bins_stack ;
+    if(2*m_size > 128)
+    {   bins_heap.resize(2*m_size) ;
+        bins = bins_heap.data() ;
+    }
+    for(size_t i=0; i<m_size; i++)
+    {   bins[i]          = this->getBin(ipd[i]) ;
+        bins[m_size + i] = this->getBin(pwd[i]) ;
+    }
+
+    size_t n_factors = m_pos_a.size() ;
+    size_t length    = this->getFactorLength() ;
+    double ll = 0. ;
+    for(size_t s=0; s<2; s++)
+    {   const uint32_t* b = bins + s*m_size ;
+        const double* v   = this->data() +
+                            s*n_factors*length ;
+        if(m_layout == layouts::raw)
+        {   for(size_t f=0; f<n_factors; f++, v+=length)
+            {   ll += v[b[f]] ; }
+        }
+        else
+        {   for(size_t f=0; f<n_factors; f++, v+=length)
+            {   ll += v[b[m_pos_a[f]]*m_nb_bins +
+                        b[m_pos_b[f]]] ;
+            }
+        }
+    }
+    return ll ;
+}
+
+#endif  // NGSAI_APP_KINETICTABLE_HPP
@@ -0,0 +1,508 @@
+#include <applications/KineticTableClassifier.hpp>
+
+#include <cmath>            // std::log(), std::exp()
+#include <vector>
+#include <array>
+#include <stdexcept>        // std::invalid_argument
+#include <algorithm>        // std::max(), std::copy()
+
+#include <ngsaipp/genome/constants.hpp>             // ngsai::genome::strand
+#include <ngsaipp/epigenetics/model_utility.hpp>    // ngsai::normalize_kinetics()
+#include <applications/Profiler.hpp>                // ngsai::app::Profiler
+
+
+ngsai::app::KineticTableClassifier::KineticTableClassifier()
+    : m_table_meth(),
+      m_table_unmeth(),
+      m_table_llr(),
+      m_fused(false),
+      m_kernel()
+{ ; }
+
+
+ngsai::app::KineticTableClassifier::~KineticTableClassifier()
+{ ; }
+
+
+void
+ngsai::app::KineticTableClassifier::setTables(
+                            KineticTable&& table_meth,
+                            KineticTable&& table_unmeth)
+{   if(table_meth.size() != table_unmeth.size())
+    {   throw std::invalid_argument("KineticTableClassifier "
+                                    "error! models must have "
+                                    "the same size") ;
+    }
+    else if((table_meth.getContents() != 
+                KineticTable::contents::log_densities) or
+            (table_unmeth.getContents() != 
+                KineticTable::contents::log_densities))
+    {   throw std::invalid_argument("KineticTableClassifier "
+                                    "error! models must contain "
+                                    "log densities") ;
+    }
+    m_table_meth   = std::move(table_meth) ;
+    m_table_unmeth = std::move(table_unmeth) ;
+    m_table_llr    = KineticTable() ;
+    m_fused        = false ;
+}
+
+
+void
+ngsai::app::KineticTableClassifier::fuse()
+{   m_table_llr = KineticTable::difference(m_table_meth,
+                                           m_table_unmeth) ;
+    m_fused     = true ;
+}
+
+
+bool
+ngsai::app::KineticTableClassifier::isFused() const
+{   return m_fused ; }
+
+
+const ngsai::app::KineticKernel&
+ngsai::app::KineticTableClassifier::getKernel() const
+{   return m_kernel ; }
+
+
+const ngsai::app::KineticTable&
+ngsai::app::KineticTableClassifier::getTableMeth() const
+{   return m_table_meth ; }
+
+
+const ngsai::app::KineticTable&
+ngsai::app::KineticTableClassifier::getTableUnmeth() const
+{   return m_table_unmeth ; }
+
+
+std::pair<double,double>
+ngsai::app::KineticTableClassifier::classify(
+                const ngsai::genome::CpGRegion& cpg,
+                const std::list<PacBio::BAM::BamRecord>& ccss,
+                double prob_meth,
+                double prob_unmeth) const
+{   // raw signal windows can be scored as a batch
+    if(not m_table_meth.isNormalized())
+    {   return this->classifyBatch(cpg,
+                                   ccss,
+                                   prob_meth,
+                                   prob_unmeth) ;
+    }
+
+    ngsai::CcsKineticExtractor extractor ;
+    double ll_meth   = 0. ;
+    double ll_unmeth = 0. ;
+    size_t n_windows = 0 ;
+
+    // the unmethylated log likelihood is folded into
+    // the ratio
+    if(m_fused)
+    {   for(const auto& ccs : ccss)
+        {   n_windows += this->logLikelihoodRatio(cpg,
+                                                  ccs,
+                                                  extractor,
+                                                  ll_meth) ;
+        }
+    }
+    else
+    {   for(const auto& ccs : ccss)
+        {   n_windows += this->logLikelihood(cpg,
+                                             ccs,
+                                             extractor,
+                                             ll_meth,
+                                             ll_unmeth) ;
+        }
+    }
+
+    if(n_windows == 0)
+    {   return std::make_pair(prob_meth, prob_unmeth) ; }
+
+    return posterior(ll_meth,
+                     ll_unmeth,
+                     prob_meth,
+                     prob_unmeth) ;
+}
+
+
+void
+ngsai::app::KineticTableClassifier::extract(
+                const ngsai::genome::CpGRegion& cpg,
+                const PacBio::BAM::BamRecord& ccs,
+                WindowArena& arena) const
+{   size_t slot ;
+    if(not arena.addCcs(slot))
+    {   return ; }
+
+    ngsai::CcsKineticExtractor& extractor = arena.getExtractor() ;
+    size_t size = arena.getWindowSize() ;
+    size_t n_windows = 0 ;
+    std::array<ngsai::BedRecord,2> windows ;
+    size_t n_cpg_windows = getWindows(cpg, size, windows) ;
+    for(size_t i=0; i<n_cpg_windows; i++)
+    {   if(not this->extractWindow(ccs, windows[i], extractor))
+        {   continue ; }
+        // normalization needs the sequence, score now
+        if(m_table_meth.isNormalized())
+        {   if(m_fused)
+            {   arena.getScoreMeth(slot, n_windows) =
+                    logLikelihood(m_table_llr, extractor) ;
+            }
+            else
+            {   arena.getScoreMeth(slot, n_windows) =
+                    logLikelihood(m_table_meth, extractor) ;
+                arena.getScoreUnmeth(slot, n_windows) =
+                    logLikelihood(m_table_unmeth, extractor) ;
+            }
+        }
+        else
+        {   const std::vector<uint16_t>& ipd = extractor.getIPD() ;
+            const std::vector<uint16_t>& pwd = extractor.getPWD() ;
+            std::copy(ipd.begin(),
+                      ipd.begin() + size,
+                      arena.getIPD(slot, n_windows)) ;
+            std::copy(pwd.begin(),
+                      pwd.begin() + size,
+                      arena.getPWD(slot, n_windows)) ;
+        }
+        n_windows++ ;
+    }
+    arena.setWindowNumber(slot, n_windows) ;
+    ngsai::app::Profiler::getInstance().count(
+                ngsai::app::Profiler::counters::windows_extracted,
+                n_windows) ;
+}
+
+
+void
+ngsai::app::KineticTableClassifier::score(WindowArena& arena,
+                                          size_t first,
+                                          size_t last) const
+{   if(m_table_meth.isNormalized())
+    {   return ; }
+
+    const std::vector<size_t>& order = arena.getOrder() ;
+    size_t size = arena.getWindowSize() ;
+    size_t n_windows = 0 ;
+    for(size_t k=first; k<last; k++)
+    {   n_windows += arena.getWindowNumber(order[k]) ; }
+    if(n_windows == 0)
+    {   return ; }
+
+    // position major, in CCS order
+    std::vector<uint16_t>& ipd    = arena.getBatchIPD() ;
+    std::vector<uint16_t>& pwd    = arena.getBatchPWD() ;
+    std::vector<double>&   scores = arena.getBatchScores() ;
+    if(ipd.size() < size * n_windows)
+    {   ipd.resize(size * n_windows) ;
+        pwd.resize(size * n_windows) ;
+    }
+    if(scores.size() < n_windows)
+    {   scores.resize(n_windows) ; }
+    size_t w = 0 ;
+    for(size_t k=first; k<last; k++)
+    {   size_t slot = order[k] ;
+        for(size_t i=0; i<arena.getWindowNumber(slot); i++, w++)
+        {   const uint16_t* w_ipd = arena.getIPD(slot, i) ;
+            const uint16_t* w_pwd = arena.getPWD(slot, i) ;
+            for(size_t p=0; p<size; p++)
+            {   ipd[p*n_windows + w] = w_ipd[p] ;
+                pwd[p*n_windows + w] = w_pwd[p] ;
+            }
+        }
+    }
+
+    const KineticTable& table_1 = m_fused ? m_table_llr :
+                                            m_table_meth ;
+    m_kernel.score(table_1,
+                   ipd.data(),
+                   pwd.data(),
+                   n_windows,
+                   scores.data(),
+                   arena.getBatchBins()) ;
+    w = 0 ;
+    for(size_t k=first; k<last; k++)
+    {   size_t slot = order[k] ;
+        for(size_t i=0; i<arena.getWindowNumber(slot); i++, w++)
+        {   arena.getScoreMeth(slot, i) = scores[w] ; }
+    }
+    if(m_fused)
+    {   return ; }
+
+    m_kernel.score(m_table_unmeth,
+                   ipd.data(),
+                   pwd.data(),
+                   n_windows,
+                   scores.data(),
+                   arena.getBatchBins()) ;
+    w = 0 ;
+    for(size_t k=first; k<last; k++)
+    {   size_t slot = order[k] ;
+        for(size_t i=0; i<arena.getWindowNumber(slot); i++, w++)
+        {   arena.getScoreUnmeth(slot, i) = scores[w] ; }
+    }
+}
+
+
+std::pair<double,double>
+ngsai::app::KineticTableClassifier::classify(
+                WindowArena& arena,
+                size_t first,
+                size_t last,
+                double prob_meth,
+                double prob_unmeth) const
+{   // windows are summed in extraction order, as in
+    // classify()
+    const std::vector<size_t>& order = arena.getOrder() ;
+    double ll_meth   = 0. ;
+    double ll_unmeth = 0. ;
+    size_t n_windows = 0 ;
+    for(size_t i=first; i<last; i++)
+    {   size_t slot = order[i] ;
+        for(size_t w=0; w<arena.getWindowNumber(slot); w++)
+        {   ll_meth += arena.getScoreMeth(slot, w) ;
+            if(not m_fused)
+            {   ll_unmeth += arena.getScoreUnmeth(slot, w) ; }
+            n_windows++ ;
+        }
+    }
+
+    if(n_windows == 0)
+    {   return std::make_pair(prob_meth, prob_unmeth) ; }
+
+    return posterior(ll_meth,
+                     ll_unmeth,
+                     prob_meth,
+                     prob_unmeth) ;
+}
+
+
+size_t
+ngsai::app::KineticTableClassifier::logLikelihood(
+                const ngsai::genome::CpGRegion& cpg,
+                const PacBio::BAM::BamRecord& ccs,
+                ngsai::CcsKineticExtractor& extractor,
+                double& ll_meth,
+                double& ll_unmeth) const
+{   std::array<ngsai::BedRecord,2> windows ;
+    size_t n_cpg_windows = getWindows(cpg,
+                                      m_table_meth.size(),
+                                      windows) ;
+    size_t n_windows = 0 ;
+    for(size_t i=0; i<n_cpg_windows; i++)
+    {   if(this->extractWindow(ccs, windows[i], extractor))
+        {   ll_meth   += logLikelihood(m_table_meth,
+                                       extractor) ;
+            ll_unmeth += logLikelihood(m_table_unmeth,
+                                       extractor) ;
+            n_windows++ ;
+        }
+    }
+    ngsai::app::Profiler::getInstance().count(
+                ngsai::app::Profiler::counters::windows_extracted,
+                n_windows) ;
+    return n_windows ;
+}
+
+
+size_t
+ngsai::app::KineticTableClassifier::logLikelihoodRatio(
+                const ngsai::genome::CpGRegion& cpg,
+                const PacBio::BAM::BamRecord& ccs,
+                ngsai::CcsKineticExtractor& extractor,
+                double& llr) const
+{   std::array<ngsai::BedRecord,2> windows ;
+    size_t n_cpg_windows = getWindows(cpg,
+                                      m_table_meth.size(),
+                                      windows) ;
+    size_t n_windows = 0 ;
+    for(size_t i=0; i<n_cpg_windows; i++)
+    {   if(this->extractWindow(ccs, windows[i], extractor))
+        {   llr += logLikelihood(m_table_llr, extractor) ;
+            n_windows++ ;
+        }
+    }
+    ngsai::app::Profiler::getInstance().count(
+                ngsai::app::Profiler::counters::windows_extracted,
+                n_windows) ;
+    return n_windows ;
+}
+
+
+std::pair<double,double>
+ngsai::app::KineticTableClassifier::posterior(
+                                    double ll_meth,
+                                    double ll_unmeth,
+                                    double prob_meth,
+                                    double prob_unmeth)
+{   // log joint probabilities, normalized in log space
+    double lj_meth   = std::log(prob_meth)   + ll_meth ;
+    double lj_unmeth = std::log(prob_unmeth) + ll_unmeth ;
+    double lj_max    = std::max(lj_meth, lj_unmeth) ;
+    double p_meth    = std::exp(lj_meth   - lj_max) ;
+    double p_unmeth  = std::exp(lj_unmeth - lj_max) ;
+    double sum       = p_meth + p_unmeth ;
+    return std::make_pair(p_meth / sum, p_unmeth / sum) ;
+}
+
+
+std::pair<double,double>
+ngsai::app::KineticTableClassifier::classifyBatch(
+                const ngsai::genome::CpGRegion& cpg,
+                const std::list<PacBio::BAM::BamRecord>& ccss,
+                double prob_meth,
+                double prob_unmeth) const
+{   std::vector<uint16_t> ipd ;
+    std::vector<uint16_t> pwd ;
+    size_t n_windows = this->extractWindows(cpg,
+                                            ccss,
+                                            ipd,
+                                            pwd) ;
+    if(n_windows == 0)
+    {   return std::make_pair(prob_meth, prob_unmeth) ; }
+
+    // windows are summed in extraction order, as in
+    // classify()
+    std::vector<double> scores(n_windows) ;
+    double ll_meth   = 0. ;
+    double ll_unmeth = 0. ;
+    if(m_fused)
+    {   m_kernel.score(m_table_llr,
+                       ipd.data(),
+                       pwd.data(),
+                       n_windows,
+                       scores.data()) ;
+        for(double score : scores)
+        {   ll_meth += score ; }
+    }
+    else
+    {   m_kernel.score(m_table_meth,
+                       ipd.data(),
+                       pwd.data(),
+                       n_windows,
+                       scores.data()) ;
+        for(double score : scores)
+        {   ll_meth += score ; }
+        m_kernel.score(m_table_unmeth,
+                       ipd.data(),
+                       pwd.data(),
+                       n_windows,
+                       scores.data()) ;
+        for(double score : scores)
+        {   ll_unmeth += score ; }
+    }
+
+    return posterior(ll_meth,
+                     ll_unmeth,
+                     prob_meth,
+                     prob_unmeth) ;
+}
+
+
+bool
+ngsai::app::KineticTableClassifier::extractWindow(
+                const PacBio::BAM::BamRecord& ccs,
+                const ngsai::BedRecord& window,
+                ngsai::CcsKineticExtractor& extractor) const
+{   size_t size = m_table_meth.size() ;
+    return extractor.extract(ccs, window) and
+           (extractor.getIPD().size() == size) and
+           (extractor.getPWD().size() == size) ;
+}
+
+
+size_t
+ngsai::app::KineticTableClassifier::extractWindows(
+                const ngsai::genome::CpGRegion& cpg,
+                const std::list<PacBio::BAM::BamRecord>& ccss,
+                std::vector<uint16_t>& ipd,
+                std::vector<uint16_t>& pwd) const
+{   // windows one after the other
+    ngsai::CcsKineticExtractor extractor ;
+    std::vector<uint16_t> ipd_windows ;
+    std::vector<uint16_t> pwd_windows ;
+    std::array<ngsai::BedRecord,2> windows ;
+    size_t n_cpg_windows = getWindows(cpg,
+                                      m_table_meth.size(),
+                                      windows) ;
+    for(const auto& ccs : ccss)
+    {   for(size_t i=0; i<n_cpg_windows; i++)
+        {   if(this->extractWindow(ccs, windows[i], extractor))
+            {   const std::vector<uint16_t>& w_ipd = extractor.getIPD() ;
+                const std::vector<uint16_t>& w_pwd = extractor.getPWD() ;
+                ipd_windows.insert(ipd_windows.end(),
+                                   w_ipd.begin(),
+                                   w_ipd.end()) ;
+                pwd_windows.insert(pwd_windows.end(),
+                                   w_pwd.begin(),
+                                   w_pwd.end()) ;
+            }
+        }
+    }
+
+    // position major
+    size_t size      = m_table_meth.size() ;
+    size_t n_windows = ipd_windows.size() / size ;
+    ngsai::app::Profiler::getInstance().count(
+                ngsai::app::Profiler::counters::windows_extracted,
+                n_windows) ;
+    ipd.resize(ipd_windows.size()) ;
+    pwd.resize(pwd_windows.size()) ;
+    for(size_t w=0; w<n_windows; w++)
+    {   for(size_t p=0; p<size; p++)
+        {   ipd[p*n_windows + w] = ipd_windows[w*size + p] ;
+            pwd[p*n_windows + w] = pwd_windows[w*size + p] ;
+        }
+    }
+    return n_windows ;
+}
+
+
+size_t
+ngsai::app::KineticTableClassifier::getWindows(
+                const ngsai::BedRecord& cpg,
+                size_t size,
+                std::array<ngsai::BedRecord,2>& windows)
+{
+    // windows centered on the C of the CpG on each strand
+    //      start  end
+    //        |     |
+    //  ... N C p G N ... forward strand
+    //  ... N G p C N ... reverse strand
+    size_t win_size_half = size / 2 ;
+    size_t n_windows = 0 ;
+    if(cpg.start >= win_size_half)
+    {   ngsai::BedRecord& window_fw = windows[n_windows++] ;
+        window_fw        = cpg ;
+        window_fw.strand = ngsai::genome::strand::FORWARD ;
+        window_fw.start  = cpg.start - win_size_half ;
+        window_fw.end    = cpg.end + win_size_half - 1 ;
+    }
+    if(cpg.start + 1 >= win_size_half)
+    {   ngsai::BedRecord& window_rv = windows[n_windows++] ;
+        window_rv        = cpg ;
+        window_rv.strand = ngsai::genome::strand::REVERSE ;
+        window_rv.start  = cpg.start + 1 - win_size_half ;
+        window_rv.end    = cpg.end + win_size_half ;
+    }
+    return n_windows ;
+}
+
+
+double
+ngsai::app::KineticTableClassifier::logLikelihood(
+                const KineticTable& table,
+                const ngsai::CcsKineticExtractor& extractor)
+{   const std::vector<uint16_t>& ipd = extractor.getIPD() ;
+    const std::vector<uint16_t>& pwd = extractor.getPWD() ;
+    if(table.isNormalized())
+    {   auto ratios =
+            ngsai::normalize_kinetics(extractor.getSequence(),
+                                      ipd,
+                                      pwd,
+                                      *(table.getKmerMap())) ;
+        return table.logLikelihood(ratios.first.data(),
+                                   ratios.second.data()) ;
+    }
+    return table.logLikelihood(ipd.data(), pwd.data()) ;
+}
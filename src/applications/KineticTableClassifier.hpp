@@ -0,0 +1,391 @@
+#ifndef NGSAI_APP_KINETICTABLECLASSIFIER_HPP
+#define NGSAI_APP_KINETICTABLECLASSIFIER_HPP
+
+#include <list>
+#include <vector>
+#include <array>
+#include <utility>          // std::pair
+#include <pbbam/BamRecord.h>                        // PacBio::BAM::BamRecord
+
+#include <ngsaipp/io/BedRecord.hpp>                 // ngsai::BedRecord
+#include <ngsaipp/genome/CpGRegion.hpp>             // ngsai::genome::CpGRegion
+#include <ngsaipp/epigenetics/CcsKineticExtractor.hpp>  // ngsai::CcsKineticExtractor
+#include <applications/KineticTable.hpp>            // ngsai::app::KineticTable
+#include <applications/KineticKernel.hpp>           // ngsai::app::KineticKernel
+#include <applications/WindowArena.hpp>             // ngsai::app::WindowArena
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief The KineticTableClassifier class computes
+        * the probability that a CpG is methylated from
+        * the CCSs overlapping it, like the
+        * ngsai::KineticClassifier, but using kinetic
+        * models compiled into KineticTables.
+        * Each CCS contributes the kinetic signal of the
+        * window centered on the C of the CpG on each
+        * strand, if it fully covers it.
+        * Once fused, the classifier scores the windows
+        * from a single table containing the log
+        * likelihood ratio of the methylated over the
+        * unmethylated model, which needs half the
+        * lookups.
+        * For models of raw signal, all the windows of a
+        * CpG are extracted first and scored as a batch
+        * by a KineticKernel.
+        * The windows can also be extracted into a
+        * WindowArena as the CCSs are read, in which case
+        * the CCSs do not need to be kept.
+        */
+        class KineticTableClassifier
+        {
+            public:
+                /*!
+                * \brief Constructor. Creates a classifier
+                * without models.
+                */
+                KineticTableClassifier() ;
+
+                /*!
+                * \brief Destructor.
+                */
+                virtual
+                ~KineticTableClassifier() ;
+
+                /*!
+                * \brief Sets the methylated and
+                * unmethylated models.
+                * \param table_meth the methylated model.
+                * \param table_unmeth the unmethylated
+                * model.
+                * \throw std::invalid_argument if the
+                * models window sizes differ or if a model
+                * does not contain log densities.
+                */
+                void
+                setTables(KineticTable&& table_meth,
+                          KineticTable&& table_unmeth) ;
+
+                /*!
+                * \brief Builds the log likelihood ratio
+                * table of the models and uses it for the
+                * subsequent classifications.
+                * \throw std::invalid_argument if the
+                * models have different layouts, binnings
+                * or KmerMaps.
+                */
+                void
+                fuse() ;
+
+                /*!
+                * \brief Indicates whether the classifier
+                * scores the windows from the log
+                * likelihood ratio table.
+                * \return whether the classifier is fused.
+                */
+                bool
+                isFused() const ;
+
+                /*!
+                * \brief Returns the kernel used to score
+                * the batches of windows.
+                * \return the kernel.
+                */
+                const KineticKernel&
+                getKernel() const ;
+
+                /*!
+                * \brief Returns the methylated model.
+                * \return the methylated model.
+                */
+                const KineticTable&
+                getTableMeth() const ;
+
+                /*!
+                * \brief Returns the unmethylated model.
+                * \return the unmethylated model.
+                */
+                const KineticTable&
+                getTableUnmeth() const ;
+
+                /*!
+                * \brief Computes the probabilities that a
+                * CpG is methylated and unmethylated.
+                * \param cpg the CpG of interest.
+                * \param ccss the CCSs overlapping the CpG.
+                * \param prob_meth the prior probability
+                * of methylation.
+                * \param prob_unmeth the prior probability
+                * of non-methylation.
+                * \return the posterior probabilities of
+                * methylation and non-methylation. If no
+                * CCS window could be used, the priors are
+                * returned.
+                */
+                std::pair<double,double>
+                classify(
+                    const ngsai::genome::CpGRegion& cpg,
+                    const std::list<PacBio::BAM::BamRecord>& ccss,
+                    double prob_meth,
+                    double prob_unmeth) const ;
+
+                /*!
+                * \brief Extracts the windows of a CCS
+                * overlapping a CpG into an arena. The
+                * windows of normalized models are scored
+                * at once, those of raw signal models are
+                * kept until score() is called.
+                * The arena must have been reset with the
+                * models window size.
+                * \param cpg the CpG of interest.
+                * \param ccs the CCS.
+                * \param arena the arena.
+                */
+                void
+                extract(const ngsai::genome::CpGRegion& cpg,
+                        const PacBio::BAM::BamRecord& ccs,
+                        WindowArena& arena) const ;
+
+                /*!
+                * \brief Scores, as a batch, the windows
+                * of a range of the CCSs of an arena that
+                * were kept unscored by extract(), taken
+                * in the order given by
+                * WindowArena::getOrder(). Does nothing for
+                * normalized models.
+                * \param arena the arena.
+                * \param first the position of the first
+                * CCS of the range in the order.
+                * \param last the position past the last
+                * CCS of the range in the order.
+                */
+                void
+                score(WindowArena& arena,
+                      size_t first,
+                      size_t last) const ;
+
+                /*!
+                * \brief Computes the probabilities that a
+                * CpG is methylated and unmethylated from
+                * the scored windows of a range of the
+                * CCSs of an arena, taken in the order
+                * given by WindowArena::getOrder().
+                * \param arena the arena.
+                * \param first the position of the first
+                * CCS of the range in the order.
+                * \param last the position past the last
+                * CCS of the range in the order.
+                * \param prob_meth the prior probability
+                * of methylation.
+                * \param prob_unmeth the prior probability
+                * of non-methylation.
+                * \return the posterior probabilities of
+                * methylation and non-methylation. If the
+                * range contains no window, the priors are
+                * returned.
+                */
+                std::pair<double,double>
+                classify(WindowArena& arena,
+                         size_t first,
+                         size_t last,
+                         double prob_meth,
+                         double prob_unmeth) const ;
+
+                /*!
+                * \brief Computes the log likelihoods of
+                * the signal of a CCS, over both strands,
+                * under both models.
+                * \param cpg the CpG of interest.
+                * \param ccs the CCS.
+                * \param extractor the extractor to use to
+                * get the CCS kinetics.
+                * \param ll_meth a reference to which the
+                * log likelihood under the methylated
+                * model is added.
+                * \param ll_unmeth a reference to which
+                * the log likelihood under the unmethylated
+                * model is added.
+                * \return the number of windows used, 0 if
+                * the CCS did not cover any window.
+                */
+                size_t
+                logLikelihood(
+                    const ngsai::genome::CpGRegion& cpg,
+                    const PacBio::BAM::BamRecord& ccs,
+                    ngsai::CcsKineticExtractor& extractor,
+                    double& ll_meth,
+                    double& ll_unmeth) const ;
+
+                /*!
+                * \brief Computes the log likelihood
+                * ratio of the signal of a CCS, over both
+                * strands, from the fused table.
+                * \param cpg the CpG of interest.
+                * \param ccs the CCS.
+                * \param extractor the extractor to use to
+                * get the CCS kinetics.
+                * \param llr a reference to which the log
+                * likelihood ratio of the methylated over
+                * the unmethylated model is added.
+                * \return the number of windows used, 0 if
+                * the CCS did not cover any window.
+                */
+                size_t
+                logLikelihoodRatio(
+                    const ngsai::genome::CpGRegion& cpg,
+                    const PacBio::BAM::BamRecord& ccs,
+                    ngsai::CcsKineticExtractor& extractor,
+                    double& llr) const ;
+
+                /*!
+                * \brief Computes the posterior
+                * probability of methylation given the
+                * total log likelihoods under both models.
+                * \param ll_meth the log likelihood under
+                * the methylated model.
+                * \param ll_unmeth the log likelihood
+                * under the unmethylated model.
+                * \param prob_meth the prior probability
+                * of methylation.
+                * \param prob_unmeth the prior probability
+                * of non-methylation.
+                * \return the posterior probabilities of
+                * methylation and non-methylation.
+                */
+                static
+                std::pair<double,double>
+                posterior(double ll_meth,
+                          double ll_unmeth,
+                          double prob_meth,
+                          double prob_unmeth) ;
+
+                /*!
+                * \brief Computes the forward and reverse
+                * strand windows centered on the C of a
+                * CpG on each strand. This is the only
+                * definition of the windows in papet, the
+                * classifiers and the training both use
+                * it. A window that would start before the
+                * chromosome start is skipped.
+                * \param cpg the CpG of interest.
+                * \param size the window size.
+                * \param windows an array to store the
+                * windows, the forward one first.
+                * \return the number of windows stored.
+                */
+                static
+                size_t
+                getWindows(
+                    const ngsai::BedRecord& cpg,
+                    size_t size,
+                    std::array<ngsai::BedRecord,2>& windows) ;
+
+            protected:
+
+                /*!
+                * \brief Computes the probabilities that a
+                * CpG is methylated and unmethylated by
+                * scoring all the windows as one batch.
+                * The models must be models of raw signal.
+                * \param cpg the CpG of interest.
+                * \param ccss the CCSs overlapping the CpG.
+                * \param prob_meth the prior probability
+                * of methylation.
+                * \param prob_unmeth the prior probability
+                * of non-methylation.
+                * \return the posterior probabilities of
+                * methylation and non-methylation.
+                */
+                std::pair<double,double>
+                classifyBatch(
+                    const ngsai::genome::CpGRegion& cpg,
+                    const std::list<PacBio::BAM::BamRecord>& ccss,
+                    double prob_meth,
+                    double prob_unmeth) const ;
+
+                /*!
+                * \brief Extracts a window of a CCS and
+                * checks that its signal has the length
+                * of the tables, which the scoring reads
+                * without bound checks.
+                * \param ccs the CCS.
+                * \param window the window.
+                * \param extractor the extractor to use,
+                * it contains the window signal if it is
+                * valid.
+                * \return whether the window could be
+                * extracted with the table length.
+                */
+                bool
+                extractWindow(
+                    const PacBio::BAM::BamRecord& ccs,
+                    const ngsai::BedRecord& window,
+                    ngsai::CcsKineticExtractor& extractor) const ;
+
+                /*!
+                * \brief Extracts the windows of all the
+                * CCSs overlapping a CpG, in the layout
+                * expected by KineticKernel::score().
+                * \param cpg the CpG of interest.
+                * \param ccss the CCSs overlapping the CpG.
+                * \param ipd a vector in which the IPD
+                * signal of the windows is written.
+                * \param pwd a vector in which the PWD
+                * signal of the windows is written.
+                * \return the number of windows.
+                */
+                size_t
+                extractWindows(
+                    const ngsai::genome::CpGRegion& cpg,
+                    const std::list<PacBio::BAM::BamRecord>& ccss,
+                    std::vector<uint16_t>& ipd,
+                    std::vector<uint16_t>& pwd) const ;
+
+                /*!
+                * \brief Computes the log likelihood of an
+                * extracted window under a model.
+                * \param table the model.
+                * \param extractor the extractor containing
+                * the window kinetics.
+                * \return the log likelihood.
+                */
+                static
+                double
+                logLikelihood(
+                    const KineticTable& table,
+                    const ngsai::CcsKineticExtractor& extractor) ;
+
+            protected:
+                /*!
+                * \brief the methylated model.
+                */
+                KineticTable m_table_meth ;
+                /*!
+                * \brief the unmethylated model.
+                */
+                KineticTable m_table_unmeth ;
+                /*!
+                * \brief the log likelihood ratio of the
+                * methylated over the unmethylated model.
+                */
+                KineticTable m_table_llr ;
+                /*!
+                * \brief whether to score the windows from
+                * the log likelihood ratio table.
+                */
+                bool m_fused ;
+                /*!
+                * \brief the kernel scoring the batches of
+                * windows.
+                */
+                KineticKernel m_kernel ;
+        } ;
+
+    }  // namespace app
+
+}  // namespace ngsai
+
+#endif  // NGSAI_APP_KINETICTABLECLASSIFIER_HPP
@@ -0,0 +1,79 @@
+#include <applications/MappedFile.hpp>
+
+#include <cerrno>           // errno
+#include <cstring>          // std::strerror()
+#include <stdexcept>        // std::runtime_error
+#include <fcntl.h>          // open()
+#include <unistd.h>         // close()
+#include <sys/stat.h>       // fstat()
+#include <sys/mman.h>       // mmap(), munmap(), madvise()
+
+
+ngsai::app::MappedFile::MappedFile(const std::string& path)
+    : m_path(path),
+      m_data(nullptr),
+      m_size(0)
+{   int fd = open(path.c_str(), O_RDONLY) ;
+    if(fd < 0)
+    {   throw std::runtime_error("MappedFile error! cannot "
+                                 "open " + path + " : " +
+                                 std::strerror(errno)) ;
+    }
+
+    struct stat info ;
+    if(fstat(fd, &info) != 0)
+    {   int error = errno ;
+        close(fd) ;
+        throw std::runtime_error("MappedFile error! cannot "
+                                 "stat " + path + " : " +
+                                 std::strerror(error)) ;
+    }
+    m_size = static_cast<size_t>(info.st_size) ;
+
+    // nothing to map
+    if(m_size == 0)
+    {   close(fd) ;
+        return ;
+    }
+
+    void* address = mmap(nullptr,
+                         m_size,
+                         PROT_READ,
+                         MAP_SHARED,
+                         fd,
+                         0) ;
+    int error = errno ;
+    // the mapping remains valid after closing
+    close(fd) ;
+    if(address == MAP_FAILED)
+    {   throw std::runtime_error("MappedFile error! cannot "
+                                 "map " + path + " : " +
+                                 std::strerror(error)) ;
+    }
+    // the whole file will be read
+    madvise(address, m_size, MADV_WILLNEED) ;
+    m_data = static_cast<const char*>(address) ;
+}
+
+
+ngsai::app::MappedFile::~MappedFile()
+{   if(m_data != nullptr)
+    {   munmap(const_cast<char*>(m_data), m_size) ;
+        m_data = nullptr ;
+    }
+}
+
+
+const char*
+ngsai::app::MappedFile::data() const
+{   return m_data ; }
+
+
+size_t
+ngsai::app::MappedFile::size() const
+{   return m_size ; }
+
+
+const std::string&
+ngsai::app::MappedFile::getPath() const
+{   return m_path ; }
@@ -0,0 +1,84 @@
+#ifndef NGSAI_APP_MAPPEDFILE_HPP
+#define NGSAI_APP_MAPPEDFILE_HPP
+
+#include <string>
+#include <cstddef>
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief The MappedFile class maps the content of a
+        * file read-only in memory.
+        * The mapping is shared : the pages are those of
+        * the page cache and are thus shared by all the
+        * processes mapping the same file on a node. The
+        * file is unmapped upon destruction.
+        */
+        class MappedFile
+        {
+            public:
+                /*!
+                * \brief Constructor. Maps a file.
+                * \param path the path to the file.
+                * \throw std::runtime_error if the file
+                * cannot be opened or mapped.
+                */
+                MappedFile(const std::string& path) ;
+
+                MappedFile(const MappedFile& other) = delete ;
+
+                MappedFile&
+                operator = (const MappedFile& other) = delete ;
+
+                /*!
+                * \brief Destructor. Unmaps the file.
+                */
+                virtual
+                ~MappedFile() ;
+
+                /*!
+                * \brief Returns the address of the file
+                * content.
+                * \return the address, nullptr if the file
+                * is empty.
+                */
+                const char*
+                data() const ;
+
+                /*!
+                * \brief Returns the file size.
+                * \return the size in bytes.
+                */
+                size_t
+                size() const ;
+
+                /*!
+                * \brief Returns the path to the file.
+                * \return the path.
+                */
+                const std::string&
+                getPath() const ;
+
+            protected:
+                /*!
+                * \brief the path to the file.
+                */
+                std::string m_path ;
+                /*!
+                * \brief the address of the mapping.
+                */
+                const char* m_data ;
+                /*!
+                * \brief the file size in bytes.
+                */
+                size_t m_size ;
+        } ;
+
+    }  // namespace app
+
+}  // namespace ngsai
+
+#endif  // NGSAI_APP_MAPPEDFILE_HPP
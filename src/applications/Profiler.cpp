@@ -0,0 +1,264 @@
+#include <applications/Profiler.hpp>
+
+#include <string>
+#include <fstream>
+#include <sstream>          // std::ostringstream
+#include <iomanip>          // std::setprecision()
+#include <chrono>           // std::chrono::steady_clock, std::chrono::duration
+#include <stdexcept>        // std::runtime_error
+#include <mutex>            // std::mutex, std::lock_guard
+#include <time.h>           // clock_gettime()
+
+
+/*!
+ * \brief the names of the stages in the report.
+ */
+static const char* stage_names[] = {"bed_load",
+                                    "model_load",
+                                    "bam_fetch",
+                                    "extraction",
+                                    "classification",
+                                    "output"} ;
+
+
+/*!
+ * \brief the names of the counters in the report.
+ */
+static const char* counter_names[] = {"records_read",
+                                      "windows_extracted",
+                                      "bytes_written"} ;
+
+
+/*!
+ * \brief Returns the value of a POSIX clock.
+ * \param clock the clock.
+ * \return the time, in seconds.
+ */
+static
+double
+getClockTime(clockid_t clock)
+{   struct timespec t ;
+    clock_gettime(clock, &t) ;
+    return double(t.tv_sec) + 1e-9 * double(t.tv_nsec) ;
+}
+
+
+const size_t ngsai::app::Profiler::stage_n ;
+
+
+const size_t ngsai::app::Profiler::counter_n ;
+
+
+ngsai::app::Profiler::Profiler()
+    : m_enabled(false),
+      m_start(),
+      m_threads(),
+      m_mutex()
+{ ; }
+
+
+ngsai::app::Profiler&
+ngsai::app::Profiler::getInstance()
+{   static Profiler profiler ;
+    return profiler ;
+}
+
+
+void
+ngsai::app::Profiler::enable()
+{   m_enabled = true ;
+    m_start   = std::chrono::steady_clock::now() ;
+}
+
+
+bool
+ngsai::app::Profiler::isEnabled() const
+{   return m_enabled ; }
+
+
+void
+ngsai::app::Profiler::add(stages stage,
+                          double wall,
+                          double cpu)
+{   if(not m_enabled)
+    {   return ; }
+    ThreadProfile& profile = this->getThreadProfile() ;
+    size_t i = static_cast<size_t>(stage) ;
+    profile.wall[i]  += wall ;
+    profile.cpu[i]   += cpu ;
+    profile.calls[i] += 1 ;
+}
+
+
+void
+ngsai::app::Profiler::count(counters counter,
+                            uint64_t n)
+{   if(not m_enabled)
+    {   return ; }
+    this->getThreadProfile().count[static_cast<size_t>(counter)] += n ;
+}
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+         * \brief Escapes a string to be written as a
+         * JSON string value.
+         * \param value the string.
+         * \return the escaped string, without the
+         * quotes.
+         */
+        static
+        std::string
+        escape_json(const std::string& value)
+        {   std::ostringstream escaped ;
+            for(char c : value)
+            {   if(c == '"')
+                {   escaped << "\\\"" ; }
+                else if(c == '\\')
+                {   escaped << "\\\\" ; }
+                else if(c == '\n')
+                {   escaped << "\\n" ; }
+                else if(c == '\t')
+                {   escaped << "\\t" ; }
+                else if(static_cast<unsigned char>(c) < 0x20)
+                {   escaped << "\\u" << std::hex << std::setw(4)
+                            << std::setfill('0')
+                            << static_cast<int>(c)
+                            << std::dec << std::setfill(' ') ;
+                }
+                else
+                {   escaped << c ; }
+            }
+            return escaped.str() ;
+        }
+    }
+}
+
+
+void
+ngsai::app::Profiler::writeReport(const std::string& path,
+                                  const std::string& command)
+{   std::lock_guard<std::mutex> lock(m_mutex) ;
+
+    double wall = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() -
+                    m_start).count() ;
+    double cpu  = getClockTime(CLOCK_PROCESS_CPUTIME_ID) ;
+
+    // sums over the threads
+    ThreadProfile total ;
+    for(const auto& profile : m_threads)
+    {   for(size_t i=0; i<stage_n; i++)
+        {   total.wall[i]  += profile.wall[i] ;
+            total.cpu[i]   += profile.cpu[i] ;
+            total.calls[i] += profile.calls[i] ;
+        }
+        for(size_t i=0; i<counter_n; i++)
+        {   total.count[i] += profile.count[i] ; }
+    }
+
+    // writes the stages and counters of an entry
+    auto write = [](std::ostream& stream,
+                    const ThreadProfile& profile,
+                    const std::string& indent) -> void
+    {   stream << indent << "\"stages\": {\n" ;
+        for(size_t i=0; i<stage_n; i++)
+        {   stream << indent << "  \"" << stage_names[i]
+                   << "\": {\"wall\": " << profile.wall[i]
+                   << ", \"cpu\": "     << profile.cpu[i]
+                   << ", \"calls\": "   << profile.calls[i]
+                   << "}" << ((i+1 < stage_n) ? ",\n" : "\n") ;
+        }
+        stream << indent << "},\n"
+               << indent << "\"counters\": {\n" ;
+        for(size_t i=0; i<counter_n; i++)
+        {   stream << indent << "  \"" << counter_names[i]
+                   << "\": " << profile.count[i]
+                   << ((i+1 < counter_n) ? ",\n" : "\n") ;
+        }
+        stream << indent << "}\n" ;
+    } ;
+
+    std::ofstream f_out(path) ;
+    if(not f_out.is_open())
+    {   throw std::runtime_error("Profiler error! cannot "
+                                 "write " + path) ;
+    }
+    f_out << std::setprecision(6) ;
+    f_out << "{\n"
+          << "  \"command\": \"" << escape_json(command) << "\",\n"
+          << "  \"wall\": " << wall << ",\n"
+          << "  \"cpu\": "  << cpu  << ",\n"
+          << "  \"total\": {\n" ;
+    write(f_out, total, "    ") ;
+    f_out << "  },\n"
+          << "  \"threads\": [\n" ;
+    size_t n = 0 ;
+    for(const auto& profile : m_threads)
+    {   f_out << "    {\n"
+              << "      \"thread\": " << n << ",\n" ;
+        write(f_out, profile, "      ") ;
+        n++ ;
+        f_out << "    }" << ((n < m_threads.size()) ? ",\n" : "\n") ;
+    }
+    f_out << "  ]\n"
+          << "}\n" ;
+    f_out.close() ;
+    if(not f_out)
+    {   throw std::runtime_error("Profiler error! cannot "
+                                 "write " + path) ;
+    }
+}
+
+
+double
+ngsai::app::Profiler::getThreadCpuTime()
+{   return getClockTime(CLOCK_THREAD_CPUTIME_ID) ; }
+
+
+ngsai::app::Profiler::ThreadProfile&
+ngsai::app::Profiler::getThreadProfile()
+{   // the entry is looked up once per thread
+    thread_local ThreadProfile* profile = nullptr ;
+    if(profile == nullptr)
+    {   std::lock_guard<std::mutex> lock(m_mutex) ;
+        m_threads.emplace_back() ;
+        profile = &(m_threads.back()) ;
+    }
+    return *profile ;
+}
+
+
+ngsai::app::StageTimer::StageTimer(Profiler::stages stage)
+    : m_enabled(Profiler::getInstance().isEnabled()),
+      m_stage(stage),
+      m_wall(),
+      m_cpu(0.)
+{   if(m_enabled)
+    {   m_wall = std::chrono::steady_clock::now() ;
+        m_cpu  = Profiler::getThreadCpuTime() ;
+    }
+}
+
+
+ngsai::app::StageTimer::~StageTimer()
+{   this->switchTo(m_stage) ; }
+
+
+void
+ngsai::app::StageTimer::switchTo(Profiler::stages stage)
+{   if(not m_enabled)
+    {   return ; }
+    auto   wall = std::chrono::steady_clock::now() ;
+    double cpu  = Profiler::getThreadCpuTime() ;
+    Profiler::getInstance().add(
+                m_stage,
+                std::chrono::duration<double>(wall - m_wall).count(),
+                cpu - m_cpu) ;
+    m_stage = stage ;
+    m_wall  = wall ;
+    m_cpu   = cpu ;
+}
@@ -0,0 +1,252 @@
+#ifndef NGSAI_APP_PROFILER_HPP
+#define NGSAI_APP_PROFILER_HPP
+
+#include <string>
+#include <list>
+#include <mutex>            // std::mutex
+#include <chrono>           // std::chrono::steady_clock
+#include <cstdint>
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief The Profiler class records, for each
+        * thread, the wall and CPU times spent in the
+        * named stages of a papet command, together with
+        * a few counters, and writes them as a JSON
+        * report.
+        * There is a single profiler per process,
+        * returned by getInstance(). It is disabled by
+        * default, in which case recording costs a single
+        * test. Each thread records in its own entry,
+        * such that recording does not need any lock once
+        * a thread has registered.
+        */
+        class Profiler
+        {
+            public:
+                /*!
+                * \brief The stages of a command.
+                */
+                enum class stages {bed_load,
+                                   model_load,
+                                   bam_fetch,
+                                   extraction,
+                                   classification,
+                                   output} ;
+
+                /*!
+                * \brief The counters.
+                */
+                enum class counters {records_read,
+                                     windows_extracted,
+                                     bytes_written} ;
+
+                /*!
+                * \brief the number of stages.
+                */
+                static const size_t stage_n = 6 ;
+
+                /*!
+                * \brief the number of counters.
+                */
+                static const size_t counter_n = 3 ;
+
+            public:
+                /*!
+                * \brief Returns the profiler of the
+                * process.
+                * \return the profiler.
+                */
+                static
+                Profiler&
+                getInstance() ;
+
+                Profiler(const Profiler& other) = delete ;
+
+                Profiler&
+                operator = (const Profiler& other) = delete ;
+
+                /*!
+                * \brief Enables the recording. The
+                * process wall time is measured from this
+                * call. It must be called before the worker
+                * threads start.
+                */
+                void
+                enable() ;
+
+                /*!
+                * \brief Indicates whether the recording
+                * is enabled.
+                * \return whether the profiler records.
+                */
+                bool
+                isEnabled() const ;
+
+                /*!
+                * \brief Adds the time spent in a stage to
+                * the entry of the calling thread.
+                * \param stage the stage.
+                * \param wall the wall time, in seconds.
+                * \param cpu the CPU time of the thread, in
+                * seconds.
+                */
+                void
+                add(stages stage,
+                    double wall,
+                    double cpu) ;
+
+                /*!
+                * \brief Increments a counter of the entry
+                * of the calling thread.
+                * \param counter the counter.
+                * \param n the increment.
+                */
+                void
+                count(counters counter,
+                      uint64_t n) ;
+
+                /*!
+                * \brief Writes the report in JSON format.
+                * The stages and counters are given for
+                * each thread, in the order in which they
+                * first recorded, and summed over the
+                * threads. It must be called once the
+                * worker threads are done.
+                * \param path the path to the file to
+                * write.
+                * \param command the name of the profiled
+                * command.
+                * \throw std::runtime_error if the file
+                * cannot be written.
+                */
+                void
+                writeReport(const std::string& path,
+                            const std::string& command) ;
+
+                /*!
+                * \brief Returns the CPU time used by the
+                * calling thread.
+                * \return the CPU time, in seconds.
+                */
+                static
+                double
+                getThreadCpuTime() ;
+
+            protected:
+                /*!
+                * \brief The times and counters recorded
+                * by a thread.
+                */
+                struct ThreadProfile
+                {   double   wall[stage_n]     = {} ;
+                    double   cpu[stage_n]      = {} ;
+                    uint64_t calls[stage_n]    = {} ;
+                    uint64_t count[counter_n]  = {} ;
+                } ;
+
+                /*!
+                * \brief Constructor. Creates a disabled
+                * profiler.
+                */
+                Profiler() ;
+
+                /*!
+                * \brief Returns the entry of the calling
+                * thread, creating it at the first call.
+                * \return the entry.
+                */
+                ThreadProfile&
+                getThreadProfile() ;
+
+            protected:
+                /*!
+                * \brief whether the recording is enabled.
+                */
+                bool m_enabled ;
+                /*!
+                * \brief when the recording was enabled.
+                */
+                std::chrono::steady_clock::time_point m_start ;
+                /*!
+                * \brief the thread entries, a list such
+                * that they never move.
+                */
+                std::list<ThreadProfile> m_threads ;
+                /*!
+                * \brief protects the thread entries
+                * list.
+                */
+                std::mutex m_mutex ;
+        } ;
+
+
+        /*!
+        * \brief The StageTimer class measures the wall
+        * and CPU times spent by a thread in a sequence of
+        * stages and adds them to the Profiler. Switching
+        * from one stage to the next reads the clocks once.
+        * The current stage is closed when the timer is
+        * destroyed. Nothing is measured if the profiler is
+        * disabled.
+        */
+        class StageTimer
+        {
+            public:
+                /*!
+                * \brief Constructor. Starts timing a
+                * stage.
+                * \param stage the stage.
+                */
+                StageTimer(Profiler::stages stage) ;
+
+                StageTimer(const StageTimer& other) = delete ;
+
+                StageTimer&
+                operator = (const StageTimer& other) = delete ;
+
+                /*!
+                * \brief Destructor. Closes the current
+                * stage.
+                */
+                virtual
+                ~StageTimer() ;
+
+                /*!
+                * \brief Closes the current stage and
+                * starts timing another one.
+                * \param stage the new stage.
+                */
+                void
+                switchTo(Profiler::stages stage) ;
+
+            protected:
+                /*!
+                * \brief whether the profiler is enabled.
+                */
+                bool m_enabled ;
+                /*!
+                * \brief the current stage.
+                */
+                Profiler::stages m_stage ;
+                /*!
+                * \brief the wall time at which the
+                * current stage started.
+                */
+                std::chrono::steady_clock::time_point m_wall ;
+                /*!
+                * \brief the thread CPU time at which the
+                * current stage started, in seconds.
+                */
+                double m_cpu ;
+        } ;
+
+    }  // namespace app
+
+}  // namespace ngsai
+
+#endif  // NGSAI_APP_PROFILER_HPP
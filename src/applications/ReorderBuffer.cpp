@@ -0,0 +1,131 @@
+#include <applications/ReorderBuffer.hpp>
+
+#include <string>
+#include <stdexcept>            // std::invalid_argument, std::exception
+#include <mutex>                // std::mutex, std::unique_lock
+
+#include <applications/CheckpointLog.hpp>  // ngsai::app::CheckpointLog
+#include <applications/Profiler.hpp>       // ngsai::app::Profiler
+
+
+ngsai::app::ReorderBuffer::ReorderBuffer(
+                                std::ostream& stream,
+                                size_t capacity)
+    : ReorderBuffer(stream, capacity, 0, 0, nullptr)
+{ ; }
+
+
+ngsai::app::ReorderBuffer::ReorderBuffer(
+                    std::ostream& stream,
+                    size_t capacity,
+                    size_t first,
+                    size_t n_bytes,
+                    ngsai::app::CheckpointLog* checkpoint)
+    : m_stream(stream),
+      m_capacity(capacity),
+      m_next(first),
+      m_bytes(n_bytes),
+      m_checkpoint(checkpoint),
+      m_pending(),
+      m_mutex(),
+      m_written(),
+      m_error(),
+      m_aborted(false)
+{   if(capacity == 0)
+    {   throw std::invalid_argument("ReorderBuffer error! "
+                                    "capacity must be > 0") ;
+    }
+}
+
+
+ngsai::app::ReorderBuffer::~ReorderBuffer()
+{ ; }
+
+
+void
+ngsai::app::ReorderBuffer::push(size_t index,
+                                std::string&& chunk)
+{   std::unique_lock<std::mutex> lock(m_mutex) ;
+
+    // wait until there is room for this chunk
+    m_written.wait(lock,
+                   [this, index]()
+                   {   return m_aborted or
+                              (index < m_next + m_capacity) ;
+                   }) ;
+    if(m_aborted)
+    {   return ; }
+
+    m_pending.emplace(index, std::move(chunk)) ;
+
+    // write all the consecutive chunks available
+    bool written = false ;
+    auto iter = m_pending.begin() ;
+    while((iter != m_pending.end()) and
+          (iter->first == m_next))
+    {   m_stream << iter->second ;
+        m_bytes += iter->second.size() ;
+        ngsai::app::Profiler::getInstance().count(
+                ngsai::app::Profiler::counters::bytes_written,
+                iter->second.size()) ;
+        iter = m_pending.erase(iter) ;
+        m_next++ ;
+        written = true ;
+    }
+
+    if(written)
+    {   m_stream.flush() ;
+        // the chunks must be out before they are logged, 
+        // nothing is logged after a failure
+        if(m_error.empty() and (not m_stream))
+        {   m_error = "could not write the chunks before chunk " +
+                      std::to_string(m_next) ;
+        }
+        if(m_error.empty() and (m_checkpoint != nullptr))
+        {   try
+            {   m_checkpoint->append(std::to_string(m_next) + " " +
+                                     std::to_string(m_bytes)) ;
+            }
+            catch(const std::exception& e)
+            {   m_error = e.what() ; }
+        }
+        m_written.notify_all() ;
+    }
+}
+
+
+void
+ngsai::app::ReorderBuffer::abort(const std::string& error)
+{   std::lock_guard<std::mutex> lock(m_mutex) ;
+    if(m_error.empty())
+    {   m_error = error ; }
+    m_aborted = true ;
+    m_pending.clear() ;
+    m_written.notify_all() ;
+}
+
+
+size_t
+ngsai::app::ReorderBuffer::getNextIndex() const
+{   std::lock_guard<std::mutex> lock(m_mutex) ;
+    return m_next ;
+}
+
+
+size_t
+ngsai::app::ReorderBuffer::getCapacity() const
+{   return m_capacity ; }
+
+
+bool
+ngsai::app::ReorderBuffer::hasFailed() const
+{   std::lock_guard<std::mutex> lock(m_mutex) ;
+    return not m_error.empty() ;
+}
+
+
+std::string
+ngsai::app::ReorderBuffer::getError() const
+{   std::lock_guard<std::mutex> lock(m_mutex) ;
+    return m_error ;
+}
@@ -0,0 +1,209 @@
+#ifndef NGSAI_APP_REORDERBUFFER_HPP
+#define NGSAI_APP_REORDERBUFFER_HPP
+
+#include <iostream>
+#include <string>
+#include <map>
+#include <mutex>                // std::mutex
+#include <condition_variable>   // std::condition_variable
+
+#include <applications/CheckpointLog.hpp>  // ngsai::app::CheckpointLog
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief The ReorderBuffer class allows several
+        * threads to produce consecutive chunks of results
+        * in any order while the chunks are written on a
+        * stream in their original order, as soon as they
+        * are ready.
+        * At most a given number of chunks can be pending
+        * in the buffer. A thread pushing a chunk beyond
+        * this limit is blocked until the preceding chunks
+        * have been written, which bounds the memory used.
+        * Optionally, the number of chunks written and the
+        * number of bytes written are appended to a
+        * checkpoint log each time chunks are written, such
+        * that an interrupted run can resume after the
+        * last chunk written.
+        * A failure to write the stream or the log does
+        * not throw in the pushing thread, it is recorded
+        * and nothing more is logged, such that the
+        * log never covers output that was not written.
+        * A thread failing to produce its chunk aborts the
+        * buffer, after which nothing more is written and
+        * no push blocks anymore.
+        */
+        class ReorderBuffer
+        {
+            public:
+                /*!
+                * \brief Constructor.
+                * \param stream the stream on which the
+                * chunks will be written.
+                * \param capacity the maximum number of
+                * chunks, counted from the next chunk to
+                * write, that can be stored in the buffer.
+                * It must be > 0.
+                * \throw std::invalid_argument if the
+                * capacity is 0.
+                */
+                ReorderBuffer(std::ostream& stream,
+                              size_t capacity) ;
+
+                /*!
+                * \brief Constructor for a resumed run.
+                * \param stream the stream on which the
+                * chunks will be written.
+                * \param capacity the maximum number of
+                * chunks, counted from the next chunk to
+                * write, that can be stored in the buffer.
+                * It must be > 0.
+                * \param first the index of the first
+                * chunk to write, the preceding ones have
+                * already been written.
+                * \param n_bytes the number of bytes
+                * already written on the stream.
+                * \param checkpoint the log in which
+                * "<chunks written> <bytes written>" is
+                * appended each time chunks are written,
+                * nullptr for none.
+                * \throw std::invalid_argument if the
+                * capacity is 0.
+                */
+                ReorderBuffer(std::ostream& stream,
+                              size_t capacity,
+                              size_t first,
+                              size_t n_bytes,
+                              ngsai::app::CheckpointLog* checkpoint) ;
+
+                /*!
+                * \brief Destructor.
+                */
+                virtual
+                ~ReorderBuffer() ;
+
+                /*!
+                * \brief Pushes a chunk in the buffer. If
+                * the chunk is the next one to write, it
+                * is written on the stream along with all
+                * the following chunks that are already
+                * present in the buffer.
+                * This call blocks as long as the chunk
+                * index is too far from the next chunk to
+                * write.
+                * \param index the chunk index, 0 for the
+                * first chunk. Each index from the first
+                * one must be pushed exactly once.
+                * \param chunk the chunk content.
+                */
+                void
+                push(size_t index,
+                     std::string&& chunk) ;
+
+                /*!
+                * \brief Aborts the writing, for instance
+                * because a chunk could not be produced.
+                * The chunks pushed afterwards are
+                * discarded and the threads blocked in
+                * push() are released.
+                * \param error the description of the
+                * failure, kept unless a failure was
+                * already recorded.
+                */
+                void
+                abort(const std::string& error) ;
+
+                /*!
+                * \brief Returns the index of the next
+                * chunk to write, that is the number of
+                * chunks written so far.
+                * \return the index of the next chunk to
+                * write.
+                */
+                size_t
+                getNextIndex() const ;
+
+                /*!
+                * \brief Returns the maximum number of
+                * chunks that can be stored.
+                * \return the buffer capacity.
+                */
+                size_t
+                getCapacity() const ;
+
+                /*!
+                * \brief Returns whether writing the
+                * stream or the checkpoint log failed or
+                * whether the buffer was aborted.
+                * \return whether a write failed.
+                */
+                bool
+                hasFailed() const ;
+
+                /*!
+                * \brief Returns the description of the
+                * first failure.
+                * \return the error message, empty if
+                * nothing failed.
+                */
+                std::string
+                getError() const ;
+
+            protected:
+                /*!
+                * \brief the stream on which the chunks
+                * are written.
+                */
+                std::ostream& m_stream ;
+                /*!
+                * \brief the maximum number of chunks that
+                * can be stored.
+                */
+                size_t m_capacity ;
+                /*!
+                * \brief the index of the next chunk to
+                * write.
+                */
+                size_t m_next ;
+                /*!
+                * \brief the number of bytes written.
+                */
+                size_t m_bytes ;
+                /*!
+                * \brief the checkpoint log, if any.
+                */
+                ngsai::app::CheckpointLog* m_checkpoint ;
+                /*!
+                * \brief the chunks that have been pushed
+                * but not written yet, by index.
+                */
+                std::map<size_t,std::string> m_pending ;
+                /*!
+                * \brief protects the buffer state.
+                */
+                mutable std::mutex m_mutex ;
+                /*!
+                * \brief signals that chunks have been
+                * written.
+                */
+                std::condition_variable m_written ;
+                /*!
+                * \brief the description of the first
+                * failure, empty if none.
+                */
+                std::string m_error ;
+                /*!
+                * \brief whether the buffer was aborted.
+                */
+                bool m_aborted ;
+        } ;
+
+    }  // namespace app
+
+}  // namespace ngsai
+
+#endif  // NGSAI_APP_REORDERBUFFER_HPP
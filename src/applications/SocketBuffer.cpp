@@ -0,0 +1,101 @@
+#include <applications/SocketBuffer.hpp>
+
+#include <cerrno>           // errno, EINTR, EIO
+#include <sys/types.h>
+#include <sys/socket.h>     // send(), recv()
+
+
+ngsai::app::SocketBuffer::SocketBuffer(int fd,
+                                       size_t size)
+    : m_fd(fd),
+      m_in(size),
+      m_out(size),
+      m_failed(false),
+      m_errno(0)
+{   // empty input, output starts at the buffer begin
+    this->setg(m_in.data(), m_in.data(), m_in.data()) ;
+    this->setp(m_out.data(), m_out.data() + m_out.size()) ;
+}
+
+
+ngsai::app::SocketBuffer::~SocketBuffer()
+{   this->writeBuffer() ; }
+
+
+bool
+ngsai::app::SocketBuffer::hasFailed() const
+{   return m_failed ; }
+
+
+int
+ngsai::app::SocketBuffer::getErrno() const
+{   return m_errno ; }
+
+
+ngsai::app::SocketBuffer::int_type
+ngsai::app::SocketBuffer::overflow(int_type c)
+{   if(not this->writeBuffer())
+    {   return traits_type::eof() ; }
+    if(not traits_type::eq_int_type(c, traits_type::eof()))
+    {   *(this->pptr()) = traits_type::to_char_type(c) ;
+        this->pbump(1) ;
+    }
+    return traits_type::not_eof(c) ;
+}
+
+
+int
+ngsai::app::SocketBuffer::sync()
+{   return this->writeBuffer() ? 0 : -1 ; }
+
+
+ngsai::app::SocketBuffer::int_type
+ngsai::app::SocketBuffer::underflow()
+{   if(this->gptr() < this->egptr())
+    {   return traits_type::to_int_type(*(this->gptr())) ; }
+
+    ssize_t n = 0 ;
+    do
+    {   n = recv(m_fd, m_in.data(), m_in.size(), 0) ; }
+    while((n < 0) and (errno == EINTR)) ;
+    if(n < 0)
+    {   this->setFailed(errno) ;
+        return traits_type::eof() ;
+    }
+    else if(n == 0)
+    {   return traits_type::eof() ; }
+
+    this->setg(m_in.data(), m_in.data(), m_in.data() + n) ;
+    return traits_type::to_int_type(*(this->gptr())) ;
+}
+
+
+bool
+ngsai::app::SocketBuffer::writeBuffer()
+{   const char* from = this->pbase() ;
+    const char* to   = this->pptr() ;
+    while(from < to)
+    {   ssize_t n = send(m_fd, from, to - from, MSG_NOSIGNAL) ;
+        if((n < 0) and (errno == EINTR))
+        {   continue ; }
+        else if(n < 0)
+        {   this->setFailed(errno) ;
+            return false ;
+        }
+        else if(n == 0)
+        {   this->setFailed(EIO) ;
+            return false ;
+        }
+        from += n ;
+    }
+    this->setp(m_out.data(), m_out.data() + m_out.size()) ;
+    return true ;
+}
+
+
+void
+ngsai::app::SocketBuffer::setFailed(int error)
+{   if(not m_failed)
+    {   m_errno = error ; }
+    m_failed = true ;
+}
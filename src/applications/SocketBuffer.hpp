@@ -0,0 +1,146 @@
+#ifndef NGSAI_APP_SOCKETBUFFER_HPP
+#define NGSAI_APP_SOCKETBUFFER_HPP
+
+#include <string>
+#include <vector>
+#include <streambuf>
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief The SocketBuffer class is a stream buffer
+        * reading from and writing to a connected socket,
+        * such that the socket can be used through
+        * std::istream and std::ostream.
+        * Writing to a socket closed by the peer does not
+        * raise SIGPIPE but sets the stream in error.
+        * The socket is not closed by the buffer.
+        */
+        class SocketBuffer : public std::streambuf
+        {
+            public:
+                /*!
+                * \brief Constructor.
+                * \param fd the socket file descriptor.
+                * \param size the size of the input and of
+                * the output buffers, in bytes.
+                */
+                SocketBuffer(int fd,
+                             size_t size=65536) ;
+
+                SocketBuffer(const SocketBuffer& other) = delete ;
+
+                SocketBuffer&
+                operator = (const SocketBuffer& other) = delete ;
+
+                /*!
+                * \brief Destructor. Writes the remaining
+                * buffered output.
+                */
+                virtual
+                ~SocketBuffer() override ;
+
+                /*!
+                * \brief Indicates whether reading or
+                * writing the socket failed, for instance
+                * on a timeout, as opposed to the peer
+                * closing its end.
+                * \return whether an error occured.
+                */
+                bool
+                hasFailed() const ;
+
+                /*!
+                * \brief Returns the error number of the
+                * first failure to read or write the
+                * socket.
+                * \return the errno value, 0 if nothing
+                * failed.
+                */
+                int
+                getErrno() const ;
+
+            protected:
+                /*!
+                * \brief Writes the buffered output and
+                * the given character.
+                * \param c the character that did not fit
+                * in the buffer.
+                * \return c, or traits_type::eof() if the
+                * socket could not be written.
+                */
+                virtual
+                int_type
+                overflow(int_type c) override ;
+
+                /*!
+                * \brief Writes the buffered output.
+                * \return 0, or -1 if the socket could not
+                * be written.
+                */
+                virtual
+                int
+                sync() override ;
+
+                /*!
+                * \brief Reads the next bytes from the
+                * socket.
+                * \return the next character, or
+                * traits_type::eof() if the peer closed
+                * its end or an error occured, in which
+                * case m_failed and m_errno are set.
+                */
+                virtual
+                int_type
+                underflow() override ;
+
+                /*!
+                * \brief Writes the buffered output on the
+                * socket.
+                * \return whether all of it was written.
+                */
+                bool
+                writeBuffer() ;
+
+                /*!
+                * \brief Records a failure, along with its
+                * errno value unless one was already
+                * recorded.
+                * \param error the errno value.
+                */
+                void
+                setFailed(int error) ;
+
+            protected:
+                /*!
+                * \brief the socket file descriptor.
+                */
+                int m_fd ;
+                /*!
+                * \brief the input buffer.
+                */
+                std::vector<char> m_in ;
+                /*!
+                * \brief the output buffer.
+                */
+                std::vector<char> m_out ;
+                /*!
+                * \brief whether reading or writing
+                * failed.
+                */
+                bool m_failed ;
+                /*!
+                * \brief the errno value of the first
+                * failure, 0 if none.
+                */
+                int m_errno ;
+        } ;
+
+    }  // namespace app
+
+}  // namespace ngsai
+
+#endif  // NGSAI_APP_SOCKETBUFFER_HPP
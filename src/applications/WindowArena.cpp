@@ -0,0 +1,197 @@
+#include <applications/WindowArena.hpp>
+
+#include <vector>
+#include <numeric>          // std::iota()
+#include <algorithm>        // std::sort()
+#include <random>           // std::mt19937
+
+
+const size_t ngsai::app::WindowArena::windows_per_ccs = 2 ;
+
+
+ngsai::app::WindowArena::WindowArena()
+    : m_window_size(0),
+      m_max_ccss(0),
+      m_ccs_n(0),
+      m_slot_n(0),
+      m_generator(),
+      m_ccs_index(),
+      m_window_n(),
+      m_ipd(),
+      m_pwd(),
+      m_score_meth(),
+      m_score_unmeth(),
+      m_order(),
+      m_extractor(),
+      m_batch_ipd(),
+      m_batch_pwd(),
+      m_batch_bins(),
+      m_batch_scores()
+{ ; }
+
+
+ngsai::app::WindowArena::~WindowArena()
+{ ; }
+
+
+void
+ngsai::app::WindowArena::reset(size_t window_size,
+                               size_t max_ccss,
+                               uint32_t seed)
+{   m_window_size = window_size ;
+    m_max_ccss    = max_ccss ;
+    m_ccs_n       = 0 ;
+    m_slot_n      = 0 ;
+    m_generator.seed(seed) ;
+}
+
+
+bool
+ngsai::app::WindowArena::addCcs(size_t& slot)
+{   size_t i = m_ccs_n ;
+    m_ccs_n++ ;
+
+    // the reservoir replaces a kept CCS with decreasing
+    // probability, the modulo keeps the draws identical
+    // across standard libraries
+    if((m_max_ccss > 0) and (i >= m_max_ccss))
+    {   size_t j = m_generator() % (i + 1) ;
+        if(j >= m_max_ccss)
+        {   return false ; }
+        slot = j ;
+    }
+    else
+    {   slot = m_slot_n ;
+        m_slot_n++ ;
+        // grow by whole slots, the memory is never
+        // released
+        if(m_ccs_index.size() < m_slot_n)
+        {   m_ccs_index.resize(m_slot_n) ;
+            m_window_n.resize(m_slot_n) ;
+            m_score_meth.resize(m_slot_n * windows_per_ccs) ;
+            m_score_unmeth.resize(m_slot_n * windows_per_ccs) ;
+        }
+        size_t n_values = m_slot_n * windows_per_ccs *
+                          m_window_size ;
+        if(m_ipd.size() < n_values)
+        {   m_ipd.resize(n_values) ;
+            m_pwd.resize(n_values) ;
+        }
+    }
+    m_ccs_index[slot] = i ;
+    m_window_n[slot]  = 0 ;
+    return true ;
+}
+
+
+std::vector<size_t>
+ngsai::app::WindowArena::sample(size_t n_ccss,
+                                size_t max_ccss,
+                                uint32_t seed)
+{   size_t n_kept = ((max_ccss > 0) and (n_ccss > max_ccss)) ?
+                        max_ccss :
+                        n_ccss ;
+    std::vector<size_t> reservoir(n_kept) ;
+    std::iota(reservoir.begin(), reservoir.end(), 0) ;
+
+    // the same draws as addCcs()
+    std::mt19937 generator(seed) ;
+    for(size_t i=n_kept; i<n_ccss; i++)
+    {   size_t j = generator() % (i + 1) ;
+        if(j < n_kept)
+        {   reservoir[j] = i ; }
+    }
+    std::sort(reservoir.begin(), reservoir.end()) ;
+    return reservoir ;
+}
+
+
+size_t
+ngsai::app::WindowArena::getSlotNumber() const
+{   return m_slot_n ; }
+
+
+size_t
+ngsai::app::WindowArena::getWindowSize() const
+{   return m_window_size ; }
+
+
+const std::vector<size_t>&
+ngsai::app::WindowArena::getOrder()
+{   m_order.resize(m_slot_n) ;
+    std::iota(m_order.begin(), m_order.end(), 0) ;
+    // only a reservoir shuffles the slots
+    if(m_ccs_n > m_slot_n)
+    {   std::sort(m_order.begin(),
+                  m_order.end(),
+                  [this](size_t s1, size_t s2)
+                  {   return m_ccs_index[s1] <
+                             m_ccs_index[s2] ;
+                  }) ;
+    }
+    return m_order ;
+}
+
+
+size_t
+ngsai::app::WindowArena::getWindowNumber(size_t slot) const
+{   return m_window_n[slot] ; }
+
+
+void
+ngsai::app::WindowArena::setWindowNumber(size_t slot,
+                                         size_t n)
+{   m_window_n[slot] = n ; }
+
+
+uint16_t*
+ngsai::app::WindowArena::getIPD(size_t slot,
+                                size_t window)
+{   return m_ipd.data() +
+           (slot * windows_per_ccs + window) * m_window_size ;
+}
+
+
+uint16_t*
+ngsai::app::WindowArena::getPWD(size_t slot,
+                                size_t window)
+{   return m_pwd.data() +
+           (slot * windows_per_ccs + window) * m_window_size ;
+}
+
+
+double&
+ngsai::app::WindowArena::getScoreMeth(size_t slot,
+                                      size_t window)
+{   return m_score_meth[slot * windows_per_ccs + window] ; }
+
+
+double&
+ngsai::app::WindowArena::getScoreUnmeth(size_t slot,
+                                        size_t window)
+{   return m_score_unmeth[slot * windows_per_ccs + window] ; }
+
+
+ngsai::CcsKineticExtractor&
+ngsai::app::WindowArena::getExtractor()
+{   return m_extractor ; }
+
+
+std::vector<uint16_t>&
+ngsai::app::WindowArena::getBatchIPD()
+{   return m_batch_ipd ; }
+
+
+std::vector<uint16_t>&
+ngsai::app::WindowArena::getBatchPWD()
+{   return m_batch_pwd ; }
+
+
+std::vector<int32_t>&
+ngsai::app::WindowArena::getBatchBins()
+{   return m_batch_bins ; }
+
+
+std::vector<double>&
+ngsai::app::WindowArena::getBatchScores()
+{   return m_batch_scores ; }
@@ -0,0 +1,314 @@
+#ifndef NGSAI_APP_WINDOWARENA_HPP
+#define NGSAI_APP_WINDOWARENA_HPP
+
+#include <vector>
+#include <cstdint>
+#include <random>           // std::mt19937
+
+#include <ngsaipp/epigenetics/CcsKineticExtractor.hpp>  // ngsai::CcsKineticExtractor
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief The WindowArena class holds the kinetic
+        * signal windows of the CCSs of a CpG, such that
+        * they can be classified without keeping the CCSs.
+        * Each CCS gets a slot of fixed size holding its
+        * forward and reverse windows and their scores.
+        * The memory is kept from one CpG to the next, such
+        * that a worker thread reusing its arena does not
+        * allocate memory once the largest CpG has been
+        * seen.
+        * The number of slots can be bounded, in which
+        * case the CCSs are subsampled with reservoir
+        * sampling as they are added.
+        */
+        class WindowArena
+        {
+            public:
+                /*!
+                * \brief the maximum number of windows of
+                * a CCS, one per strand.
+                */
+                static const size_t windows_per_ccs ;
+
+            public:
+                /*!
+                * \brief Constructor. Creates an empty
+                * arena.
+                */
+                WindowArena() ;
+
+                /*!
+                * \brief Destructor.
+                */
+                virtual
+                ~WindowArena() ;
+
+                /*!
+                * \brief Empties the arena for a new CpG.
+                * The memory is kept.
+                * \param window_size the size of the
+                * windows.
+                * \param max_ccss the maximum number of
+                * CCSs kept, 0 for no limit.
+                * \param seed the seed of the reservoir
+                * sampling random generator.
+                */
+                void
+                reset(size_t window_size,
+                      size_t max_ccss,
+                      uint32_t seed) ;
+
+                /*!
+                * \brief Gets a slot for the next CCS. If
+                * the number of CCSs is bounded, the CCS
+                * may replace a previous one or not be
+                * kept at all.
+                * \param slot where the index of the slot
+                * is written. The slot is emptied.
+                * \return whether the CCS is kept.
+                */
+                bool
+                addCcs(size_t& slot) ;
+
+                /*!
+                * \brief Returns the CCSs that reset() and
+                * addCcs() would keep out of a number of
+                * CCSs, for CCSs that are not added to an
+                * arena. The draws are the same, such that
+                * both keep the same CCSs.
+                * \param n_ccss the number of CCSs.
+                * \param max_ccss the maximum number of
+                * CCSs kept, 0 for no limit.
+                * \param seed the seed of the reservoir
+                * sampling random generator.
+                * \return the indices of the CCSs kept,
+                * in increasing order.
+                */
+                static
+                std::vector<size_t>
+                sample(size_t n_ccss,
+                       size_t max_ccss,
+                       uint32_t seed) ;
+
+                /*!
+                * \brief Returns the number of slots in
+                * use.
+                * \return the number of slots.
+                */
+                size_t
+                getSlotNumber() const ;
+
+                /*!
+                * \brief Returns the size of the windows.
+                * \return the window size.
+                */
+                size_t
+                getWindowSize() const ;
+
+                /*!
+                * \brief Returns the slots sorted by the
+                * order in which their CCSs were added.
+                * \return the slot indices.
+                */
+                const std::vector<size_t>&
+                getOrder() ;
+
+                /*!
+                * \brief Returns the number of windows
+                * stored in a slot.
+                * \param slot the slot index.
+                * \return the number of windows.
+                */
+                size_t
+                getWindowNumber(size_t slot) const ;
+
+                /*!
+                * \brief Sets the number of windows
+                * stored in a slot.
+                * \param slot the slot index.
+                * \param n the number of windows.
+                */
+                void
+                setWindowNumber(size_t slot, size_t n) ;
+
+                /*!
+                * \brief Returns the IPD signal buffer of
+                * a window.
+                * \param slot the slot index.
+                * \param window the window index in the
+                * slot.
+                * \return the address of the buffer, it
+                * has room for getWindowSize() values.
+                */
+                uint16_t*
+                getIPD(size_t slot, size_t window) ;
+
+                /*!
+                * \brief Returns the PWD signal buffer of
+                * a window.
+                * \param slot the slot index.
+                * \param window the window index in the
+                * slot.
+                * \return the address of the buffer, it
+                * has room for getWindowSize() values.
+                */
+                uint16_t*
+                getPWD(size_t slot, size_t window) ;
+
+                /*!
+                * \brief Returns the score of a window
+                * under the methylated model, or its log
+                * likelihood ratio.
+                * \param slot the slot index.
+                * \param window the window index in the
+                * slot.
+                * \return a reference to the score.
+                */
+                double&
+                getScoreMeth(size_t slot, size_t window) ;
+
+                /*!
+                * \brief Returns the score of a window
+                * under the unmethylated model.
+                * \param slot the slot index.
+                * \param window the window index in the
+                * slot.
+                * \return a reference to the score.
+                */
+                double&
+                getScoreUnmeth(size_t slot, size_t window) ;
+
+                /*!
+                * \brief Returns the extractor used to
+                * read the windows from the CCSs.
+                * \return the extractor.
+                */
+                ngsai::CcsKineticExtractor&
+                getExtractor() ;
+
+                /*!
+                * \brief Returns the buffer in which the
+                * IPD signal of the windows is laid out
+                * for KineticKernel::score().
+                * \return the buffer.
+                */
+                std::vector<uint16_t>&
+                getBatchIPD() ;
+
+                /*!
+                * \brief Returns the buffer in which the
+                * PWD signal of the windows is laid out
+                * for KineticKernel::score().
+                * \return the buffer.
+                */
+                std::vector<uint16_t>&
+                getBatchPWD() ;
+
+                /*!
+                * \brief Returns the bin buffer used by
+                * KineticKernel::score().
+                * \return the buffer.
+                */
+                std::vector<int32_t>&
+                getBatchBins() ;
+
+                /*!
+                * \brief Returns the buffer in which
+                * KineticKernel::score() writes the
+                * window scores.
+                * \return the buffer.
+                */
+                std::vector<double>&
+                getBatchScores() ;
+
+            protected:
+                /*!
+                * \brief the window size.
+                */
+                size_t m_window_size ;
+                /*!
+                * \brief the maximum number of CCSs kept,
+                * 0 for no limit.
+                */
+                size_t m_max_ccss ;
+                /*!
+                * \brief the number of CCSs added so far.
+                */
+                size_t m_ccs_n ;
+                /*!
+                * \brief the number of slots in use.
+                */
+                size_t m_slot_n ;
+                /*!
+                * \brief the reservoir sampling random
+                * generator.
+                */
+                std::mt19937 m_generator ;
+                /*!
+                * \brief the index of the CCS in each
+                * slot, in the order they were added.
+                */
+                std::vector<size_t> m_ccs_index ;
+                /*!
+                * \brief the number of windows in each
+                * slot.
+                */
+                std::vector<size_t> m_window_n ;
+                /*!
+                * \brief the IPD signal of the windows,
+                * slot after slot.
+                */
+                std::vector<uint16_t> m_ipd ;
+                /*!
+                * \brief the PWD signal of the windows,
+                * slot after slot.
+                */
+                std::vector<uint16_t> m_pwd ;
+                /*!
+                * \brief the methylated, or ratio, scores
+                * of the windows.
+                */
+                std::vector<double> m_score_meth ;
+                /*!
+                * \brief the unmethylated scores of the
+                * windows.
+                */
+                std::vector<double> m_score_unmeth ;
+                /*!
+                * \brief the slots in CCS order.
+                */
+                std::vector<size_t> m_order ;
+                /*!
+                * \brief the kinetic signal extractor.
+                */
+                ngsai::CcsKineticExtractor m_extractor ;
+                /*!
+                * \brief the IPD signal of the windows,
+                * position major.
+                */
+                std::vector<uint16_t> m_batch_ipd ;
+                /*!
+                * \brief the PWD signal of the windows,
+                * position major.
+                */
+                std::vector<uint16_t> m_batch_pwd ;
+                /*!
+                * \brief the bins of the windows.
+                */
+                std::vector<int32_t> m_batch_bins ;
+                /*!
+                * \brief the scores of the windows.
+                */
+                std::vector<double> m_batch_scores ;
+        } ;
+
+    }  // namespace app
+
+}  // namespace ngsai
+
+#endif  // NGSAI_APP_WINDOWARENA_HPP
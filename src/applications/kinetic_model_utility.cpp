@@ -0,0 +1,323 @@
+#include <applications/kinetic_model_utility.hpp>
+
+#include <utility>          // std::make_pair()
+#include <typeinfo>         // typeid
+#include <stdexcept>        // std::invalid_argument
+#include <memory>           // std::unique_ptr
+#include <string>
+#include <sstream>          // std::ostringstream
+#include <boost/archive/text_oarchive.hpp>  // boost::archive::text_oarchive
+
+#include <ngsaipp/utility/string_utility.hpp>                        // ngsai::endswith()
+
+#include <ngsaipp/epigenetics/RawKineticModel.hpp>                   // ngsai::RawKineticModel
+#include <ngsaipp/epigenetics/NormalizedKineticModel.hpp>            // ngsai::NormalizedKineticModel
+#include <ngsaipp/epigenetics/DiPositionKineticModel.hpp>            // ngsai::DiPositionKineticModel
+#include <ngsaipp/epigenetics/DiPositionNormalizedKineticModel.hpp>  // ngsai::DiPositionNormalizedKineticModel
+#include <ngsaipp/epigenetics/PairWiseKineticModel.hpp>              // ngsai::PairWiseKineticModel
+#include <ngsaipp/epigenetics/PairWiseNormalizedKineticModel.hpp>    // ngsai::PairWiseNormalizedKineticModel
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief Checks whether two models of the same
+        * type have the same histograms binnings.
+        * \param model_a the first model.
+        * \param model_b the second model.
+        * \return whether the binnings are the same.
+        * \throw std::invalid_argument if the model type
+        * does not give access to its histograms.
+        */
+        template<class M>
+        bool
+        have_same_binnings(const M& model_a,
+                           const M& model_b)
+        {   if constexpr(not has_histograms<M>::value)
+            {   throw std::invalid_argument(
+                            "have_same_parameters() error! the "
+                            "histograms of this kinetic model "
+                            "type are not accessible") ;
+            }
+            else
+            {   for(const auto& hists : 
+                    {std::make_pair(&(model_a.getHistogramsIPD()),
+                                    &(model_b.getHistogramsIPD())),
+                     std::make_pair(&(model_a.getHistogramsPWD()),
+                                    &(model_b.getHistogramsPWD()))})
+                {   if(hists.first->size() != hists.second->size())
+                    {   return false ; }
+                    for(size_t i=0; i<hists.first->size(); i++)
+                    {   const auto& hist_a = (*hists.first)[i] ;
+                        const auto& hist_b = (*hists.second)[i] ;
+                        if((hist_a.getBinNumber() != 
+                                hist_b.getBinNumber()) or
+                           (hist_a.getLowerBound() != 
+                                hist_b.getLowerBound()) or
+                           (hist_a.getUpperBound() != 
+                                hist_b.getUpperBound()))
+                        {   return false ; }
+                    }
+                }
+                return true ;
+            }
+        }
+
+        /*!
+        * \brief Checks whether a model has at least one
+        * bin without any count.
+        * \param model the model.
+        * \return whether a bin is empty.
+        * \throw std::invalid_argument if the model type
+        * does not give access to its histograms.
+        */
+        template<class M>
+        bool
+        contains_empty_bin(const M& model)
+        {   if constexpr(not has_histograms<M>::value)
+            {   throw std::invalid_argument(
+                            "has_empty_bin() error! the "
+                            "histograms of this kinetic model "
+                            "type are not accessible") ;
+            }
+            else
+            {   for(const auto* hists : {&(model.getHistogramsIPD()),
+                                         &(model.getHistogramsPWD())})
+                {   for(const auto& hist : *hists)
+                    {   for(double count : hist.getCounts())
+                        {   if(count == 0.)
+                            {   return true ; }
+                        }
+                    }
+                }
+                return false ;
+            }
+        }
+
+        /*!
+        * \brief Sets the parameters of a model to those
+        * of another model of the same type.
+        * \param model the model to set.
+        * \param other the model to copy the parameters
+        * of.
+        * \param pseudo_counts a number of counts in each
+        * bin.
+        * \return the model.
+        * \throw std::invalid_argument if the model type
+        * does not give access to its histograms.
+        */
+        template<class M>
+        M*
+        set_parameters_like(M* model,
+                            const M& other,
+                            double pseudo_counts)
+        {   std::unique_ptr<M> ptr(model) ;
+            if constexpr(not has_histograms<M>::value)
+            {   throw std::invalid_argument(
+                            "new_empty_model() error! the "
+                            "histograms of this kinetic model "
+                            "type are not accessible") ;
+            }
+            else
+            {   const auto& hist = other.getHistogramsIPD().front() ;
+                ptr->setParameters(other.size(),
+                                   hist.getLowerBound(),
+                                   hist.getUpperBound(),
+                                   hist.getBinNumber(),
+                                   pseudo_counts) ;
+                return ptr.release() ;
+            }
+        }
+
+    }  // namespace app
+
+}  // namespace ngsai
+
+
+bool
+ngsai::app::are_equal(const ngsai::KmerMap& map_a,
+                      const ngsai::KmerMap& map_b)
+{   std::ostringstream stream_a ;
+    std::ostringstream stream_b ;
+    {   boost::archive::text_oarchive arch_a(stream_a) ;
+        boost::archive::text_oarchive arch_b(stream_b) ;
+        arch_a << map_a ;
+        arch_b << map_b ;
+    }
+    return stream_a.str() == stream_b.str() ;
+}
+
+
+bool
+ngsai::app::have_same_parameters(
+                        const ngsai::KineticModel& model_a,
+                        const ngsai::KineticModel& model_b)
+{   // the dynamic types must match exactly in case the 
+    // normalized types derive from the raw signal types
+    if(typeid(model_a) != typeid(model_b))
+    {   return false ; }
+
+    if(auto m = dynamic_cast<
+        const ngsai::NormalizedKineticModel*>(&model_a))
+    {   const auto& m_b = dynamic_cast<
+                const ngsai::NormalizedKineticModel&>(model_b) ;
+        // the signals must be normalized the same way
+        return have_same_binnings(*m, m_b) and
+               are_equal(get_kmermap(*m), get_kmermap(m_b)) ;
+    }
+    else if(auto m = dynamic_cast<
+        const ngsai::DiPositionNormalizedKineticModel*>(&model_a))
+    {   const auto& m_b = dynamic_cast<
+                const ngsai::DiPositionNormalizedKineticModel&>(model_b) ;
+        // the signals must be normalized the same way
+        return have_same_binnings(*m, m_b) and
+               are_equal(get_kmermap(*m), get_kmermap(m_b)) ;
+    }
+    else if(auto m = dynamic_cast<
+        const ngsai::PairWiseNormalizedKineticModel*>(&model_a))
+    {   const auto& m_b = dynamic_cast<
+                const ngsai::PairWiseNormalizedKineticModel&>(model_b) ;
+        // the signals must be normalized the same way
+        return have_same_binnings(*m, m_b) and
+               are_equal(get_kmermap(*m), get_kmermap(m_b)) ;
+    }
+    else if(auto m = dynamic_cast<
+        const ngsai::RawKineticModel*>(&model_a))
+    {   return have_same_binnings(
+                *m,
+                dynamic_cast<const ngsai::RawKineticModel&>(
+                                                        model_b)) ;
+    }
+    else if(auto m = dynamic_cast<
+        const ngsai::DiPositionKineticModel*>(&model_a))
+    {   return have_same_binnings(
+                *m,
+                dynamic_cast<const ngsai::DiPositionKineticModel&>(
+                                                        model_b)) ;
+    }
+    else if(auto m = dynamic_cast<
+        const ngsai::PairWiseKineticModel*>(&model_a))
+    {   return have_same_binnings(
+                *m,
+                dynamic_cast<const ngsai::PairWiseKineticModel&>(
+                                                        model_b)) ;
+    }
+
+    throw std::invalid_argument("have_same_parameters() error! "
+                                "unknown kinetic model type") ;
+}
+
+
+ngsai::KineticModel*
+ngsai::app::new_empty_model(const ngsai::KineticModel& model,
+                            double pseudo_counts)
+{   if(not model.isInit())
+    {   throw std::invalid_argument("new_empty_model() error! "
+                                    "model is not "
+                                    "initialised") ;
+    }
+
+    // normalized types first in case they derive from
+    // the raw signal types
+    if(auto m = dynamic_cast<
+        const ngsai::NormalizedKineticModel*>(&model))
+    {   return set_parameters_like(
+                new ngsai::NormalizedKineticModel(get_kmermap(*m)),
+                *m,
+                pseudo_counts) ;
+    }
+    else if(auto m = dynamic_cast<
+        const ngsai::DiPositionNormalizedKineticModel*>(&model))
+    {   return set_parameters_like(
+                new ngsai::DiPositionNormalizedKineticModel(
+                                            get_kmermap(*m)),
+                *m,
+                pseudo_counts) ;
+    }
+    else if(auto m = dynamic_cast<
+        const ngsai::PairWiseNormalizedKineticModel*>(&model))
+    {   return set_parameters_like(
+                new ngsai::PairWiseNormalizedKineticModel(
+                                            get_kmermap(*m)),
+                *m,
+                pseudo_counts) ;
+    }
+    else if(auto m = dynamic_cast<
+        const ngsai::RawKineticModel*>(&model))
+    {   return set_parameters_like(
+                new ngsai::RawKineticModel(),
+                *m,
+                pseudo_counts) ;
+    }
+    else if(auto m = dynamic_cast<
+        const ngsai::DiPositionKineticModel*>(&model))
+    {   return set_parameters_like(
+                new ngsai::DiPositionKineticModel(),
+                *m,
+                pseudo_counts) ;
+    }
+    else if(auto m = dynamic_cast<
+        const ngsai::PairWiseKineticModel*>(&model))
+    {   return set_parameters_like(
+                new ngsai::PairWiseKineticModel(),
+                *m,
+                pseudo_counts) ;
+    }
+
+    throw std::invalid_argument("new_empty_model() error! "
+                                "unknown kinetic model type") ;
+}
+
+
+bool
+ngsai::app::has_empty_bin(const ngsai::KineticModel& model)
+{   if(auto m = dynamic_cast<
+        const ngsai::NormalizedKineticModel*>(&model))
+    {   return contains_empty_bin(*m) ; }
+    else if(auto m = dynamic_cast<
+        const ngsai::DiPositionNormalizedKineticModel*>(&model))
+    {   return contains_empty_bin(*m) ; }
+    else if(auto m = dynamic_cast<
+        const ngsai::PairWiseNormalizedKineticModel*>(&model))
+    {   return contains_empty_bin(*m) ; }
+    else if(auto m = dynamic_cast<
+        const ngsai::RawKineticModel*>(&model))
+    {   return contains_empty_bin(*m) ; }
+    else if(auto m = dynamic_cast<
+        const ngsai::DiPositionKineticModel*>(&model))
+    {   return contains_empty_bin(*m) ; }
+    else if(auto m = dynamic_cast<
+        const ngsai::PairWiseKineticModel*>(&model))
+    {   return contains_empty_bin(*m) ; }
+
+    throw std::invalid_argument("has_empty_bin() error! "
+                                "unknown kinetic model type") ;
+}
+
+
+ngsai::KineticModel*
+ngsai::app::load_kinetic_model(const std::string& path)
+{   std::unique_ptr<ngsai::KineticModel> model ;
+    if(ngsai::endswith(path, ".rawkineticmodel"))
+    {   model.reset(new ngsai::RawKineticModel()) ; }
+    else if(ngsai::endswith(path, ".normalizedkineticmodel"))
+    {   model.reset(new ngsai::NormalizedKineticModel()) ; }
+    else if(ngsai::endswith(path, ".pairwisekineticmodel"))
+    {   model.reset(new ngsai::PairWiseKineticModel()) ; }
+    else if(ngsai::endswith(path, 
+                            ".pairwisenormalizedkineticmodel"))
+    {   model.reset(new ngsai::PairWiseNormalizedKineticModel()) ; }
+    else if(ngsai::endswith(path, ".dipositionkineticmodel"))
+    {   model.reset(new ngsai::DiPositionKineticModel()) ; }
+    else if(ngsai::endswith(path, 
+                            ".dipositionnormalizedkineticmodel"))
+    {   model.reset(
+            new ngsai::DiPositionNormalizedKineticModel()) ;
+    }
+    else
+    {   return nullptr ; }
+    model->load(path) ;
+    return model.release() ;
+}
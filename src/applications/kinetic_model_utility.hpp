@@ -0,0 +1,172 @@
+#ifndef NGSAI_APP_KINETIC_MODEL_UTILITY_HPP
+#define NGSAI_APP_KINETIC_MODEL_UTILITY_HPP
+
+#include <string>
+#include <stdexcept>          // std::invalid_argument
+#include <type_traits>        // std::void_t, std::false_type, std::is_convertible
+#include <utility>            // std::declval()
+
+#include <ngsaipp/epigenetics/KineticModel.hpp>  // ngsai::KineticModel
+#include <ngsaipp/epigenetics/KmerMap.hpp>       // ngsai::KmerMap
+
+
+namespace ngsai
+{
+    namespace app
+    {
+        /*!
+        * \brief Whether a kinetic model type gives access
+        * to its IPD and PWD histograms, as vectors of
+        * histograms with a number of bins, bounds and a
+        * flat vector of counts. Comparing models and
+        * compiling them into tables read the models
+        * through these accessors only, the functions
+        * doing so throw for the types without them
+        * instead of failing to compile.
+        */
+        template<class M, class = void>
+        struct has_histograms : std::false_type
+        {} ;
+
+        template<class M>
+        struct has_histograms<M,
+                std::void_t<
+                    decltype(std::declval<const M&>().size()),
+                    decltype(std::declval<const M&>().
+                                getHistogramsIPD().front().
+                                    getBinNumber()),
+                    decltype(std::declval<const M&>().
+                                getHistogramsIPD().front().
+                                    getLowerBound()),
+                    decltype(std::declval<const M&>().
+                                getHistogramsIPD().front().
+                                    getUpperBound()),
+                    decltype(*(std::declval<const M&>().
+                                getHistogramsIPD().front().
+                                    getCounts().begin())),
+                    decltype(std::declval<const M&>().
+                                getHistogramsPWD().front().
+                                    getCounts())>> :
+            std::is_convertible<
+                    decltype(*(std::declval<const M&>().
+                                getHistogramsIPD().front().
+                                    getCounts().begin())),
+                    double>
+        {} ;
+
+        /*!
+        * \brief Whether a normalized kinetic model type
+        * gives access to its KmerMap.
+        */
+        template<class M, class = void>
+        struct has_kmermap : std::false_type
+        {} ;
+
+        template<class M>
+        struct has_kmermap<M,
+                std::void_t<decltype(
+                    std::declval<const M&>().getKmerMap())>> :
+            std::true_type
+        {} ;
+
+        /*!
+        * \brief Returns the KmerMap of a normalized
+        * kinetic model.
+        * \param model the model.
+        * \return the KmerMap.
+        * \throw std::invalid_argument if the model type
+        * does not give access to its KmerMap.
+        */
+        template<class M>
+        const ngsai::KmerMap&
+        get_kmermap(const M& model)
+        {   if constexpr(has_kmermap<M>::value)
+            {   return model.getKmerMap() ; }
+            else
+            {   throw std::invalid_argument(
+                        "get_kmermap() error! the KmerMap of "
+                        "this kinetic model type is not "
+                        "accessible") ;
+            }
+        }
+
+        /*!
+        * \brief Checks whether two KmerMaps contain the
+        * same values, by comparing their serialized
+        * forms.
+        * \param map_a the first KmerMap.
+        * \param map_b the second KmerMap.
+        * \return whether the KmerMaps are equal.
+        */
+        bool
+        are_equal(const ngsai::KmerMap& map_a,
+                  const ngsai::KmerMap& map_b) ;
+
+        /*!
+        * \brief Checks whether two histogram based
+        * kinetic models can be summed, that is whether
+        * they have the same type and the same number of
+        * histograms, each with the same bins, and, for
+        * normalized models, the same KmerMap.
+        * \param model_a the first model.
+        * \param model_b the second model.
+        * \return whether the models have the same
+        * parameters.
+        * \throw std::invalid_argument if the type of the
+        * models is not known or if it does not give
+        * access to its histograms.
+        */
+        bool
+        have_same_parameters(const ngsai::KineticModel& model_a,
+                             const ngsai::KineticModel& model_b) ;
+
+        /*!
+        * \brief Creates a histogram based kinetic model
+        * with the type, size, binning and KmerMap of
+        * another one, in which all the counts are the
+        * pseudo counts.
+        * \param model the model to copy the parameters
+        * of.
+        * \param pseudo_counts a number of counts in each
+        * bin.
+        * \return the new model, which the caller owns.
+        * \throw std::invalid_argument if the type of the
+        * model is not known, if it does not give access
+        * to its histograms or if the model is not
+        * initialised.
+        */
+        ngsai::KineticModel*
+        new_empty_model(const ngsai::KineticModel& model,
+                        double pseudo_counts) ;
+
+        /*!
+        * \brief Checks whether a histogram based kinetic
+        * model has at least one bin without any count.
+        * A model trained with pseudo counts has none.
+        * \param model the model, containing counts.
+        * \return whether a bin is empty.
+        * \throw std::invalid_argument if the type of the
+        * model is not known or if it does not give
+        * access to its histograms.
+        */
+        bool
+        has_empty_bin(const ngsai::KineticModel& model) ;
+
+        /*!
+        * \brief Loads a serialized kinetic model, whose
+        * type is given by the file extension.
+        * \param path the path to the file.
+        * \return the model, which the caller owns, or
+        * nullptr if the extension is not the one of a
+        * kinetic model.
+        * \throw the exceptions of the model
+        * deserialization.
+        */
+        ngsai::KineticModel*
+        load_kinetic_model(const std::string& path) ;
+
+    }  // namespace app
+
+}  // namespace ngsai
+
+#endif  // NGSAI_APP_KINETIC_MODEL_UTILITY_HPP
@@ -1,6 +1,10 @@
 #ifndef NGSAI_APP_UTILITIES_HPP
 #define NGSAI_APP_UTILITIES_HPP
 
+#include <iostream>
+#include <vector>
+#include <algorithm>            // std::stable_sort(), std::remove_if()
+
 namespace ngsai
 {
     namespace app
@@ -30,6 +34,63 @@ namespace ngsai
             return stream ;
         }
 
+        /*!
+        * \brief Sorts records fetched over several CpGs at 
+        * once by their start on the reference. The sort is 
+        * stable, records starting at the same position thus 
+        * keep the order in which the reader returned them, 
+        * which is the order a fetch over a single CpG sees 
+        * them in. This keeps the CCSs subsampled for a CpG 
+        * (--maxDepth) independent of the fetch grouping.
+        * \param records the records of interest, any type 
+        * with a ReferenceStart() method.
+        */
+        template<class T>
+        void sort_by_start(std::vector<T>& records)
+        {   std::stable_sort(records.begin(),
+                             records.end(),
+                             [](const T& r1, const T& r2)
+                             {   return r1.ReferenceStart() < 
+                                        r2.ReferenceStart() ;
+                             }) ;
+        }
+
+        /*!
+        * \brief Advances a sweep over records sorted with 
+        * sort_by_start() to the region [start,end). The 
+        * records starting before end are added to the active 
+        * ones and those ending before start are removed, the 
+        * active records remaining in the records order.
+        * Successive regions must have non-decreasing ends.
+        * \param records the sorted records.
+        * \param start the region start.
+        * \param end the region end.
+        * \param next the index of the next record to 
+        * activate, updated.
+        * \param active the indices of the active records, 
+        * updated to those overlapping the region.
+        */
+        template<class T, class P>
+        void sweep_records(const std::vector<T>& records,
+                           P start,
+                           P end,
+                           size_t& next,
+                           std::vector<size_t>& active)
+        {   while((next < records.size()) and
+                  (records[next].ReferenceStart() < end))
+            {   active.push_back(next) ; 
+                next++ ;
+            }
+            active.erase(
+                std::remove_if(active.begin(),
+                               active.end(),
+                               [&records, start](size_t j)
+                               {   return records[j].
+                                        ReferenceEnd() <= start ;
+                               }),
+                active.end()) ;
+        }
+
     }  // namespace app
     
 }  // namespace ngsai
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <filesystem>           // std::filesystem::temp_directory_path()
+#include <stdexcept>            // std::invalid_argument, std::runtime_error
+
+#include <applications/ApplicationPredictMerge.hpp>
+
+
+// writes a shard in the temporary directory and 
+// returns its path
+static
+std::string
+write_shard(const std::string& name,
+            const std::string& contents)
+{   std::string path = (std::filesystem::temp_directory_path() /
+                        ("papet_unittests_" + name + ".bed")).string() ;
+    std::ofstream file(path) ;
+    file << contents ;
+    return path ;
+}
+
+
+// merges the shards and returns the result
+static
+std::string
+merge(const std::vector<std::string>& paths)
+{   std::ostringstream stream ;
+    ngsai::app::ApplicationPredictMerge::mergeShards(paths, 
+                                                     stream) ;
+    return stream.str() ;
+}
+
+
+// the shards are concatenated in shard order whatever 
+// the order they are given in, karyotypic orders are 
+// kept, chr2 before chr10
+TEST(ApplicationPredictMergeTest, shard_order)
+{   std::string path1 = write_shard("shard1",
+                                    "# shard 1/2\n"
+                                    "chr1\t10\t12\t.\t0.5\t.\n"
+                                    "chr2\t5\t7\t.\t0.1\t.\n") ;
+    std::string path2 = write_shard("shard2",
+                                    "# shard 2/2\n"
+                                    "chr2\t20\t22\t.\t0.9\t.\n"
+                                    "\n"
+                                    "chr10\t3\t5\t.\t0.2\t.\n") ;
+    std::string merged = "chr1\t10\t12\t.\t0.5\t.\n"
+                         "chr2\t5\t7\t.\t0.1\t.\n"
+                         "chr2\t20\t22\t.\t0.9\t.\n"
+                         "chr10\t3\t5\t.\t0.2\t.\n" ;
+    EXPECT_EQ(merge({path1, path2}), merged) ;
+    EXPECT_EQ(merge({path2, path1}), merged) ;
+    std::filesystem::remove(path1) ;
+    std::filesystem::remove(path2) ;
+}
+
+
+// the lines of a shard are not required to be sorted, 
+// an empty shard is valid
+TEST(ApplicationPredictMergeTest, unsorted)
+{   std::string path1 = write_shard("shard1",
+                                    "# shard 1/2\n"
+                                    "chr2\t20\t22\t.\t0.9\t.\n"
+                                    "chr1\t10\t12\t.\t0.5\t.\n"
+                                    "chr2\t5\t7\t.\t0.1\t.\n") ;
+    std::string path2 = write_shard("shard2",
+                                    "# shard 2/2\n") ;
+    EXPECT_EQ(merge({path2, path1}),
+              "chr2\t20\t22\t.\t0.9\t.\n"
+              "chr1\t10\t12\t.\t0.5\t.\n"
+              "chr2\t5\t7\t.\t0.1\t.\n") ;
+    std::filesystem::remove(path1) ;
+    std::filesystem::remove(path2) ;
+}
+
+
+// each shard 1..N must be given exactly once
+TEST(ApplicationPredictMergeTest, shard_set)
+{   std::string path1 = write_shard("shard1", "# shard 1/3\n") ;
+    std::string path2 = write_shard("shard2", "# shard 2/3\n") ;
+    std::string path3 = write_shard("shard3", "# shard 3/3\n") ;
+    std::string path4 = write_shard("shard4", "# shard 2/4\n") ;
+    // shard 2 is missing
+    EXPECT_THROW(merge({path1, path3}), std::invalid_argument) ;
+    // shard 1 is given twice
+    EXPECT_THROW(merge({path1, path2, path3, path1}), 
+                 std::invalid_argument) ;
+    // shards of different runs
+    EXPECT_THROW(merge({path1, path4, path3}), 
+                 std::invalid_argument) ;
+    EXPECT_NO_THROW(merge({path3, path1, path2})) ;
+    std::filesystem::remove(path1) ;
+    std::filesystem::remove(path2) ;
+    std::filesystem::remove(path3) ;
+    std::filesystem::remove(path4) ;
+}
+
+
+// files without a valid shard line and missing files 
+// are errors
+TEST(ApplicationPredictMergeTest, errors)
+{   for(const std::string& contents : 
+            {std::string("chr1\t10\t12\t.\t0.5\t.\n"),
+             std::string("# shard 0/2\n"),
+             std::string("# shard 3/2\n"),
+             std::string("# shard 1\n"),
+             std::string("# shard a/b\n"),
+             std::string("")})
+    {   std::string path = write_shard("shard1", contents) ;
+        EXPECT_THROW(merge({path}), std::invalid_argument) ;
+        std::filesystem::remove(path) ;
+    }
+    std::string path = write_shard("shard1", "# shard 1/1\n") ;
+    std::filesystem::remove(path) ;
+    EXPECT_THROW(merge({path}), std::runtime_error) ;
+}
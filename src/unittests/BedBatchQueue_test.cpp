@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <algorithm>            // std::sort()
+#include <stdexcept>            // std::invalid_argument
+
+#include <applications/BedBatchQueue.hpp>
+
+
+// a batch of a given index with one unlabelled record
+static
+ngsai::app::BedBatch
+make_batch(size_t index)
+{   ngsai::app::BedBatch batch ;
+    batch.index = index ;
+    batch.records.resize(1) ;
+    batch.labels.assign(1, 0) ;
+    return batch ;
+}
+
+
+// the batches are popped in their push order
+TEST(BedBatchQueueTest, push_pop)
+{   ngsai::app::BedBatchQueue queue(4) ;
+    for(size_t i=0; i<3; i++)
+    {   queue.push(make_batch(i)) ; }
+
+    ngsai::app::BedBatch batch ;
+    for(size_t i=0; i<3; i++)
+    {   ASSERT_TRUE(queue.pop(batch)) ;
+        EXPECT_EQ(batch.index, i) ;
+        EXPECT_EQ(batch.records.size(), 1) ;
+        EXPECT_EQ(batch.labels.size(), 1) ;
+    }
+}
+
+
+// the remaining batches are still popped after the
+// queue is closed, and then none
+TEST(BedBatchQueueTest, close)
+{   ngsai::app::BedBatchQueue queue(2) ;
+    queue.push(make_batch(0)) ;
+    queue.close() ;
+
+    ngsai::app::BedBatch batch ;
+    ASSERT_TRUE(queue.pop(batch)) ;
+    EXPECT_EQ(batch.index, 0) ;
+    EXPECT_FALSE(queue.pop(batch)) ;
+    EXPECT_FALSE(queue.pop(batch)) ;
+}
+
+
+// the workers waiting on an empty queue stop when it
+// is closed
+TEST(BedBatchQueueTest, close_waiting)
+{   ngsai::app::BedBatchQueue queue(1) ;
+    std::vector<std::thread> threads ;
+    std::vector<int> popped(3, -1) ;
+    for(size_t t=0; t<popped.size(); t++)
+    {   threads.emplace_back(
+            [&queue, &popped, t]()
+            {   ngsai::app::BedBatch batch ;
+                popped[t] = queue.pop(batch) ;
+            }) ;
+    }
+    queue.close() ;
+    for(auto& thread : threads)
+    {   thread.join() ; }
+    for(int p : popped)
+    {   EXPECT_EQ(p, 0) ; }
+}
+
+
+// a reader pushing more batches than the capacity
+// and several workers, each batch is popped once
+TEST(BedBatchQueueTest, push_threads)
+{   size_t n_threads = 4 ;
+    size_t n_batches = 1000 ;
+    ngsai::app::BedBatchQueue queue(2) ;
+
+    std::mutex mutex ;
+    std::vector<size_t> indices ;
+    std::vector<std::thread> threads ;
+    for(size_t t=0; t<n_threads; t++)
+    {   threads.emplace_back(
+            [&queue, &mutex, &indices]()
+            {   ngsai::app::BedBatch batch ;
+                while(queue.pop(batch))
+                {   std::lock_guard<std::mutex> lock(mutex) ;
+                    indices.push_back(batch.index) ;
+                }
+            }) ;
+    }
+    for(size_t i=0; i<n_batches; i++)
+    {   queue.push(make_batch(i)) ; }
+    queue.close() ;
+    for(auto& thread : threads)
+    {   thread.join() ; }
+
+    ASSERT_EQ(indices.size(), n_batches) ;
+    std::sort(indices.begin(), indices.end()) ;
+    for(size_t i=0; i<n_batches; i++)
+    {   EXPECT_EQ(indices[i], i) ; }
+}
+
+
+// a capacity of 0 is refused
+TEST(BedBatchQueueTest, constructor_capacity)
+{   EXPECT_THROW(ngsai::app::BedBatchQueue(0),
+                 std::invalid_argument) ;
+}
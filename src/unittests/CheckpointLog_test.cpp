@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <filesystem>           // std::filesystem::temp_directory_path()
+#include <stdexcept>            // std::runtime_error
+
+#include <applications/CheckpointLog.hpp>
+
+
+// a path in the temporary directory
+static
+std::string
+make_path(const std::string& name)
+{   return (std::filesystem::temp_directory_path() /
+            ("papet_unittests_" + name + ".ckpt")).string() ;
+}
+
+
+// the whole content of a file
+static
+std::string
+read_file(const std::string& path)
+{   std::ifstream file(path) ;
+    std::ostringstream contents ;
+    contents << file.rdbuf() ;
+    return contents.str() ;
+}
+
+
+// a new log only contains the header and its entries
+TEST(CheckpointLogTest, append)
+{   std::string path = make_path("append") ;
+    {   ngsai::app::CheckpointLog log(path, "run", false) ;
+        EXPECT_EQ(log.getEntries().size(), 0) ;
+        log.append("1 10") ;
+        log.append("2 20") ;
+    }
+    EXPECT_EQ(read_file(path), "run\n1 10\n2 20\n") ;
+    std::filesystem::remove(path) ;
+}
+
+
+// resuming reads the entries and appends after them
+TEST(CheckpointLogTest, resume)
+{   std::string path = make_path("resume") ;
+    {   ngsai::app::CheckpointLog log(path, "run", false) ;
+        log.append("1 10") ;
+    }
+    {   ngsai::app::CheckpointLog log(path, "run", true) ;
+        EXPECT_EQ(log.getEntries(), 
+                  std::vector<std::string>({"1 10"})) ;
+        log.append("2 20") ;
+    }
+    EXPECT_EQ(read_file(path), "run\n1 10\n2 20\n") ;
+
+    // without resume, the log starts over
+    {   ngsai::app::CheckpointLog log(path, "run", false) ;
+        EXPECT_EQ(log.getEntries().size(), 0) ;
+    }
+    EXPECT_EQ(read_file(path), "run\n") ;
+    std::filesystem::remove(path) ;
+}
+
+
+// an incomplete last line is dropped
+TEST(CheckpointLogTest, resume_incomplete)
+{   std::string path = make_path("incomplete") ;
+    {   std::ofstream file(path) ;
+        file << "run\n1 10\n2 2" ;
+    }
+    {   ngsai::app::CheckpointLog log(path, "run", true) ;
+        EXPECT_EQ(log.getEntries(), 
+                  std::vector<std::string>({"1 10"})) ;
+        log.append("2 20") ;
+    }
+    EXPECT_EQ(read_file(path), "run\n1 10\n2 20\n") ;
+
+    // an incomplete header starts a new log
+    {   std::ofstream file(path) ;
+        file << "ru" ;
+    }
+    {   ngsai::app::CheckpointLog log(path, "run", true) ;
+        EXPECT_EQ(log.getEntries().size(), 0) ;
+    }
+    EXPECT_EQ(read_file(path), "run\n") ;
+    std::filesystem::remove(path) ;
+}
+
+
+// a log cannot be resumed by another run
+TEST(CheckpointLogTest, resume_other)
+{   std::string path = make_path("other") ;
+    {   ngsai::app::CheckpointLog log(path, "run 1", false) ;
+        log.append("1 10") ;
+    }
+    EXPECT_THROW(ngsai::app::CheckpointLog(path, "run 2", true),
+                 std::runtime_error) ;
+    std::filesystem::remove(path) ;
+}
+
+
+// a log that cannot be written is an error
+TEST(CheckpointLogTest, constructor_error)
+{   std::string path = make_path("missing") ;
+    std::filesystem::remove(path) ;
+    EXPECT_THROW(ngsai::app::CheckpointLog(path + "/log", "run", false),
+                 std::runtime_error) ;
+}
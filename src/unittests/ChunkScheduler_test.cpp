@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <thread>
+#include <limits>               // std::numeric_limits
+#include <stdexcept>            // std::invalid_argument
+
+#include <applications/ChunkScheduler.hpp>
+
+
+// without limit, each thread gets its own chunks in
+// order and then steals the lowest ones left
+TEST(ChunkSchedulerTest, getNext_own)
+{   ngsai::app::ChunkScheduler scheduler(5, 2) ;
+    size_t no_limit = std::numeric_limits<size_t>::max() ;
+    size_t chunk = 0 ;
+
+    // thread 0 owns 0,2,4 and thread 1 owns 1,3
+    EXPECT_TRUE(scheduler.getNext(0, no_limit, chunk)) ;
+    EXPECT_EQ(chunk, 0) ;
+    EXPECT_TRUE(scheduler.getNext(0, no_limit, chunk)) ;
+    EXPECT_EQ(chunk, 2) ;
+    EXPECT_TRUE(scheduler.getNext(0, no_limit, chunk)) ;
+    EXPECT_EQ(chunk, 4) ;
+    EXPECT_EQ(scheduler.getStealCount(), 0) ;
+
+    // own queue empty, steals from thread 1
+    EXPECT_TRUE(scheduler.getNext(0, no_limit, chunk)) ;
+    EXPECT_EQ(chunk, 1) ;
+    EXPECT_EQ(scheduler.getStealCount(), 1) ;
+
+    EXPECT_TRUE(scheduler.getNext(1, no_limit, chunk)) ;
+    EXPECT_EQ(chunk, 3) ;
+    EXPECT_FALSE(scheduler.getNext(1, no_limit, chunk)) ;
+    EXPECT_FALSE(scheduler.getNext(0, no_limit, chunk)) ;
+}
+
+
+// an own chunk past the limit is exchanged for a lower
+// chunk of another thread
+TEST(ChunkSchedulerTest, getNext_limit)
+{   ngsai::app::ChunkScheduler scheduler(4, 2) ;
+    size_t chunk = 0 ;
+
+    EXPECT_TRUE(scheduler.getNext(0, 10, chunk)) ;
+    EXPECT_EQ(chunk, 0) ;
+    // own next is 2, past the limit, steals 1
+    EXPECT_TRUE(scheduler.getNext(0, 2, chunk)) ;
+    EXPECT_EQ(chunk, 1) ;
+    EXPECT_EQ(scheduler.getStealCount(), 1) ;
+    // own next is 2, nothing lower left, takes it anyway
+    EXPECT_TRUE(scheduler.getNext(0, 2, chunk)) ;
+    EXPECT_EQ(chunk, 2) ;
+    EXPECT_TRUE(scheduler.getNext(1, 0, chunk)) ;
+    EXPECT_EQ(chunk, 3) ;
+}
+
+
+// a resumed run starts at the given chunk
+TEST(ChunkSchedulerTest, constructor_first)
+{   ngsai::app::ChunkScheduler scheduler(3, 6, 2) ;
+    size_t no_limit = std::numeric_limits<size_t>::max() ;
+    std::vector<size_t> chunks ;
+    size_t chunk = 0 ;
+    while(scheduler.getNext(0, no_limit, chunk))
+    {   chunks.push_back(chunk) ; }
+    EXPECT_EQ(chunks, std::vector<size_t>({4, 3, 5})) ;
+}
+
+
+// all chunks are given exactly once to concurrent
+// threads
+TEST(ChunkSchedulerTest, getNext_threads)
+{   size_t n_threads = 4 ;
+    size_t n_chunks  = 10000 ;
+    ngsai::app::ChunkScheduler scheduler(n_chunks, n_threads) ;
+
+    std::vector<std::vector<size_t>> done(n_threads) ;
+    std::vector<std::thread> threads ;
+    for(size_t t=0; t<n_threads; t++)
+    {   threads.emplace_back(
+            [&scheduler, &done, t]()
+            {   size_t chunk = 0 ;
+                while(scheduler.getNext(t, chunk + 8, chunk))
+                {   done[t].push_back(chunk) ; }
+            }) ;
+    }
+    for(auto& thread : threads)
+    {   thread.join() ; }
+
+    std::vector<size_t> counts(n_chunks, 0) ;
+    for(const auto& chunks : done)
+    {   for(size_t chunk : chunks)
+        {   counts[chunk]++ ; }
+    }
+    EXPECT_EQ(counts, std::vector<size_t>(n_chunks, 1)) ;
+}
+
+
+// 0 thread is refused
+TEST(ChunkSchedulerTest, constructor_threads)
+{   EXPECT_THROW(ngsai::app::ChunkScheduler(10, 0),
+                 std::invalid_argument) ;
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <cstdint>
+
+#include <applications/CompactCounts.hpp>
+
+
+// gives access to the 32 bits counts, such that a
+// widening to 64 bits does not need 2^32 increments
+class CompactCounts32 : public ngsai::app::CompactCounts
+{   public:
+        CompactCounts32(size_t size)
+            : CompactCounts(size)
+        {   this->widen() ; }
+
+        void
+        set(size_t i, uint32_t count)
+        {   m_counts_32[i] = count ; }
+} ;
+
+
+// the counts start at 0 on 16 bits
+TEST(CompactCountsTest, constructor)
+{   ngsai::app::CompactCounts counts(5) ;
+    EXPECT_EQ(counts.size(), 5) ;
+    EXPECT_EQ(counts.getWidth(), 16) ;
+    for(size_t i=0; i<counts.size(); i++)
+    {   EXPECT_EQ(counts.get(i), 0) ; }
+}
+
+
+// the vector is widened to 32 bits by the increment
+// that would overflow 16 bits, and only then
+TEST(CompactCountsTest, widen_32)
+{   ngsai::app::CompactCounts counts(3) ;
+    for(size_t n=0; n<3; n++)
+    {   counts.increment(0) ; }
+    for(size_t n=0; n<UINT16_MAX; n++)
+    {   counts.increment(1) ; }
+    EXPECT_EQ(counts.getWidth(), 16) ;
+    EXPECT_EQ(counts.get(1), UINT16_MAX) ;
+
+    counts.increment(1) ;
+    EXPECT_EQ(counts.getWidth(), 32) ;
+    EXPECT_EQ(counts.size(), 3) ;
+    EXPECT_EQ(counts.get(0), 3) ;
+    EXPECT_EQ(counts.get(1), uint64_t(UINT16_MAX) + 1) ;
+    EXPECT_EQ(counts.get(2), 0) ;
+}
+
+
+// the vector is widened to 64 bits by the increment
+// that would overflow 32 bits
+TEST(CompactCountsTest, widen_64)
+{   CompactCounts32 counts(3) ;
+    ASSERT_EQ(counts.getWidth(), 32) ;
+    counts.set(0, 7) ;
+    counts.set(2, UINT32_MAX) ;
+
+    counts.increment(2) ;
+    EXPECT_EQ(counts.getWidth(), 64) ;
+    EXPECT_EQ(counts.size(), 3) ;
+    EXPECT_EQ(counts.get(0), 7) ;
+    EXPECT_EQ(counts.get(1), 0) ;
+    EXPECT_EQ(counts.get(2), uint64_t(UINT32_MAX) + 1) ;
+}
+
+
+// a range of counts is added to the values, whatever
+// the width
+TEST(CompactCountsTest, addTo)
+{   ngsai::app::CompactCounts counts(4) ;
+    counts.increment(1) ;
+    counts.increment(2) ;
+    counts.increment(2) ;
+    std::vector<double> values(2, 1.) ;
+    counts.addTo(1, 2, values.data()) ;
+    EXPECT_EQ(values[0], 2.) ;
+    EXPECT_EQ(values[1], 3.) ;
+
+    for(size_t n=0; n<=UINT16_MAX; n++)
+    {   counts.increment(3) ; }
+    ASSERT_EQ(counts.getWidth(), 32) ;
+    values.assign(2, 0.) ;
+    counts.addTo(2, 2, values.data()) ;
+    EXPECT_EQ(values[0], 2.) ;
+    EXPECT_EQ(values[1], double(UINT16_MAX) + 1.) ;
+}
@@ -0,0 +1,237 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+#include <utility>              // std::pair
+#include <cmath>                // std::log(), std::floor(), std::isinf()
+#include <filesystem>           // std::filesystem::temp_directory_path()
+
+#include <applications/CountTable.hpp>
+#include <applications/KineticTable.hpp>
+
+
+// a histogram based model trained window by window, as
+// the kinetic models are: each factor is a histogram of
+// the signal at one position, or a 2D histogram of the
+// signal at two positions, with nb_bins bins of equal
+// width per axis over [xmin,xmax). Values below xmin
+// fall in the lowest bin, values from xmax in the highest
+struct HistogramModel
+{   HistogramModel(ngsai::app::KineticTable::layouts layout,
+                   size_t size,
+                   size_t nb_bins,
+                   double xmin,
+                   double xmax)
+        : nb_bins(nb_bins),
+          xmin(xmin),
+          xmax(xmax),
+          is_raw(layout == ngsai::app::KineticTable::layouts::raw)
+    {   // raw : each position, diposition : each pair of
+        // consecutive positions, pairwise : each pair of
+        // positions
+        for(size_t i=0; i<size; i++)
+        {   if(is_raw)
+            {   positions.emplace_back(i, i) ; }
+            else if(layout ==
+                    ngsai::app::KineticTable::layouts::diposition)
+            {   if(i+1 < size)
+                {   positions.emplace_back(i, i+1) ; }
+            }
+            else
+            {   for(size_t j=i+1; j<size; j++)
+                {   positions.emplace_back(i, j) ; }
+            }
+        }
+        size_t length = is_raw ? nb_bins : nb_bins*nb_bins ;
+        for(size_t s=0; s<2; s++)
+        {   counts[s].assign(positions.size(),
+                             std::vector<double>(length, 0.)) ;
+        }
+    }
+
+    size_t
+    bin(double x) const
+    {   if(x < xmin)
+        {   return 0 ; }
+        else if(x >= xmax)
+        {   return nb_bins - 1 ; }
+        double width = (xmax - xmin) / nb_bins ;
+        return static_cast<size_t>(std::floor((x - xmin) / width)) ;
+    }
+
+    void
+    add(const std::vector<double>& ipd,
+        const std::vector<double>& pwd)
+    {   const std::vector<double>* signals[2] = {&ipd, &pwd} ;
+        for(size_t s=0; s<2; s++)
+        {   const std::vector<double>& x = *signals[s] ;
+            for(size_t f=0; f<positions.size(); f++)
+            {   size_t b = bin(x[positions[f].first]) ;
+                if(not is_raw)
+                {   b = b*nb_bins + bin(x[positions[f].second]) ; }
+                counts[s][f][b] += 1. ;
+            }
+        }
+    }
+
+    // the values in the order of a KineticTable, IPD
+    // factors first
+    std::vector<double>
+    values() const
+    {   std::vector<double> v ;
+        for(size_t s=0; s<2; s++)
+        {   for(const auto& factor : counts[s])
+            {   v.insert(v.end(), factor.begin(), factor.end()) ; }
+        }
+        return v ;
+    }
+
+    size_t nb_bins ;
+    double xmin ;
+    double xmax ;
+    bool   is_raw ;
+    std::vector<std::pair<size_t,size_t>> positions ;
+    std::vector<std::vector<double>> counts[2] ;
+} ;
+
+
+// synthetic windows with values inside [0,4), on its
+// edges and out of it on both sides. None falls in
+// [2,3), the third of 4 bins, which thus stays empty
+static
+std::vector<std::vector<double>>
+make_windows(size_t n, size_t size)
+{   std::vector<double> values = {-3., -0.5, 0., 0.25, 1., 1.5,
+                                  1.999, 3.75, 4., 4.5, 50.} ;
+    std::vector<std::vector<double>> windows ;
+    size_t k = 0 ;
+    for(size_t i=0; i<n; i++)
+    {   std::vector<double> window ;
+        for(size_t p=0; p<size; p++, k+=7)
+        {   window.push_back(values[(k + i) % values.size()]) ; }
+        windows.push_back(window) ;
+    }
+    return windows ;
+}
+
+
+// trains a count table on the windows, by batches, and
+// returns the path of its saved table
+static
+std::string
+train_table(ngsai::app::KineticTable::layouts layout,
+            ngsai::app::CountTable::storages storage,
+            const std::vector<std::vector<double>>& ipds,
+            const std::vector<std::vector<double>>& pwds,
+            ngsai::app::KineticTable::contents contents,
+            double pseudo_counts,
+            const std::string& name)
+{   ngsai::app::CountTable table(layout,
+                                 ipds.front().size(),
+                                 4,
+                                 0.,
+                                 4.,
+                                 nullptr,
+                                 storage,
+                                 3) ;
+    std::vector<size_t> indices ;
+    for(size_t i=0; i<ipds.size(); i++)
+    {   table.getIndices(ipds[i].data(), pwds[i].data(), indices) ;
+        if(i % 5 == 4)
+        {   table.add(indices) ; }
+    }
+    table.add(indices) ;
+
+    std::string path = (std::filesystem::temp_directory_path() /
+                        ("papet_unittests_" + name + ".bin")).string() ;
+    table.save(path, contents, pseudo_counts, 7) ;
+    return path ;
+}
+
+
+// the counts are those of the model, bin by bin, for
+// each layout and storage, including the values out of
+// the range, clamped to the edge bins, and the bins that
+// no window falls in
+TEST(CountTableTest, counts)
+{   std::vector<std::vector<double>> ipds = make_windows(40, 4) ;
+    std::vector<std::vector<double>> pwds = make_windows(40, 4) ;
+    std::swap(pwds.front(), pwds.back()) ;
+
+    for(auto layout : {ngsai::app::KineticTable::layouts::raw,
+                       ngsai::app::KineticTable::layouts::diposition,
+                       ngsai::app::KineticTable::layouts::pairwise})
+    {   HistogramModel model(layout, 4, 4, 0., 4.) ;
+        for(size_t i=0; i<ipds.size(); i++)
+        {   model.add(ipds[i], pwds[i]) ; }
+        std::vector<double> expected = model.values() ;
+
+        for(auto storage : {ngsai::app::CountTable::storages::dense,
+                            ngsai::app::CountTable::storages::sparse})
+        {   std::string path = train_table(
+                        layout,
+                        storage,
+                        ipds,
+                        pwds,
+                        ngsai::app::KineticTable::contents::counts,
+                        0.,
+                        "count_table") ;
+            ngsai::app::KineticTable table =
+                        ngsai::app::KineticTable::load(path) ;
+            ASSERT_EQ(table.getValueNumber(), expected.size()) ;
+            size_t n_empty = 0 ;
+            for(size_t i=0; i<expected.size(); i++)
+            {   EXPECT_EQ(table.data()[i], expected[i]) ;
+                n_empty += (expected[i] == 0.) ;
+            }
+            // the comparison covers empty bins
+            EXPECT_GT(n_empty, 0) ;
+            std::filesystem::remove(path) ;
+        }
+    }
+}
+
+
+// the log densities are those of the model, empty bins
+// have no density without pseudo counts
+TEST(CountTableTest, log_densities)
+{   std::vector<std::vector<double>> ipds = make_windows(25, 3) ;
+    std::vector<std::vector<double>> pwds = make_windows(25, 3) ;
+    auto layout = ngsai::app::KineticTable::layouts::diposition ;
+    HistogramModel model(layout, 3, 4, 0., 4.) ;
+    for(size_t i=0; i<ipds.size(); i++)
+    {   model.add(ipds[i], pwds[i]) ; }
+    std::vector<double> counts = model.values() ;
+
+    for(double pseudo_counts : {0., 1.})
+    {   std::string path = train_table(
+                    layout,
+                    ngsai::app::CountTable::storages::dense,
+                    ipds,
+                    pwds,
+                    ngsai::app::KineticTable::contents::log_densities,
+                    pseudo_counts,
+                    "count_table_density") ;
+        ngsai::app::KineticTable table =
+                    ngsai::app::KineticTable::load(path) ;
+        size_t length = table.getFactorLength() ;
+        ASSERT_EQ(table.getValueNumber(), counts.size()) ;
+        for(size_t offset=0; offset<counts.size(); offset+=length)
+        {   double total = 0. ;
+            for(size_t i=offset; i<offset+length; i++)
+            {   total += counts[i] + pseudo_counts ; }
+            for(size_t i=offset; i<offset+length; i++)
+            {   double count = counts[i] + pseudo_counts ;
+                if(count == 0.)
+                {   EXPECT_TRUE(std::isinf(table.data()[i]) and
+                                (table.data()[i] < 0.)) ;
+                }
+                else
+                {   EXPECT_DOUBLE_EQ(table.data()[i],
+                                     std::log(count / total)) ;
+                }
+            }
+        }
+        std::filesystem::remove(path) ;
+    }
+}
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <limits>               // std::numeric_limits
+#include <stdexcept>            // std::invalid_argument
+
+#include <applications/CpGTable.hpp>
+
+
+// the chromosomes get ids in order of appearance
+TEST(CpGTableTest, add)
+{   ngsai::app::CpGTable table ;
+    table.add("chr2", 10, 12) ;
+    table.add("chr1", 20, 22) ;
+    table.add("chr2", 30, 32) ;
+
+    EXPECT_EQ(table.size(), 3) ;
+    EXPECT_EQ(table.getChromNumber(), 2) ;
+    EXPECT_EQ(table.getChromId(0), 0) ;
+    EXPECT_EQ(table.getChromId(1), 1) ;
+    EXPECT_EQ(table.getChromId(2), 0) ;
+    EXPECT_EQ(table.getChrom(2), "chr2") ;
+    EXPECT_EQ(table.getChromName(1), "chr1") ;
+    EXPECT_EQ(table.getStart(1), 20) ;
+    EXPECT_EQ(table.getEnd(1), 22) ;
+
+    ngsai::genome::CpGRegion cpg = table.getCpG(2) ;
+    EXPECT_EQ(cpg.chrom, "chr2") ;
+    EXPECT_EQ(cpg.start, 30) ;
+    EXPECT_EQ(cpg.end, 32) ;
+}
+
+
+// the coordinates must fit on 32 bits and be ordered
+TEST(CpGTableTest, add_invalid)
+{   ngsai::app::CpGTable table ;
+    size_t max = std::numeric_limits<uint32_t>::max() ;
+    EXPECT_NO_THROW(table.add("chr1", max - 2, max)) ;
+    EXPECT_THROW(table.add("chr1", max - 1, max + 1),
+                 std::invalid_argument) ;
+    EXPECT_THROW(table.add("chr1", 12, 10),
+                 std::invalid_argument) ;
+    EXPECT_EQ(table.size(), 1) ;
+}
+
+
+TEST(CpGTableTest, clear)
+{   ngsai::app::CpGTable table ;
+    table.add("chr1", 10, 12) ;
+    table.clear() ;
+    EXPECT_EQ(table.size(), 0) ;
+    EXPECT_EQ(table.getChromNumber(), 0) ;
+    table.add("chr3", 10, 12) ;
+    EXPECT_EQ(table.getChromId(0), 0) ;
+}
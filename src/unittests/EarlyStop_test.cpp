@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>            // std::invalid_argument
+
+#include <applications/EarlyStop.hpp>
+
+
+// the state favoured past the threshold
+TEST(EarlyStopTest, getState)
+{   using states = ngsai::app::EarlyStop::states ;
+    EXPECT_EQ(ngsai::app::EarlyStop::getState(0.995, 0.99),
+              states::methylated) ;
+    EXPECT_EQ(ngsai::app::EarlyStop::getState(0.005, 0.99),
+              states::unmethylated) ;
+    EXPECT_EQ(ngsai::app::EarlyStop::getState(0.9, 0.99),
+              states::undecided) ;
+    EXPECT_EQ(ngsai::app::EarlyStop::getState(0.1, 0.99),
+              states::undecided) ;
+    EXPECT_EQ(ngsai::app::EarlyStop::getState(1., 1.),
+              states::methylated) ;
+}
+
+
+// two consecutive boundaries must agree on a state
+TEST(EarlyStopTest, update)
+{   ngsai::app::EarlyStop stop(0.99) ;
+    EXPECT_FALSE(stop.update(0.5)) ;
+    EXPECT_FALSE(stop.update(0.995)) ;
+    EXPECT_TRUE(stop.update(0.999)) ;
+}
+
+
+// confident in opposite states does not stop
+TEST(EarlyStopTest, update_flip)
+{   ngsai::app::EarlyStop stop(0.99) ;
+    EXPECT_FALSE(stop.update(0.995)) ;
+    EXPECT_FALSE(stop.update(0.005)) ;
+    EXPECT_FALSE(stop.update(0.995)) ;
+    EXPECT_TRUE(stop.update(0.998)) ;
+}
+
+
+// an undecided boundary breaks the agreement
+TEST(EarlyStopTest, update_undecided)
+{   ngsai::app::EarlyStop stop(0.99) ;
+    EXPECT_FALSE(stop.update(0.001)) ;
+    EXPECT_FALSE(stop.update(0.5)) ;
+    EXPECT_FALSE(stop.update(0.001)) ;
+    EXPECT_TRUE(stop.update(0.002)) ;
+}
+
+
+// the threshold must belong to (0.5,1]
+TEST(EarlyStopTest, constructor)
+{   EXPECT_THROW(ngsai::app::EarlyStop(0.5), std::invalid_argument) ;
+    EXPECT_THROW(ngsai::app::EarlyStop(1.1), std::invalid_argument) ;
+    EXPECT_NO_THROW(ngsai::app::EarlyStop(1.)) ;
+}
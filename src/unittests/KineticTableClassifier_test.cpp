@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cmath>                // std::log()
+
+#include <ngsaipp/io/BedRecord.hpp>         // ngsai::BedRecord
+#include <ngsaipp/genome/constants.hpp>     // ngsai::genome::strand
+#include <applications/KineticTableClassifier.hpp>
+
+
+// the windows are centered on the C of each strand
+TEST(KineticTableClassifierTest, getWindows)
+{   ngsai::BedRecord cpg("chr1", 100, 102,
+                         ngsai::genome::strand::UNORIENTED) ;
+    std::array<ngsai::BedRecord,2> windows ;
+    size_t n = ngsai::app::KineticTableClassifier::getWindows(
+                                                    cpg,
+                                                    7,
+                                                    windows) ;
+    ASSERT_EQ(n, 2) ;
+    EXPECT_EQ(windows[0].chrom, "chr1") ;
+    EXPECT_EQ(windows[0].start, 97) ;
+    EXPECT_EQ(windows[0].end, 104) ;
+    EXPECT_EQ(windows[0].strand, ngsai::genome::strand::FORWARD) ;
+    EXPECT_EQ(windows[1].start, 98) ;
+    EXPECT_EQ(windows[1].end, 105) ;
+    EXPECT_EQ(windows[1].strand, ngsai::genome::strand::REVERSE) ;
+}
+
+
+// the windows starting before the chromosome are
+// skipped
+TEST(KineticTableClassifierTest, getWindows_edge)
+{   std::array<ngsai::BedRecord,2> windows ;
+    ngsai::BedRecord cpg("chr1", 1, 3,
+                         ngsai::genome::strand::UNORIENTED) ;
+    EXPECT_EQ(ngsai::app::KineticTableClassifier::getWindows(
+                                                    cpg,
+                                                    7,
+                                                    windows), 0) ;
+
+    cpg.start = 2 ;
+    cpg.end   = 4 ;
+    ASSERT_EQ(ngsai::app::KineticTableClassifier::getWindows(
+                                                    cpg,
+                                                    7,
+                                                    windows), 1) ;
+    EXPECT_EQ(windows[0].start, 0) ;
+    EXPECT_EQ(windows[0].end, 7) ;
+    EXPECT_EQ(windows[0].strand, ngsai::genome::strand::REVERSE) ;
+
+    cpg.start = 3 ;
+    cpg.end   = 5 ;
+    ASSERT_EQ(ngsai::app::KineticTableClassifier::getWindows(
+                                                    cpg,
+                                                    7,
+                                                    windows), 2) ;
+    EXPECT_EQ(windows[0].start, 0) ;
+    EXPECT_EQ(windows[0].strand, ngsai::genome::strand::FORWARD) ;
+}
+
+
+// the posterior is normalized and follows the prior
+// when the likelihoods are equal
+TEST(KineticTableClassifierTest, posterior)
+{   auto prob = ngsai::app::KineticTableClassifier::posterior(
+                                            -10., -10., 0.3, 0.7) ;
+    EXPECT_NEAR(prob.first,  0.3, 1e-12) ;
+    EXPECT_NEAR(prob.second, 0.7, 1e-12) ;
+
+    prob = ngsai::app::KineticTableClassifier::posterior(
+                                    -1000., -1000. - std::log(3.),
+                                    0.5, 0.5) ;
+    EXPECT_NEAR(prob.first,  0.75, 1e-12) ;
+    EXPECT_NEAR(prob.second, 0.25, 1e-12) ;
+}
@@ -0,0 +1,277 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <fstream>
+#include <filesystem>           // std::filesystem::temp_directory_path(), std::filesystem::resize_file()
+#include <limits>               // std::numeric_limits
+#include <vector>
+#include <cmath>                // std::log()
+#include <cstdint>
+#include <stdexcept>            // std::invalid_argument, std::runtime_error
+
+#include <applications/KineticTable.hpp>
+
+
+// a raw signal table of 3 positions and 4 bins
+static
+ngsai::app::KineticTable
+make_table(double first_value)
+{   ngsai::app::KineticTable table(
+                    ngsai::app::KineticTable::layouts::raw,
+                    3,
+                    4,
+                    0.,
+                    4.,
+                    nullptr) ;
+    double* values = table.data() ;
+    for(size_t i=0; i<table.getValueNumber(); i++)
+    {   values[i] = first_value + i ; }
+    return table ;
+}
+
+
+// a path in the temporary directory
+static
+std::string
+make_path(const std::string& name)
+{   return (std::filesystem::temp_directory_path() /
+            ("papet_unittests_" + name +
+             ngsai::app::KineticTable::extension)).string() ;
+}
+
+
+TEST(KineticTableTest, constructor)
+{   ngsai::app::KineticTable table = make_table(0.) ;
+    EXPECT_EQ(table.size(), 3) ;
+    EXPECT_EQ(table.getBinNumber(), 4) ;
+    EXPECT_EQ(table.getFactorNumber(), 3) ;
+    EXPECT_EQ(table.getFactorLength(), 4) ;
+    // IPD and PWD
+    EXPECT_EQ(table.getValueNumber(), 2*3*4) ;
+    EXPECT_FALSE(table.isNormalized()) ;
+}
+
+
+// the values beyond the range go to the edge bins
+TEST(KineticTableTest, getBin)
+{   ngsai::app::KineticTable table = make_table(0.) ;
+    EXPECT_EQ(table.getBin(-1.), 0) ;
+    EXPECT_EQ(table.getBin(0.5), 0) ;
+    EXPECT_EQ(table.getBin(1.5), 1) ;
+    EXPECT_EQ(table.getBin(3.5), 3) ;
+    EXPECT_EQ(table.getBin(10.), 3) ;
+    EXPECT_EQ(table.getBin(std::numeric_limits<double>::quiet_NaN()), 0) ;
+}
+
+
+TEST(KineticTableTest, difference)
+{   ngsai::app::KineticTable table_a = make_table(1.) ;
+    ngsai::app::KineticTable table_b = make_table(0.) ;
+    double inf = std::numeric_limits<double>::infinity() ;
+    // empty in both, empty in a only, empty in b only
+    table_a.data()[0] = -inf ;
+    table_b.data()[0] = -inf ;
+    table_a.data()[1] = -inf ;
+    table_b.data()[2] = -inf ;
+
+    ngsai::app::KineticTable table =
+        ngsai::app::KineticTable::difference(table_a, table_b) ;
+    const double* values = table.data() ;
+    EXPECT_EQ(values[0], 0.) ;
+    EXPECT_EQ(values[1], -inf) ;
+    EXPECT_EQ(values[2], inf) ;
+    for(size_t i=3; i<table.getValueNumber(); i++)
+    {   EXPECT_EQ(values[i], 1.) ; }
+}
+
+
+TEST(KineticTableTest, difference_incompatible)
+{   ngsai::app::KineticTable table_a = make_table(0.) ;
+    ngsai::app::KineticTable table_b(
+                    ngsai::app::KineticTable::layouts::raw,
+                    3,
+                    5,
+                    0.,
+                    4.,
+                    nullptr) ;
+    EXPECT_THROW(ngsai::app::KineticTable::difference(table_a,
+                                                      table_b),
+                 std::invalid_argument) ;
+}
+
+
+// a saved table is loaded with the same values
+TEST(KineticTableTest, save_load)
+{   std::string path = make_path("save_load") ;
+    ngsai::app::KineticTable table = make_table(-10.) ;
+    table.save(path) ;
+
+    ngsai::app::KineticTable loaded =
+                    ngsai::app::KineticTable::load(path) ;
+    EXPECT_TRUE(loaded.isMapped()) ;
+    EXPECT_TRUE(loaded.isCompatible(table)) ;
+    EXPECT_EQ(loaded.getContents(), table.getContents()) ;
+    ASSERT_EQ(loaded.getValueNumber(), table.getValueNumber()) ;
+    for(size_t i=0; i<table.getValueNumber(); i++)
+    {   EXPECT_EQ(loaded.data()[i], table.data()[i]) ; }
+    std::filesystem::remove(path) ;
+}
+
+
+// a truncated file is refused
+TEST(KineticTableTest, load_truncated)
+{   std::string path = make_path("load_truncated") ;
+    make_table(0.).save(path) ;
+    std::filesystem::resize_file(
+                    path,
+                    std::filesystem::file_size(path) - 8) ;
+    EXPECT_THROW(ngsai::app::KineticTable::load(path),
+                 std::runtime_error) ;
+    std::filesystem::remove(path) ;
+}
+
+
+// a header announcing a huge table is refused before
+// anything is allocated
+TEST(KineticTableTest, load_header_size)
+{   std::string path = make_path("load_header_size") ;
+    make_table(0.).save(path) ;
+
+    // the window size field follows the magic number
+    // and 4 32 bits fields
+    for(uint64_t size : {uint64_t(1) << 31,
+                         std::numeric_limits<uint64_t>::max()})
+    {   std::fstream file(path,
+                          std::ios::in |
+                          std::ios::out |
+                          std::ios::binary) ;
+        file.seekp(24) ;
+        file.write(reinterpret_cast<const char*>(&size),
+                   sizeof(size)) ;
+        file.close() ;
+        EXPECT_THROW(ngsai::app::KineticTable::load(path),
+                     std::runtime_error) ;
+    }
+    std::filesystem::remove(path) ;
+}
+
+
+// the table sizes cannot overflow
+TEST(KineticTableTest, constructor_overflow)
+{   EXPECT_THROW(ngsai::app::KineticTable(
+                    ngsai::app::KineticTable::layouts::pairwise,
+                    size_t(1) << 33,
+                    size_t(1) << 20,
+                    0.,
+                    1.,
+                    nullptr),
+                 std::invalid_argument) ;
+}
+
+
+// the counts are summed by chunks smaller than the
+// tables
+TEST(KineticTableTest, sum_counts)
+{   std::vector<std::string> paths = {make_path("sum_counts_a"),
+                                      make_path("sum_counts_b")} ;
+    std::string path_out = make_path("sum_counts_out") ;
+    for(size_t i=0; i<paths.size(); i++)
+    {   ngsai::app::KineticTable table = make_table(i) ;
+        table.setContents(ngsai::app::KineticTable::contents::counts) ;
+        table.save(paths[i]) ;
+    }
+
+    ngsai::app::KineticTable::sum(
+                    paths,
+                    path_out,
+                    ngsai::app::KineticTable::contents::counts,
+                    0.,
+                    5) ;
+    ngsai::app::KineticTable sum =
+                    ngsai::app::KineticTable::load(path_out) ;
+    EXPECT_EQ(sum.getContents(),
+              ngsai::app::KineticTable::contents::counts) ;
+    ASSERT_EQ(sum.getValueNumber(), 2*3*4) ;
+    for(size_t i=0; i<sum.getValueNumber(); i++)
+    {   EXPECT_EQ(sum.data()[i], 2.*i + 1.) ; }
+
+    for(const auto& path : paths)
+    {   std::filesystem::remove(path) ; }
+    std::filesystem::remove(path_out) ;
+}
+
+
+// the log densities of the sum include the pseudo
+// counts once
+TEST(KineticTableTest, sum_log_densities)
+{   std::vector<std::string> paths = {make_path("sum_dens_a"),
+                                      make_path("sum_dens_b")} ;
+    std::string path_out = make_path("sum_dens_out") ;
+    for(const auto& path : paths)
+    {   ngsai::app::KineticTable table = make_table(0.) ;
+        table.setContents(ngsai::app::KineticTable::contents::counts) ;
+        table.save(path) ;
+    }
+
+    double pseudo_counts = 1. ;
+    ngsai::app::KineticTable::sum(
+                    paths,
+                    path_out,
+                    ngsai::app::KineticTable::contents::log_densities,
+                    pseudo_counts,
+                    7) ;
+    ngsai::app::KineticTable sum =
+                    ngsai::app::KineticTable::load(path_out) ;
+    EXPECT_EQ(sum.getContents(),
+              ngsai::app::KineticTable::contents::log_densities) ;
+    size_t length = sum.getFactorLength() ;
+    for(size_t offset=0; offset<sum.getValueNumber(); offset+=length)
+    {   double total = 0. ;
+        for(size_t i=offset; i<offset+length; i++)
+        {   total += 2.*i + pseudo_counts ; }
+        for(size_t i=offset; i<offset+length; i++)
+        {   EXPECT_DOUBLE_EQ(sum.data()[i],
+                             std::log((2.*i + pseudo_counts) / total)) ;
+        }
+    }
+
+    for(const auto& path : paths)
+    {   std::filesystem::remove(path) ; }
+    std::filesystem::remove(path_out) ;
+}
+
+
+// only compatible tables of counts are summed
+TEST(KineticTableTest, sum_invalid)
+{   std::string path_counts = make_path("sum_invalid_counts") ;
+    std::string path_dens   = make_path("sum_invalid_dens") ;
+    std::string path_bins   = make_path("sum_invalid_bins") ;
+    std::string path_out    = make_path("sum_invalid_out") ;
+    ngsai::app::KineticTable table = make_table(0.) ;
+    table.save(path_dens) ;
+    table.setContents(ngsai::app::KineticTable::contents::counts) ;
+    table.save(path_counts) ;
+    ngsai::app::KineticTable table_bins(
+                    ngsai::app::KineticTable::layouts::raw,
+                    3,
+                    5,
+                    0.,
+                    4.,
+                    nullptr) ;
+    table_bins.setContents(ngsai::app::KineticTable::contents::counts) ;
+    table_bins.save(path_bins) ;
+
+    auto contents = ngsai::app::KineticTable::contents::counts ;
+    EXPECT_THROW(ngsai::app::KineticTable::sum(
+                    {}, path_out, contents, 0., 5),
+                 std::invalid_argument) ;
+    EXPECT_THROW(ngsai::app::KineticTable::sum(
+                    {path_counts, path_dens}, path_out, contents, 0., 5),
+                 std::invalid_argument) ;
+    EXPECT_THROW(ngsai::app::KineticTable::sum(
+                    {path_counts, path_bins}, path_out, contents, 0., 5),
+                 std::invalid_argument) ;
+
+    for(const auto& path : {path_counts, path_dens, path_bins, path_out})
+    {   std::filesystem::remove(path) ; }
+}
@@ -0,0 +1,26 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <filesystem>           // std::filesystem::temp_directory_path()
+
+#include <applications/Profiler.hpp>
+
+
+// the command is escaped in the JSON report
+TEST(ProfilerTest, writeReport_command)
+{   std::string path = (std::filesystem::temp_directory_path() /
+                        "papet_unittests_profile.json").string() ;
+    ngsai::app::Profiler::getInstance().writeReport(
+                            path,
+                            "papet predict --bed \"a b\\c.bed\"\t\x01") ;
+    std::ifstream file(path) ;
+    std::ostringstream contents ;
+    contents << file.rdbuf() ;
+    EXPECT_NE(contents.str().find(
+                "\"command\": \"papet predict --bed "
+                "\\\"a b\\\\c.bed\\\"\\t\\u0001\""),
+              std::string::npos) ;
+    std::filesystem::remove(path) ;
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include <thread>
+#include <fstream>
+#include <filesystem>           // std::filesystem::temp_directory_path()
+#include <stdexcept>            // std::invalid_argument
+
+#include <applications/ReorderBuffer.hpp>
+#include <applications/CheckpointLog.hpp>
+
+
+// the chunks are written in their index order
+TEST(ReorderBufferTest, push_order)
+{   std::ostringstream stream ;
+    ngsai::app::ReorderBuffer buffer(stream, 4) ;
+
+    buffer.push(2, "c") ;
+    buffer.push(1, "b") ;
+    EXPECT_EQ(stream.str(), "") ;
+    EXPECT_EQ(buffer.getNextIndex(), 0) ;
+
+    buffer.push(0, "a") ;
+    EXPECT_EQ(stream.str(), "abc") ;
+    EXPECT_EQ(buffer.getNextIndex(), 3) ;
+
+    buffer.push(3, "d") ;
+    EXPECT_EQ(stream.str(), "abcd") ;
+    EXPECT_EQ(buffer.getNextIndex(), 4) ;
+}
+
+
+// a resumed buffer starts at the given chunk
+TEST(ReorderBufferTest, push_first)
+{   std::ostringstream stream ;
+    ngsai::app::ReorderBuffer buffer(stream, 2, 5, 10, nullptr) ;
+
+    buffer.push(6, "g") ;
+    EXPECT_EQ(stream.str(), "") ;
+    buffer.push(5, "f") ;
+    EXPECT_EQ(stream.str(), "fg") ;
+    EXPECT_EQ(buffer.getNextIndex(), 7) ;
+}
+
+
+// several threads pushing in any order, with a
+// capacity smaller than the number of chunks
+TEST(ReorderBufferTest, push_threads)
+{   size_t n_threads = 4 ;
+    size_t n_chunks  = 1000 ;
+    std::ostringstream stream ;
+    ngsai::app::ReorderBuffer buffer(stream, 2*n_threads) ;
+
+    std::vector<std::thread> threads ;
+    for(size_t t=0; t<n_threads; t++)
+    {   threads.emplace_back(
+            [&buffer, t, n_threads, n_chunks]()
+            {   for(size_t i=t; i<n_chunks; i+=n_threads)
+                {   buffer.push(i, std::to_string(i) + "\n") ; }
+            }) ;
+    }
+    for(auto& thread : threads)
+    {   thread.join() ; }
+
+    std::ostringstream expected ;
+    for(size_t i=0; i<n_chunks; i++)
+    {   expected << i << "\n" ; }
+    EXPECT_EQ(stream.str(), expected.str()) ;
+    EXPECT_EQ(buffer.getNextIndex(), n_chunks) ;
+}
+
+
+// a capacity of 0 is refused
+TEST(ReorderBufferTest, constructor_capacity)
+{   std::ostringstream stream ;
+    EXPECT_THROW(ngsai::app::ReorderBuffer(stream, 0),
+                 std::invalid_argument) ;
+}
+
+
+// a failed stream is recorded and nothing more is logged
+TEST(ReorderBufferTest, push_failed)
+{   std::string path = (std::filesystem::temp_directory_path() /
+                        "papet_unittests_buffer.ckpt").string() ;
+    std::ostringstream stream ;
+    {   ngsai::app::CheckpointLog log(path, "run", false) ;
+        ngsai::app::ReorderBuffer buffer(stream, 2, 0, 0, &log) ;
+
+        buffer.push(0, "a") ;
+        EXPECT_FALSE(buffer.hasFailed()) ;
+        stream.setstate(std::ios::badbit) ;
+        buffer.push(1, "b") ;
+        EXPECT_TRUE(buffer.hasFailed()) ;
+        EXPECT_NE(buffer.getError(), "") ;
+        stream.clear() ;
+        buffer.push(2, "c") ;
+        EXPECT_TRUE(buffer.hasFailed()) ;
+    }
+    std::ifstream file(path) ;
+    std::ostringstream contents ;
+    contents << file.rdbuf() ;
+    EXPECT_EQ(contents.str(), "run\n1 1\n") ;
+    std::filesystem::remove(path) ;
+}
+
+
+// aborting releases a blocked thread, discards the
+// following chunks and keeps the first failure
+TEST(ReorderBufferTest, abort)
+{   std::ostringstream stream ;
+    ngsai::app::ReorderBuffer buffer(stream, 1) ;
+
+    buffer.push(0, "a") ;
+    std::thread thread([&buffer]() { buffer.push(2, "c") ; }) ;
+    buffer.abort("chunk 1 failed") ;
+    thread.join() ;
+    buffer.push(1, "b") ;
+    buffer.abort("other") ;
+
+    EXPECT_EQ(stream.str(), "a") ;
+    EXPECT_TRUE(buffer.hasFailed()) ;
+    EXPECT_EQ(buffer.getError(), "chunk 1 failed") ;
+}
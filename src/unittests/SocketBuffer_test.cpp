@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <iostream>
+#include <cerrno>               // EAGAIN, EWOULDBLOCK
+#include <unistd.h>             // close()
+#include <sys/socket.h>         // socketpair(), setsockopt()
+#include <sys/time.h>           // timeval
+
+#include <applications/SocketBuffer.hpp>
+
+
+// lines written on one end are read on the other, and
+// the peer closing its end is not a failure
+TEST(SocketBufferTest, read_write)
+{   int fds[2] ;
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0) ;
+    {   ngsai::app::SocketBuffer buffer(fds[0]) ;
+        std::ostream stream(&buffer) ;
+        stream << "chr1\t10\t12\n" << "chr2\t5\t7\n" ;
+        stream.flush() ;
+        EXPECT_FALSE(buffer.hasFailed()) ;
+    }
+    close(fds[0]) ;
+
+    ngsai::app::SocketBuffer buffer(fds[1]) ;
+    std::istream stream(&buffer) ;
+    std::string line ;
+    ASSERT_TRUE(std::getline(stream, line)) ;
+    EXPECT_EQ(line, "chr1\t10\t12") ;
+    ASSERT_TRUE(std::getline(stream, line)) ;
+    EXPECT_EQ(line, "chr2\t5\t7") ;
+    EXPECT_FALSE(std::getline(stream, line)) ;
+    EXPECT_FALSE(buffer.hasFailed()) ;
+    EXPECT_EQ(buffer.getErrno(), 0) ;
+    close(fds[1]) ;
+}
+
+
+// a read timeout is a failure and its errno is kept
+TEST(SocketBufferTest, timeout)
+{   int fds[2] ;
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0) ;
+    struct timeval timeout ;
+    timeout.tv_sec  = 0 ;
+    timeout.tv_usec = 10000 ;
+    ASSERT_EQ(setsockopt(fds[1],
+                         SOL_SOCKET,
+                         SO_RCVTIMEO,
+                         &timeout,
+                         sizeof(timeout)), 0) ;
+
+    ngsai::app::SocketBuffer buffer(fds[1]) ;
+    std::istream stream(&buffer) ;
+    std::string line ;
+    EXPECT_FALSE(std::getline(stream, line)) ;
+    EXPECT_TRUE(buffer.hasFailed()) ;
+    EXPECT_TRUE((buffer.getErrno() == EAGAIN) or
+                (buffer.getErrno() == EWOULDBLOCK)) ;
+    close(fds[0]) ;
+    close(fds[1]) ;
+}
+
+
+// writing to a closed peer is a failure, without SIGPIPE
+TEST(SocketBufferTest, write_closed)
+{   int fds[2] ;
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0) ;
+    close(fds[1]) ;
+
+    ngsai::app::SocketBuffer buffer(fds[0]) ;
+    std::ostream stream(&buffer) ;
+    stream << "chr1\t10\t12\n" ;
+    stream.flush() ;
+    EXPECT_TRUE(buffer.hasFailed()) ;
+    EXPECT_EQ(buffer.getErrno(), EPIPE) ;
+    close(fds[0]) ;
+}
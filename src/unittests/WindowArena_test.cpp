@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <cstdint>
+
+#include <applications/WindowArena.hpp>
+
+
+// adds n CCSs to an arena, each marked with its index, 
+// and returns the indices of the CCSs kept in order
+static
+std::vector<size_t>
+add_ccss(ngsai::app::WindowArena& arena, size_t n)
+{   for(size_t i=0; i<n; i++)
+    {   size_t slot = 0 ;
+        if(arena.addCcs(slot))
+        {   arena.getIPD(slot, 0)[0] = i ;
+            arena.setWindowNumber(slot, 1) ;
+        }
+    }
+    std::vector<size_t> kept ;
+    for(size_t slot : arena.getOrder())
+    {   kept.push_back(arena.getIPD(slot, 0)[0]) ; }
+    return kept ;
+}
+
+
+// without a limit, all the CCSs are kept in order
+TEST(WindowArenaTest, addCcs)
+{   ngsai::app::WindowArena arena ;
+    arena.reset(3, 0, 1) ;
+    EXPECT_EQ(add_ccss(arena, 5), 
+              std::vector<size_t>({0, 1, 2, 3, 4})) ;
+    EXPECT_EQ(arena.getSlotNumber(), 5) ;
+
+    // the memory is reused for the next CpG
+    arena.reset(3, 0, 1) ;
+    EXPECT_EQ(arena.getSlotNumber(), 0) ;
+    EXPECT_EQ(add_ccss(arena, 2), 
+              std::vector<size_t>({0, 1})) ;
+}
+
+
+// the reservoir keeps a sorted subsample, the same for 
+// the same seed
+TEST(WindowArenaTest, sample)
+{   std::vector<size_t> kept = 
+                ngsai::app::WindowArena::sample(100, 10, 7) ;
+    ASSERT_EQ(kept.size(), 10) ;
+    for(size_t i=1; i<kept.size(); i++)
+    {   EXPECT_LT(kept[i-1], kept[i]) ; }
+    EXPECT_LT(kept.back(), 100) ;
+    EXPECT_EQ(ngsai::app::WindowArena::sample(100, 10, 7), kept) ;
+    EXPECT_NE(ngsai::app::WindowArena::sample(100, 10, 8), kept) ;
+
+    // no subsampling under the limit
+    EXPECT_EQ(ngsai::app::WindowArena::sample(3, 10, 7),
+              std::vector<size_t>({0, 1, 2})) ;
+    EXPECT_EQ(ngsai::app::WindowArena::sample(3, 0, 7),
+              std::vector<size_t>({0, 1, 2})) ;
+}
+
+
+// the list and the arena reservoirs keep the same CCSs
+TEST(WindowArenaTest, sample_arena)
+{   for(uint32_t seed=0; seed<20; seed++)
+    {   ngsai::app::WindowArena arena ;
+        arena.reset(3, 4, seed) ;
+        EXPECT_EQ(add_ccss(arena, 30),
+                  ngsai::app::WindowArena::sample(30, 4, seed)) ;
+    }
+}
+
+
+// each CCS is kept with the same probability
+TEST(WindowArenaTest, sample_uniform)
+{   size_t n      = 20 ;
+    size_t k      = 5 ;
+    size_t n_runs = 20000 ;
+    std::vector<size_t> counts(n, 0) ;
+    for(uint32_t seed=0; seed<n_runs; seed++)
+    {   for(size_t i : ngsai::app::WindowArena::sample(n, k, seed))
+        {   counts[i]++ ; }
+    }
+    // expected n_runs*k/n = 5000, sd ~61
+    for(size_t i=0; i<n; i++)
+    {   EXPECT_NEAR(counts[i], n_runs * k / n, 400) ; }
+}
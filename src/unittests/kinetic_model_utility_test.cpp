@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <stdexcept>            // std::invalid_argument
+
+#include <applications/kinetic_model_utility.hpp>
+
+
+// a histogram with a flat vector of counts
+struct Histogram1D
+{   size_t getBinNumber() const
+    {   return counts.size() ; }
+
+    double getLowerBound() const
+    {   return 0. ; }
+
+    double getUpperBound() const
+    {   return 1. ; }
+
+    const std::vector<double>& getCounts() const
+    {   return counts ; }
+
+    std::vector<double> counts ;
+} ;
+
+
+// a histogram with a matrix of counts
+struct Histogram2D
+{   size_t getBinNumber() const
+    {   return counts.size() ; }
+
+    double getLowerBound() const
+    {   return 0. ; }
+
+    double getUpperBound() const
+    {   return 1. ; }
+
+    const std::vector<std::vector<double>>& getCounts() const
+    {   return counts ; }
+
+    std::vector<std::vector<double>> counts ;
+} ;
+
+
+// a model giving access to its histograms
+template<class H>
+struct Model
+{   size_t size() const
+    {   return 1 ; }
+
+    const std::vector<H>& getHistogramsIPD() const
+    {   return hists ; }
+
+    const std::vector<H>& getHistogramsPWD() const
+    {   return hists ; }
+
+    std::vector<H> hists ;
+} ;
+
+
+// a model not giving access to anything
+struct Opaque
+{   size_t size() const
+    {   return 1 ; }
+} ;
+
+
+// only the models with flat histograms are read
+TEST(kinetic_model_utilityTest, has_histograms)
+{   EXPECT_TRUE(ngsai::app::has_histograms<Model<Histogram1D>>::value) ;
+    EXPECT_FALSE(ngsai::app::has_histograms<Model<Histogram2D>>::value) ;
+    EXPECT_FALSE(ngsai::app::has_histograms<Opaque>::value) ;
+}
+
+
+// the KmerMap of a model without one cannot be read
+TEST(kinetic_model_utilityTest, get_kmermap)
+{   EXPECT_FALSE(ngsai::app::has_kmermap<Opaque>::value) ;
+    EXPECT_THROW(ngsai::app::get_kmermap(Opaque()),
+                 std::invalid_argument) ;
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <cstdint>
+
+#include <applications/utilities.hpp>
+#include <applications/WindowArena.hpp>
+
+
+// a record as returned by a BAM reader, identified by its
+// position in the file
+struct Record
+{   int32_t ReferenceStart() const
+    {   return start ; }
+
+    int32_t ReferenceEnd() const
+    {   return end ; }
+
+    int32_t start ;
+    int32_t end ;
+    size_t  id ;
+} ;
+
+
+// records in file order, many starting at the same
+// position
+static
+std::vector<Record>
+make_records()
+{   std::vector<Record> records ;
+    size_t id = 0 ;
+    for(int32_t start=0; start<100; start+=10)
+    {   for(size_t n=0; n<20; n++, id++)
+        {   int32_t end = start + 15 + (id % 7) * 5 ;
+            records.push_back(Record{start, end, id}) ;
+        }
+    }
+    return records ;
+}
+
+
+// the ids of the records kept for a CpG out of the records
+// overlapping it, in order
+static
+std::vector<size_t>
+subsample(const std::vector<Record>& records,
+          const std::vector<size_t>& overlapping,
+          size_t max_depth,
+          uint32_t seed)
+{   std::vector<size_t> ids ;
+    for(size_t i : ngsai::app::WindowArena::sample(overlapping.size(),
+                                                    max_depth,
+                                                    seed))
+    {   ids.push_back(records[overlapping[i]].id) ; }
+    return ids ;
+}
+
+
+// records starting at the same position keep their order
+TEST(utilitiesTest, sort_by_start)
+{   std::vector<Record> records ;
+    for(size_t i=0; i<50; i++)
+    {   int32_t start = (i % 2) ? 5 : 3 ;
+        records.push_back(Record{start, start + 1, i}) ;
+    }
+    ngsai::app::sort_by_start(records) ;
+
+    for(size_t i=0; i<records.size(); i++)
+    {   EXPECT_EQ(records[i].start, (i < 25) ? 3 : 5) ;
+        if((i > 0) and (records[i].start == records[i-1].start))
+        {   EXPECT_LT(records[i-1].id, records[i].id) ; }
+    }
+}
+
+
+// the records overlapping each region are found, in order
+TEST(utilitiesTest, sweep_records)
+{   std::vector<Record> records = make_records() ;
+    ngsai::app::sort_by_start(records) ;
+
+    std::vector<size_t> active ;
+    size_t next = 0 ;
+    for(int32_t start=0; start<120; start+=3)
+    {   int32_t end = start + 2 ;
+        ngsai::app::sweep_records(records, start, end, next, active) ;
+
+        std::vector<size_t> expected ;
+        for(size_t j=0; j<records.size(); j++)
+        {   if((records[j].start < end) and
+               (records[j].end > start))
+            {   expected.push_back(j) ; }
+        }
+        EXPECT_EQ(active, expected) ;
+    }
+}
+
+
+// fetching the CpGs one by one (--merge -1) or all at
+// once (--merge N) keeps the same CCSs with --maxDepth
+TEST(utilitiesTest, merge_max_depth)
+{   std::vector<Record> records = make_records() ;
+    size_t max_depth = 5 ;
+
+    // the records fetched over all the CpGs at once
+    std::vector<Record> merged = records ;
+    ngsai::app::sort_by_start(merged) ;
+    std::vector<size_t> active ;
+    size_t next = 0 ;
+
+    for(int32_t start=0; start<120; start+=4)
+    {   int32_t end   = start + 2 ;
+        uint32_t seed = static_cast<uint32_t>(start) ;
+
+        // a single CpG, the reader order
+        std::vector<size_t> single ;
+        for(size_t j=0; j<records.size(); j++)
+        {   if((records[j].start < end) and
+               (records[j].end > start))
+            {   single.push_back(j) ; }
+        }
+
+        ngsai::app::sweep_records(merged, start, end, next, active) ;
+        ASSERT_EQ(active.size(), single.size()) ;
+        EXPECT_EQ(subsample(merged,  active, max_depth, seed),
+                  subsample(records, single, max_depth, seed)) ;
+    }
+}